@@ -32,6 +32,25 @@ public enum CapturePriority
     Low = 2,
 }
 
+public enum OccludedWindowCapturePolicy
+{
+    Capture = 0,
+    Deprioritize = 1,
+    Skip = 2,
+}
+
+public enum PipelineStage
+{
+    Enumerate = 0,
+    CaptureByPrintWindow = 1,
+    CaptureByBitBlt = 2,
+    CaptureByWindowsGraphicsCapture = 3,
+    GetDIBits = 4,
+    Upload = 5,
+    Render = 6,
+    GetPixels = 7,
+}
+
 public enum MessageType
 {
     None = -1,
@@ -41,6 +60,8 @@ public enum MessageType
     WindowSizeChanged = 3,
     IconCaptured = 4,
     CursorCaptured = 5,
+    WindowMoved = 6,
+    WindowZOrderChanged = 7,
     Error = 1000,
     TextureNullError = 1001,
     TextureSizeError = 1002,
@@ -66,6 +87,144 @@ public struct Point
     public int y;
 }
 
+[StructLayout(LayoutKind.Sequential)]
+public struct WindowRect
+{
+    [MarshalAs(UnmanagedType.I4)]
+    public int left;
+    [MarshalAs(UnmanagedType.I4)]
+    public int top;
+    [MarshalAs(UnmanagedType.I4)]
+    public int right;
+    [MarshalAs(UnmanagedType.I4)]
+    public int bottom;
+}
+
+[StructLayout(LayoutKind.Sequential)]
+public struct WindowListStats
+{
+    [MarshalAs(UnmanagedType.U4)]
+    public uint passCount;
+    [MarshalAs(UnmanagedType.U4)]
+    public uint idlePassCount;
+    [MarshalAs(UnmanagedType.U4)]
+    public uint addedCount;
+    [MarshalAs(UnmanagedType.U4)]
+    public uint removedCount;
+    [MarshalAs(UnmanagedType.U4)]
+    public uint changedCount;
+    [MarshalAs(UnmanagedType.R4)]
+    public float interval;
+    [MarshalAs(UnmanagedType.R4)]
+    public float lastPassTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float averagePassTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float maxPassTime;
+}
+
+[StructLayout(LayoutKind.Sequential)]
+public struct IdleReleaseStats
+{
+    [MarshalAs(UnmanagedType.U4)]
+    public uint releaseCount;
+    [MarshalAs(UnmanagedType.U4)]
+    public uint textureReleaseCount;
+    [MarshalAs(UnmanagedType.U8)]
+    public ulong releasedBytes;
+}
+
+[StructLayout(LayoutKind.Sequential)]
+public struct LatencyStats
+{
+    [MarshalAs(UnmanagedType.U4)]
+    public uint count;
+    [MarshalAs(UnmanagedType.R4)]
+    public float p50Time;
+    [MarshalAs(UnmanagedType.R4)]
+    public float p90Time;
+    [MarshalAs(UnmanagedType.R4)]
+    public float p99Time;
+    [MarshalAs(UnmanagedType.R4)]
+    public float maxTime;
+}
+
+[StructLayout(LayoutKind.Sequential)]
+public struct FrameLatencyStats
+{
+    [MarshalAs(UnmanagedType.U4)]
+    public uint frameCount;
+    [MarshalAs(UnmanagedType.R4)]
+    public float p50CaptureToRenderTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float p99CaptureToRenderTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float p50CaptureIntervalTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float captureIntervalJitter;
+    [MarshalAs(UnmanagedType.R4)]
+    public float lastCaptureTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float lastUploadTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float lastRenderTime;
+    [MarshalAs(UnmanagedType.U4)]
+    public uint resizedFrameCount;
+    [MarshalAs(UnmanagedType.R4)]
+    public float lastResizedCaptureToRenderTime;
+}
+
+[StructLayout(LayoutKind.Sequential)]
+public struct LockStats
+{
+    [MarshalAs(UnmanagedType.U8)]
+    public ulong acquisitionCount;
+    [MarshalAs(UnmanagedType.U8)]
+    public ulong contendedCount;
+    [MarshalAs(UnmanagedType.R4)]
+    public float totalWaitTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float maxWaitTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float totalHoldTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float maxHoldTime;
+}
+
+[StructLayout(LayoutKind.Sequential)]
+public struct ThreadLoopStats
+{
+    [MarshalAs(UnmanagedType.U8)]
+    public ulong iterationCount;
+    [MarshalAs(UnmanagedType.U8)]
+    public ulong workedIterationCount;
+    [MarshalAs(UnmanagedType.U8)]
+    public ulong idleIterationCount;
+    [MarshalAs(UnmanagedType.R4)]
+    public float runningTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float loopTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float cpuTime;
+}
+
+[StructLayout(LayoutKind.Sequential)]
+public struct CaptureStallStats
+{
+    [MarshalAs(UnmanagedType.U4)]
+    public uint stallCount;
+    [MarshalAs(UnmanagedType.U4)]
+    public uint quarantinedWindowCount;
+    [MarshalAs(UnmanagedType.U4)]
+    public uint stuckWorkerCount;
+    [MarshalAs(UnmanagedType.R4)]
+    public float lastStallTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float maxStallTime;
+    [MarshalAs(UnmanagedType.R4)]
+    public float totalStallTime;
+}
+
 public static class Lib
 {
     public const string name = "uWindowCapture";
@@ -86,6 +245,12 @@ public static class Lib
     public static extern void SetLogFunc(DebugLogDelegate func);
     [DllImport(name, EntryPoint = "UwcSetErrorFunc")]
     public static extern void SetErrorFunc(DebugLogDelegate func);
+    [DllImport(name, EntryPoint = "UwcSetSyntheticWindowBackend")]
+    public static extern void SetSyntheticWindowBackend(uint windowCount, uint width, uint height, uint churnInterval);
+    [DllImport(name, EntryPoint = "UwcSetHeadless")]
+    public static extern void SetHeadless(bool isHeadless);
+    [DllImport(name, EntryPoint = "UwcIsHeadless")]
+    public static extern bool IsHeadless();
     [DllImport(name, EntryPoint = "UwcGetRenderEventFunc")]
     public static extern IntPtr GetRenderEventFunc();
     [DllImport(name, EntryPoint = "UwcUpdate")]
@@ -120,6 +285,36 @@ public static class Lib
     public static extern void RequestCaptureWindow(int id, CapturePriority priority);
     [DllImport(name, EntryPoint = "UwcRequestCaptureIcon")]
     public static extern void RequestCaptureIcon(int id);
+    [DllImport(name, EntryPoint = "UwcRequestCaptureGroup")]
+    private static extern uint RequestCaptureGroup_Internal(int[] ids, int count);
+    [DllImport(name, EntryPoint = "UwcGetLastReleasedCaptureGroupSequence")]
+    public static extern uint GetLastReleasedCaptureGroupSequence();
+    [DllImport(name, EntryPoint = "UwcGetWindowCaptureGroupSequence")]
+    public static extern uint GetWindowCaptureGroupSequence(int id);
+    [DllImport(name, EntryPoint = "UwcGetWindowCaptureGroupTimestamp")]
+    public static extern ulong GetWindowCaptureGroupTimestamp(int id);
+    [DllImport(name, EntryPoint = "UwcSetWindowImportance")]
+    private static extern void SetWindowImportance_Internal(int[] ids, float[] weights, int count);
+    [DllImport(name, EntryPoint = "UwcSetCaptureBudget")]
+    public static extern void SetCaptureBudget(float maxCapturesPerSecond, float minCapturesPerSecondPerWindow);
+    [DllImport(name, EntryPoint = "UwcSetWindowTextureIdleTimeout")]
+    public static extern void SetWindowTextureIdleTimeout(uint milliseconds);
+    [DllImport(name, EntryPoint = "UwcSetCaptureDeadline")]
+    public static extern void SetCaptureDeadline(uint milliseconds);
+    [DllImport(name, EntryPoint = "UwcIsWindowCaptureQuarantined")]
+    public static extern bool IsWindowCaptureQuarantined(int id);
+    [DllImport(name, EntryPoint = "UwcGetCaptureStallStats")]
+    public static extern CaptureStallStats GetCaptureStallStats();
+    [DllImport(name, EntryPoint = "UwcSetCaptureLeaseDuration")]
+    public static extern void SetCaptureLeaseDuration(uint milliseconds);
+    [DllImport(name, EntryPoint = "UwcGetIdleReleaseStats")]
+    public static extern IdleReleaseStats GetIdleReleaseStats();
+    [DllImport(name, EntryPoint = "UwcSetWindowListIntervalRange")]
+    public static extern void SetWindowListIntervalRange(uint minMilliseconds, uint maxMilliseconds);
+    [DllImport(name, EntryPoint = "UwcRequestUpdateWindowList")]
+    public static extern void RequestUpdateWindowList();
+    [DllImport(name, EntryPoint = "UwcGetWindowListStats")]
+    public static extern WindowListStats GetWindowListStats();
     [DllImport(name, EntryPoint = "StartCaptureWindow")]
     public static extern void StartCaptureWindow(int id, CapturePriority priority);
     [DllImport(name, EntryPoint = "StopCaptureWindow")]
@@ -136,6 +331,54 @@ public static class Lib
     public static extern int GetWindowZOrder(int id);
     [DllImport(name, EntryPoint = "UwcGetWindowBuffer")]
     public static extern IntPtr GetWindowBuffer(int id);
+    [DllImport(name, EntryPoint = "UwcSetLockProfilerEnabled")]
+    public static extern void SetLockProfilerEnabled(bool enabled);
+    [DllImport(name, EntryPoint = "UwcResetLockStats")]
+    public static extern void ResetLockStats();
+    [DllImport(name, EntryPoint = "UwcGetLockCount")]
+    public static extern int GetLockCount();
+    [DllImport(name, EntryPoint = "UwcGetLockName", CharSet = CharSet.Ansi)]
+    private static extern IntPtr GetLockName_Internal(int index);
+    [DllImport(name, EntryPoint = "UwcGetLockStats")]
+    public static extern LockStats GetLockStats(int index);
+    [DllImport(name, EntryPoint = "UwcGetThreadCount")]
+    public static extern int GetThreadCount();
+    [DllImport(name, EntryPoint = "UwcGetThreadName", CharSet = CharSet.Unicode)]
+    private static extern IntPtr GetThreadName_Internal(int index);
+    [DllImport(name, EntryPoint = "UwcGetThreadStats")]
+    public static extern ThreadLoopStats GetThreadStats(int index);
+    [DllImport(name, EntryPoint = "UwcResetThreadStats")]
+    public static extern void ResetThreadStats();
+    [DllImport(name, EntryPoint = "UwcStartTrace")]
+    public static extern void StartTrace();
+    [DllImport(name, EntryPoint = "UwcStopTrace")]
+    public static extern void StopTrace();
+    [DllImport(name, EntryPoint = "UwcIsTraceRecording")]
+    public static extern bool IsTraceRecording();
+    [DllImport(name, EntryPoint = "UwcDumpTrace")]
+    public static extern bool DumpTrace(string path);
+    [DllImport(name, EntryPoint = "UwcSetLatencyMetricsEnabled")]
+    public static extern void SetLatencyMetricsEnabled(bool enabled);
+    [DllImport(name, EntryPoint = "UwcResetLatencyMetrics")]
+    public static extern void ResetLatencyMetrics();
+    [DllImport(name, EntryPoint = "UwcGetStageLatencyStats")]
+    public static extern LatencyStats GetStageLatencyStats(PipelineStage stage);
+    [DllImport(name, EntryPoint = "UwcGetWindowStageLatencyStats")]
+    public static extern LatencyStats GetWindowStageLatencyStats(int id, PipelineStage stage);
+    [DllImport(name, EntryPoint = "UwcGetWindowFrameLatencyStats")]
+    public static extern FrameLatencyStats GetWindowFrameLatencyStats(int id);
+    [DllImport(name, EntryPoint = "UwcComposeVirtualDesktop")]
+    public static extern bool ComposeVirtualDesktop();
+    [DllImport(name, EntryPoint = "UwcGetVirtualDesktopBuffer")]
+    public static extern IntPtr GetVirtualDesktopBuffer();
+    [DllImport(name, EntryPoint = "UwcGetVirtualDesktopX")]
+    public static extern int GetVirtualDesktopX();
+    [DllImport(name, EntryPoint = "UwcGetVirtualDesktopY")]
+    public static extern int GetVirtualDesktopY();
+    [DllImport(name, EntryPoint = "UwcGetVirtualDesktopWidth")]
+    public static extern int GetVirtualDesktopWidth();
+    [DllImport(name, EntryPoint = "UwcGetVirtualDesktopHeight")]
+    public static extern int GetVirtualDesktopHeight();
     [DllImport(name, EntryPoint = "UwcGetWindowTextureWidth")]
     public static extern int GetWindowTextureWidth(int id);
     [DllImport(name, EntryPoint = "UwcGetWindowTextureHeight")]
@@ -196,6 +439,8 @@ public static class Lib
     public static extern bool IsApplicationFrameWindow(int id);
     [DllImport(name, EntryPoint = "UwcIsWindowUWP")]
     public static extern bool IsWindowUWP(int id);
+    [DllImport(name, EntryPoint = "UwcGetWindowResolvedMetadata")]
+    public static extern uint GetWindowResolvedMetadata(int id);
     [DllImport(name, EntryPoint = "UwcIsWindowBackground")]
     public static extern bool IsWindowBackground(int id);
     [DllImport(name, EntryPoint = "UwcGetWindowPixel")]
@@ -208,6 +453,16 @@ public static class Lib
     public static extern Point GetCursorPosition();
     [DllImport(name, EntryPoint = "UwcGetWindowIdFromPoint")]
     public static extern int GetWindowIdFromPoint(int x, int y);
+    [DllImport(name, EntryPoint = "UwcGetWindowIdsFromPoints")]
+    private static extern void GetWindowIdsFromPoints_Internal(Point[] points, [Out] int[] ids, int count);
+    [DllImport(name, EntryPoint = "UwcGetWindowVisibleFraction")]
+    public static extern float GetWindowVisibleFraction(int id);
+    [DllImport(name, EntryPoint = "UwcGetWindowVisibleRectCount")]
+    public static extern int GetWindowVisibleRectCount(int id);
+    [DllImport(name, EntryPoint = "UwcGetWindowVisibleRects")]
+    private static extern int GetWindowVisibleRects_Internal(int id, [Out] WindowRect[] rects, int count);
+    [DllImport(name, EntryPoint = "UwcSetOccludedWindowCapturePolicy")]
+    public static extern void SetOccludedWindowCapturePolicy(OccludedWindowCapturePolicy policy);
     [DllImport(name, EntryPoint = "UwcGetWindowIdUnderCursor")]
     public static extern int GetWindowIdUnderCursor();
     [DllImport(name, EntryPoint = "UwcGetCursorX")]
@@ -303,6 +558,73 @@ public static class Lib
         }
     }
 
+    public static string GetLockName(int index)
+    {
+        var ptr = GetLockName_Internal(index);
+        if (ptr != IntPtr.Zero) {
+            return Marshal.PtrToStringAnsi(ptr);
+        } else {
+            return "";
+        }
+    }
+
+    public static string GetThreadName(int index)
+    {
+        var ptr = GetThreadName_Internal(index);
+        if (ptr != IntPtr.Zero) {
+            return Marshal.PtrToStringUni(ptr);
+        } else {
+            return "";
+        }
+    }
+
+    // Answered from the window rects of the last enumeration instead of the hit test of the system
+    // which GetWindowIdFromPoint() uses, so both agree on top-level windows but this one does not see
+    // child windows, transparent areas or windows which have moved since the enumeration.
+    public static void GetWindowIdsFromPoints(Point[] points, int[] ids)
+    {
+        if (points == null) {
+            throw new ArgumentNullException("points");
+        }
+        if (ids == null || ids.Length < points.Length) {
+            throw new ArgumentException("ids must be as long as points.", "ids");
+        }
+        GetWindowIdsFromPoints_Internal(points, ids, points.Length);
+    }
+
+    public static uint RequestCaptureGroup(int[] ids)
+    {
+        if (ids == null) {
+            throw new ArgumentNullException("ids");
+        }
+        return RequestCaptureGroup_Internal(ids, ids.Length);
+    }
+
+    public static void SetWindowImportance(int[] ids, float[] weights)
+    {
+        if (ids == null || weights == null) {
+            SetWindowImportance_Internal(null, null, 0);
+            return;
+        }
+        if (weights.Length < ids.Length) {
+            throw new ArgumentException("weights must be as long as ids.", "weights");
+        }
+        SetWindowImportance_Internal(ids, weights, ids.Length);
+    }
+
+    public static WindowRect[] GetWindowVisibleRects(int id)
+    {
+        var count = GetWindowVisibleRectCount(id);
+        var rects = new WindowRect[count];
+        if (count > 0) {
+            count = GetWindowVisibleRects_Internal(id, rects, count);
+            if (count < rects.Length) {
+                Array.Resize(ref rects, count);
+            }
+        }
+        return rects;
+    }
+
     public static Color32[] GetWindowPixels(int id, int x, int y, int width, int height)
     {
         var color = new Color32[width * height];
@@ -248,6 +248,20 @@ public class UwcManager : MonoBehaviour
                     }
                     break;
                 }
+                case MessageType.WindowMoved: {
+                    var window = Find(id);
+                    if (window != null) {
+                        window.onMoved.Invoke();
+                    }
+                    break;
+                }
+                case MessageType.WindowZOrderChanged: {
+                    var window = Find(id);
+                    if (window != null) {
+                        window.onZOrderChanged.Invoke();
+                    }
+                    break;
+                }
                 case MessageType.CursorCaptured: {
                     cursor.onCaptured.Invoke();
                     break;
@@ -313,6 +313,18 @@ public class UwcWindow
         get { return onIconCaptured_; } 
     }
 
+    private UnityEvent onMoved_ = new UnityEvent();
+    public UnityEvent onMoved
+    {
+        get { return onMoved_; }
+    }
+
+    private UnityEvent onZOrderChanged_ = new UnityEvent();
+    public UnityEvent onZOrderChanged
+    {
+        get { return onZOrderChanged_; }
+    }
+
     public class ChildAddedEvent : UnityEvent<UwcWindow> {}
     private ChildAddedEvent onChildAdded_ = new ChildAddedEvent();
     public ChildAddedEvent onChildAdded
@@ -0,0 +1,473 @@
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include "Benchmark.h"
+#include "WindowQueue.h"
+#include "WindowList.h"
+#include "WindowSpatialIndex.h"
+#include "DesktopCompositor.h"
+#include "PixelKernel.h"
+#include "SnapshotTable.h"
+#include "Buffer.h"
+#include "Message.h"
+
+
+
+namespace
+{
+    constexpr auto kMinDuration = std::chrono::milliseconds(200);
+    constexpr UINT kWindowCounts[] = { 100, 1000, 5000, 10000 };
+    constexpr UINT kFrameWidth = 1920;
+    constexpr UINT kFrameHeight = 1080;
+    constexpr UINT kWindowsPerThread = 8;
+
+
+    // Repeats func until kMinDuration has passed and returns the time per operation.
+    template <class Func>
+    Benchmark::Result Measure(const std::string& name, UINT64 opsPerIteration, Func&& func)
+    {
+        using namespace std::chrono;
+
+        func();
+
+        UINT64 iterations = 0;
+        const auto start = steady_clock::now();
+        auto elapsed = steady_clock::duration::zero();
+        do
+        {
+            func();
+            ++iterations;
+            elapsed = steady_clock::now() - start;
+        }
+        while (elapsed < kMinDuration);
+
+        const auto ns = static_cast<double>(duration_cast<nanoseconds>(elapsed).count());
+        return { name, iterations, ns / (iterations * opsPerIteration) };
+    }
+
+
+    // Small LCG so that every run uses the same layouts.
+    class Random
+    {
+    public:
+        UINT Next(UINT range)
+        {
+            state_ = state_ * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<UINT>((state_ >> 33) % range);
+        }
+
+    private:
+        UINT64 state_ = 1;
+    };
+
+
+    WindowData MakeWindowData(UINT serial, UINT zOrder)
+    {
+        WindowData data {};
+        data.hWnd = reinterpret_cast<HWND>(static_cast<UINT_PTR>(0x10000 + serial * 4));
+        data.windowRect = { 0, 0, 100, 100 };
+        data.clientRect = { 0, 0, 100, 100 };
+        data.zOrder = zOrder;
+        return data;
+    }
+
+
+    DWORD GetThreadId(HWND hWnd)
+    {
+        const auto serial = (reinterpret_cast<UINT_PTR>(hWnd) - 0x10000) / 4;
+        return static_cast<DWORD>(serial / kWindowsPerThread);
+    }
+
+
+    // Looks up windows by id on the calling thread while other threads do the same
+    // and the window list thread publishes a change as often as it can.
+    template <class Publish, class Lookup>
+    Benchmark::Result MeasureConcurrentLookup(const std::string& name, Publish&& publish, Lookup&& lookup)
+    {
+        constexpr UINT kLookupCount = 1000;
+        constexpr UINT kReaderCount = 3;
+
+        std::atomic<bool> isDone = false;
+        std::vector<std::thread> threads;
+        threads.emplace_back([&]
+        {
+            UINT serial = 0;
+            while (!isDone) publish(serial++);
+        });
+        for (UINT i = 0; i < kReaderCount; ++i)
+        {
+            threads.emplace_back([&]
+            {
+                while (!isDone) lookup(0);
+            });
+        }
+
+        int sum = 0;
+        auto result = Measure(name, kLookupCount, [&]
+        {
+            for (UINT i = 0; i < kLookupCount; ++i) sum += lookup(i);
+        });
+
+        isDone = true;
+        for (auto& thread : threads) thread.join();
+
+        // Keeps the lookups from being optimized away.
+        if (sum == INT_MIN) std::cout << sum;
+
+        return result;
+    }
+
+
+    // Gives the same thread to every kWindowsPerThread windows so that they have parent candidates.
+    class BenchmarkListener : public WindowList::Listener
+    {
+    public:
+        bool OnWindowAdding(WindowList::Node& node) override
+        {
+            node.id = nextId_++;
+            node.processId = 1;
+            node.threadId = GetThreadId(node.data.hWnd);
+            return true;
+        }
+
+        void OnWindowAdded(const WindowList::Node&) override {}
+        void OnWindowUpdated(const WindowList::Node&, const WindowData&, bool) override {}
+        void OnWindowRemoved(const WindowList::Node&) override {}
+
+    private:
+        int nextId_ = 0;
+    };
+
+
+    std::unordered_map<std::string, double> LoadBaseline(const std::string& path)
+    {
+        std::unordered_map<std::string, double> baseline;
+
+        std::ifstream fs(path);
+        if (!fs.good()) return baseline;
+
+        std::stringstream ss;
+        ss << fs.rdbuf();
+        const auto json = ss.str();
+
+        // Reads back the format written by Benchmark::Run().
+        const std::string nameKey = "\"name\": \"";
+        const std::string nsKey = "\"nsPerOp\": ";
+        for (auto pos = json.find(nameKey); pos != std::string::npos; pos = json.find(nameKey, pos))
+        {
+            pos += nameKey.size();
+            const auto nameEnd = json.find('"', pos);
+            const auto nsPos = json.find(nsKey, nameEnd);
+            if (nameEnd == std::string::npos || nsPos == std::string::npos) break;
+
+            baseline[json.substr(pos, nameEnd - pos)] = atof(json.c_str() + nsPos + nsKey.size());
+            pos = nsPos;
+        }
+
+        return baseline;
+    }
+}
+
+
+// ---
+
+
+std::vector<Benchmark::Result> Benchmark::RunAll()
+{
+    std::vector<Result> results;
+
+    {
+        constexpr UINT kCount = 64;
+        WindowQueue queue;
+        results.push_back(Measure("WindowQueue/EnqueueDequeue", kCount, [&]
+        {
+            for (UINT i = 0; i < kCount; ++i) queue.Enqueue(i);
+            while (queue.Dequeue() != -1);
+        }));
+    }
+
+    {
+        Buffer<BYTE> src(kFrameWidth * kFrameHeight * 4);
+        Buffer<BYTE> dst(kFrameWidth * kFrameHeight * 4);
+        results.push_back(Measure("PixelKernel/CopyBgraToRgbaFlipped/1920x1080", kFrameWidth * kFrameHeight, [&]
+        {
+            CopyBgraToRgbaFlipped(src.Get(), kFrameWidth * 4, dst.Get(), kFrameWidth, kFrameHeight);
+        }));
+
+        // Regions read by GetPixels() and GetPixel() from the middle of a captured frame.
+        for (const UINT size : { 256u, 1u })
+        {
+            const auto* start = src.Get(((kFrameHeight / 2) * kFrameWidth + kFrameWidth / 2) * 4);
+            const auto name = "PixelKernel/GetPixels/" + std::to_string(size) + "x" + std::to_string(size);
+            results.push_back(Measure(name, size * size, [&]
+            {
+                CopyBgraToRgbaFlipped(start, kFrameWidth * 4, dst.Get(), size, size);
+            }));
+        }
+    }
+
+    {
+        // The second monitor has a different DPI, so it takes the scaling path.
+        Buffer<BYTE> frame(kFrameWidth * kFrameHeight * 4);
+        DesktopCompositor compositor;
+        UINT64 version = 0;
+        const auto read = [&](const DesktopCompositor::FrameReader& reader)
+        {
+            reader(frame.Get(), kFrameWidth, kFrameHeight);
+            return true;
+        };
+        const LONG w = static_cast<LONG>(kFrameWidth);
+        const LONG h = static_cast<LONG>(kFrameHeight);
+        results.push_back(Measure("DesktopCompositor/Compose/2x1920x1080", 2, [&]
+        {
+            ++version;
+            compositor.Compose({
+                { 0, { 0, 0, w, h }, version, read },
+                { 1, { w, 0, w + w * 3 / 2, h * 3 / 2 }, version, read },
+            });
+        }));
+    }
+
+    {
+        // std::atomic_load() of a shared_ptr as the window map was published before,
+        // against SnapshotTable which the window manager publishes the windows with now.
+        constexpr UINT kCount = 1000;
+        using Map = std::vector<std::shared_ptr<int>>;
+
+        auto map = std::make_shared<Map>();
+        for (UINT i = 0; i < kCount; ++i) map->push_back(std::make_shared<int>(i));
+        std::shared_ptr<const Map> published = map;
+
+        results.push_back(MeasureConcurrentLookup("AtomicSharedPtr/ConcurrentLookup/1000", [&](UINT serial)
+        {
+            (*map)[serial % kCount] = std::make_shared<int>(serial);
+            std::atomic_store(&published, std::shared_ptr<const Map>(std::make_shared<Map>(*map)));
+        }, [&](UINT i)
+        {
+            const auto snapshot = std::atomic_load(&published);
+            return *(*snapshot)[i % kCount];
+        }));
+
+        SnapshotTable<std::shared_ptr<int>> table;
+        for (UINT i = 0; i < kCount; ++i) table.Set(i, std::make_shared<int>(i));
+        table.Publish();
+
+        results.push_back(MeasureConcurrentLookup("SnapshotTable/ConcurrentLookup/1000", [&](UINT serial)
+        {
+            table.Set(serial % kCount, std::make_shared<int>(serial));
+            table.Publish();
+        }, [&](UINT i)
+        {
+            const auto snapshot = table.Acquire();
+            return *snapshot->Get(i % kCount);
+        }));
+    }
+
+    {
+        MessageManager::Create();
+        auto& messages = MessageManager::Get();
+
+        constexpr UINT kCount = 1000;
+        results.push_back(Measure("MessageManager/AddDrain/1000", kCount, [&]
+        {
+            for (UINT i = 0; i < kCount; ++i)
+            {
+                messages.Add({ MessageType::WindowCaptured, static_cast<int>(i % 100), nullptr });
+            }
+            messages.GetCount();
+            messages.ClearAll();
+        }));
+
+        results.push_back(Measure("MessageManager/ExcludeRemovedWindowEvents/1000", kCount, [&]
+        {
+            for (UINT i = 0; i < kCount; ++i)
+            {
+                const auto type = (i % 10 == 0) ? MessageType::WindowRemoved : MessageType::WindowCaptured;
+                messages.Add({ type, static_cast<int>(i % 100), nullptr });
+            }
+            messages.ExcludeRemovedWindowEvents();
+            messages.ClearAll();
+        }));
+
+        MessageManager::Destroy();
+    }
+
+    for (const auto count : kWindowCounts)
+    {
+        const auto suffix = "/" + std::to_string(count);
+
+        // Replaces a tenth of the windows per pass as the window list thread does on changes.
+        {
+            std::vector<WindowData> dataList;
+            for (UINT i = 0; i < count; ++i)
+            {
+                dataList.push_back(MakeWindowData(i, i));
+            }
+
+            WindowList list;
+            BenchmarkListener listener;
+            list.Update(dataList, listener);
+
+            Random random;
+            UINT serial = count;
+            const UINT churn = max(count / 10, 1u);
+            results.push_back(Measure("WindowList/Update" + suffix, count, [&]
+            {
+                for (UINT i = 0; i < churn; ++i)
+                {
+                    const auto index = random.Next(count);
+                    dataList[index] = MakeWindowData(serial++, index);
+                }
+                list.Update(dataList, listener);
+            }));
+        }
+
+        // Publishes a change of one window.
+        {
+            using Map = std::vector<std::shared_ptr<int>>;
+            auto map = std::make_shared<Map>();
+            SnapshotTable<std::shared_ptr<int>> table;
+            for (UINT i = 0; i < count; ++i)
+            {
+                map->push_back(std::make_shared<int>(i));
+                table.Set(i, map->back());
+            }
+
+            Random random;
+            std::shared_ptr<const Map> published;
+            results.push_back(Measure("AtomicSharedPtr/Publish" + suffix, 1, [&]
+            {
+                (*map)[random.Next(count)] = nullptr;
+                std::atomic_store(&published, std::shared_ptr<const Map>(std::make_shared<Map>(*map)));
+            }));
+
+            results.push_back(Measure("SnapshotTable/Publish" + suffix, 1, [&]
+            {
+                table.Reset(random.Next(count));
+                table.Publish();
+            }));
+        }
+
+        // Half of the new windows are owned by a random existing window.
+        {
+            std::vector<WindowData> dataList;
+            for (UINT i = 0; i < count; ++i)
+            {
+                dataList.push_back(MakeWindowData(i, i));
+            }
+
+            WindowList list;
+            BenchmarkListener listener;
+            list.Update(dataList, listener);
+
+            Random random;
+            constexpr UINT kNodeCount = 256;
+            std::vector<WindowList::Node> nodes(kNodeCount);
+            for (auto& node : nodes)
+            {
+                node.data = MakeWindowData(count + random.Next(count), random.Next(count));
+                node.data.hOwner = random.Next(2) ? dataList[random.Next(count)].hWnd : NULL;
+                node.processId = 1;
+                node.threadId = GetThreadId(dataList[random.Next(count)].hWnd);
+            }
+
+            int sum = 0;
+            results.push_back(Measure("WindowList/FindParent" + suffix, kNodeCount, [&]
+            {
+                for (const auto& node : nodes) sum += list.FindParent(node);
+            }));
+
+            results.push_back(Measure("WindowList/FindParentByScan" + suffix, kNodeCount, [&]
+            {
+                for (const auto& node : nodes) sum += list.FindParentByScan(node);
+            }));
+
+            // Keeps the lookups from being optimized away.
+            if (sum == INT_MIN) std::cout << sum;
+        }
+
+        {
+            Random random;
+            std::vector<WindowSpatialIndex::Entry> entries;
+            for (UINT i = 0; i < count; ++i)
+            {
+                const LONG x = random.Next(3840);
+                const LONG y = random.Next(2160);
+                const LONG w = 100 + random.Next(800);
+                const LONG h = 100 + random.Next(600);
+                entries.push_back({ static_cast<int>(i), i, { x, y, x + w, y + h } });
+            }
+
+            constexpr int kPointCount = 256;
+            POINT points[kPointCount];
+            int ids[kPointCount];
+            for (auto& point : points)
+            {
+                point = { static_cast<LONG>(random.Next(3840)), static_cast<LONG>(random.Next(2160)) };
+            }
+
+            WindowSpatialIndex index;
+            results.push_back(Measure("WindowSpatialIndex/Build" + suffix, count, [&]
+            {
+                auto copied = entries;
+                index.Build({ 0, 0, 3840 + 900, 2160 + 700 }, std::move(copied));
+            }));
+
+            results.push_back(Measure("WindowSpatialIndex/Find" + suffix, kPointCount, [&]
+            {
+                index.Find(points, ids, kPointCount);
+            }));
+        }
+    }
+
+    return results;
+}
+
+
+int Benchmark::Run(const std::string& outputPath, const std::string& baselinePath, float threshold)
+{
+    const auto results = RunAll();
+    const auto baseline = baselinePath.empty() ?
+        std::unordered_map<std::string, double>() :
+        LoadBaseline(baselinePath);
+
+    std::ofstream fs(outputPath);
+    if (!fs.good())
+    {
+        std::cerr << "Failed to open " << outputPath << std::endl;
+        return -1;
+    }
+
+    int regressionCount = 0;
+
+    fs << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& result = results[i];
+        fs << "    { \"name\": \"" << result.name << "\""
+           << ", \"iterations\": " << result.iterations
+           << ", \"nsPerOp\": " << result.nsPerOp;
+
+        const auto it = baseline.find(result.name);
+        if (it != baseline.end())
+        {
+            const bool isRegression = result.nsPerOp > it->second * (1.0 + threshold);
+            if (isRegression)
+            {
+                ++regressionCount;
+                std::cerr << "Regression: " << result.name << " " << it->second << " => " << result.nsPerOp << " [ns/op]" << std::endl;
+            }
+            fs << ", \"baselineNsPerOp\": " << it->second
+               << ", \"isRegression\": " << (isRegression ? "true" : "false");
+        }
+
+        fs << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    fs << "  ],\n  \"regressionCount\": " << regressionCount << "\n}\n";
+
+    return regressionCount;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Platform.h"
+#include <string>
+#include <vector>
+
+
+// Micro benchmarks of the platform independent hot paths, built as uWindowCaptureBenchmarks.
+// Results are written as JSON. If the output of a previous run is given as a baseline,
+// benchmarks slower than it by more than the threshold are reported as regressions.
+class Benchmark
+{
+public:
+    struct Result
+    {
+        std::string name;
+        UINT64 iterations;
+        double nsPerOp;
+    };
+
+    // Returns the number of regressions, or -1 if the results could not be written.
+    static int Run(const std::string& outputPath, const std::string& baselinePath, float threshold);
+
+private:
+    static std::vector<Result> RunAll();
+};
@@ -0,0 +1,24 @@
+#include <cstdlib>
+#include <iostream>
+#include "Benchmark.h"
+
+
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: uWindowCaptureBenchmarks <output.json> [<baseline.json> [<threshold>]]" << std::endl;
+        return 2;
+    }
+
+    const std::string outputPath = argv[1];
+    const std::string baselinePath = (argc > 2) ? argv[2] : "";
+    const float threshold = (argc > 3) ? static_cast<float>(atof(argv[3])) : 0.1f;
+
+    const int regressionCount = Benchmark::Run(outputPath, baselinePath, threshold);
+    if (regressionCount < 0) return 2;
+
+    std::cout << regressionCount << " regression(s)" << std::endl;
+    return regressionCount > 0 ? 1 : 0;
+}
\ No newline at end of file
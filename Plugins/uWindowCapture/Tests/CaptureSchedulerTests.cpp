@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "CaptureScheduler.h"
+
+
+
+TEST(CaptureSchedulerTests, PopsInPriorityOrder)
+{
+    CaptureScheduler scheduler;
+    scheduler.Request(1, CapturePriority::Low, false);
+    scheduler.Request(2, CapturePriority::Middle, false);
+    scheduler.Request(3, CapturePriority::High, false);
+
+    EXPECT_EQ(scheduler.Pop(), 3);
+    EXPECT_EQ(scheduler.Pop(), 2);
+    EXPECT_EQ(scheduler.Pop(), 1);
+    EXPECT_EQ(scheduler.Pop(), -1);
+}
+
+
+TEST(CaptureSchedulerTests, MovesMiddlePriorityForwardWhileHighPriorityIsServed)
+{
+    CaptureScheduler scheduler;
+    scheduler.Request(1, CapturePriority::High, false);
+    scheduler.Request(2, CapturePriority::High, false);
+    scheduler.Request(3, CapturePriority::Middle, false);
+
+    EXPECT_EQ(scheduler.Pop(), 1);
+    EXPECT_EQ(scheduler.Pop(), 2);
+    EXPECT_EQ(scheduler.Pop(), 3);
+}
+
+
+TEST(CaptureSchedulerTests, AppliesOccludedWindowCapturePolicy)
+{
+    CaptureScheduler scheduler;
+
+    scheduler.SetOccludedWindowCapturePolicy(OccludedWindowCapturePolicy::Skip);
+    EXPECT_FALSE(scheduler.Request(1, CapturePriority::High, true));
+    EXPECT_TRUE(scheduler.Request(2, CapturePriority::High, false));
+    EXPECT_EQ(scheduler.Pop(), 2);
+    EXPECT_EQ(scheduler.Pop(), -1);
+
+    scheduler.SetOccludedWindowCapturePolicy(OccludedWindowCapturePolicy::Deprioritize);
+    EXPECT_TRUE(scheduler.Request(1, CapturePriority::High, true));
+    EXPECT_TRUE(scheduler.Request(2, CapturePriority::Middle, false));
+    EXPECT_EQ(scheduler.Pop(), 2);
+    EXPECT_EQ(scheduler.Pop(), 1);
+}
+
+
+TEST(CaptureSchedulerTests, ThrottlesWeightedWindows)
+{
+    CaptureScheduler scheduler;
+    scheduler.SetCaptureBudget(1.f, 0.5f);
+
+    const int ids[] = { 1 };
+    const float weights[] = { 1.f };
+    scheduler.SetWindowImportance(ids, weights, 1);
+
+    int count = 0;
+    for (int i = 0; i < 10; ++i)
+    {
+        if (scheduler.Request(1, CapturePriority::High, false)) ++count;
+    }
+    EXPECT_EQ(count, 1);
+}
+
+
+
+TEST(CaptureSchedulerTests, SharesBudgetByWeightsAboveFloorRate)
+{
+    CaptureScheduler scheduler;
+    EXPECT_TRUE(std::isinf(scheduler.GetCaptureRate(1)));
+
+    scheduler.SetCaptureBudget(10.f, 1.f);
+    const int ids[] = { 1, 2 };
+    const float weights[] = { 1.f, 3.f };
+    scheduler.SetWindowImportance(ids, weights, 2);
+    EXPECT_FLOAT_EQ(scheduler.GetCaptureRate(1), 3.f);
+    EXPECT_FLOAT_EQ(scheduler.GetCaptureRate(2), 7.f);
+    EXPECT_FLOAT_EQ(scheduler.GetCaptureRate(3), 1.f);
+
+    // Changing the budget applies to the current weights without giving them again.
+    scheduler.SetCaptureBudget(20.f, 2.f);
+    EXPECT_FLOAT_EQ(scheduler.GetCaptureRate(1), 6.f);
+    EXPECT_FLOAT_EQ(scheduler.GetCaptureRate(2), 14.f);
+    EXPECT_FLOAT_EQ(scheduler.GetCaptureRate(3), 2.f);
+
+    scheduler.SetWindowImportance(nullptr, nullptr, 2);
+    EXPECT_TRUE(std::isinf(scheduler.GetCaptureRate(1)));
+}
+
+
+TEST(CaptureSchedulerTests, ThrottlesUnlistedWindows)
+{
+    CaptureScheduler scheduler;
+    scheduler.SetCaptureBudget(100.f, 0.5f);
+
+    const int ids[] = { 1 };
+    const float weights[] = { 1.f };
+    scheduler.SetWindowImportance(ids, weights, 1);
+
+    int count = 0;
+    for (int i = 0; i < 10; ++i)
+    {
+        if (scheduler.Request(2, CapturePriority::High, false)) ++count;
+    }
+    EXPECT_EQ(count, 1);
+}
+
+
+TEST(CaptureSchedulerTests, CapsAllWindowsByTotalBudget)
+{
+    CaptureScheduler scheduler;
+    scheduler.SetCaptureBudget(1.f, 1.f);
+
+    const int ids[] = { 1 };
+    const float weights[] = { 1.f };
+    scheduler.SetWindowImportance(ids, weights, 1);
+
+    // Every window has a token of its own, but the total budget allows a burst of two.
+    int count = 0;
+    for (int id = 1; id <= 4; ++id)
+    {
+        if (scheduler.Request(id, CapturePriority::High, false)) ++count;
+    }
+    EXPECT_EQ(count, 2);
+}
+
+
+TEST(CaptureSchedulerTests, KeepsTokenOfSkippedOccludedWindow)
+{
+    CaptureScheduler scheduler;
+    scheduler.SetCaptureBudget(1.f, 0.5f);
+    scheduler.SetOccludedWindowCapturePolicy(OccludedWindowCapturePolicy::Skip);
+
+    const int ids[] = { 1 };
+    const float weights[] = { 1.f };
+    scheduler.SetWindowImportance(ids, weights, 1);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        EXPECT_FALSE(scheduler.Request(1, CapturePriority::High, true));
+    }
+    EXPECT_TRUE(scheduler.Request(1, CapturePriority::High, false));
+}
\ No newline at end of file
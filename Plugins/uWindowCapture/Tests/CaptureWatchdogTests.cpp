@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <string>
+#include "CaptureWatchdog.h"
+#include "Thread.h"
+
+
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    constexpr auto kDeadline = 50ms;
+    constexpr auto kStallTime = 300ms;
+
+
+    // Stands in for a capture backend whose window hangs for a while.
+    // The state is shared with the job since a stuck worker may outlive the test.
+    struct FakeCapture
+    {
+        std::atomic<int> count = 0;
+        std::atomic<std::thread::id> threadId;
+    };
+
+
+    CaptureWatchdog::Job MakeJob(const std::shared_ptr<FakeCapture>& capture, std::chrono::milliseconds sleepTime)
+    {
+        return [capture, sleepTime]
+        {
+            capture->threadId = std::this_thread::get_id();
+            std::this_thread::sleep_for(sleepTime);
+            ++capture->count;
+        };
+    }
+
+
+    UINT64 GetWorkerIterationCount()
+    {
+        for (UINT i = 0; i < ThreadLoop::GetThreadCount(); ++i)
+        {
+            if (std::wstring(ThreadLoop::GetThreadName(i)) == L"uWindowCapture - Capture Worker Thread")
+            {
+                return ThreadLoop::GetStats(i).iterationCount;
+            }
+        }
+        return 0;
+    }
+}
+
+
+// ---
+
+
+TEST(CaptureWatchdogTests, RunsCapturesWhichCannotBlockInline)
+{
+    CaptureWatchdog watchdog;
+    const auto capture = std::make_shared<FakeCapture>();
+
+    EXPECT_TRUE(watchdog.Run(1, MakeJob(capture, 0ms), false));
+    EXPECT_EQ(capture->count, 1);
+    EXPECT_EQ(capture->threadId.load(), std::this_thread::get_id());
+}
+
+
+TEST(CaptureWatchdogTests, RunsCapturesWhichCanBlockInWorker)
+{
+    CaptureWatchdog watchdog;
+    const auto capture = std::make_shared<FakeCapture>();
+
+    EXPECT_TRUE(watchdog.Run(1, MakeJob(capture, 0ms), true));
+    EXPECT_EQ(capture->count, 1);
+    EXPECT_NE(capture->threadId.load(), std::this_thread::get_id());
+}
+
+
+TEST(CaptureWatchdogTests, AccountsWorkersInThreadLoopStats)
+{
+    CaptureWatchdog watchdog;
+    const auto capture = std::make_shared<FakeCapture>();
+
+    const auto count = GetWorkerIterationCount();
+    EXPECT_TRUE(watchdog.Run(1, MakeJob(capture, 0ms), false));
+    EXPECT_EQ(GetWorkerIterationCount(), count);
+    EXPECT_TRUE(watchdog.Run(1, MakeJob(capture, 0ms), true));
+    EXPECT_TRUE(watchdog.Run(1, MakeJob(capture, 0ms), true));
+    EXPECT_EQ(GetWorkerIterationCount(), count + 2);
+}
+
+
+TEST(CaptureWatchdogTests, QuarantinesStalledWindow)
+{
+    CaptureWatchdog watchdog;
+    watchdog.SetDeadline(kDeadline);
+    const auto capture = std::make_shared<FakeCapture>();
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(watchdog.Run(1, MakeJob(capture, kStallTime), true));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, kStallTime);
+    EXPECT_TRUE(watchdog.IsQuarantined(1));
+    EXPECT_FALSE(watchdog.IsQuarantined(2));
+
+    auto stats = watchdog.GetStats();
+    EXPECT_EQ(stats.stallCount, 1u);
+    EXPECT_EQ(stats.stuckWorkerCount, 1u);
+    EXPECT_EQ(stats.quarantinedWindowCount, 1u);
+
+    // The quarantined window is skipped while the others keep being captured.
+    const auto other = std::make_shared<FakeCapture>();
+    EXPECT_FALSE(watchdog.Run(1, MakeJob(capture, 0ms), true));
+    EXPECT_TRUE(watchdog.Run(2, MakeJob(other, 0ms), true));
+    EXPECT_EQ(other->count, 1);
+
+    // The stuck worker is collected once its capture has returned.
+    std::this_thread::sleep_for(kStallTime);
+    EXPECT_TRUE(watchdog.Run(2, MakeJob(other, 0ms), true));
+    stats = watchdog.GetStats();
+    EXPECT_EQ(stats.stuckWorkerCount, 0u);
+    EXPECT_GE(stats.maxStallTime, 200.f);
+    EXPECT_EQ(capture->count, 1);
+}
+
+
+TEST(CaptureWatchdogTests, KeepsStalledWindowInWorkerEvenIfItCannotBlock)
+{
+    CaptureWatchdog watchdog;
+    watchdog.SetDeadline(kDeadline);
+    const auto capture = std::make_shared<FakeCapture>();
+
+    EXPECT_FALSE(watchdog.Run(1, MakeJob(capture, kStallTime), true));
+
+    // A stalled window would block the caller if it ran inline, so it is left to the deadline.
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<CaptureWatchdog::Task> tasks = { { 1, MakeJob(capture, kStallTime), false, false } };
+    watchdog.RunParallel(tasks);
+    EXPECT_FALSE(tasks[0].isDone);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, kStallTime);
+}
+
+
+TEST(CaptureWatchdogTests, CapturesOtherTasksInParallelWithStalledOne)
+{
+    CaptureWatchdog watchdog;
+    watchdog.SetDeadline(kDeadline);
+
+    std::vector<std::shared_ptr<FakeCapture>> captures;
+    std::vector<CaptureWatchdog::Task> tasks;
+    for (int id = 0; id < 6; ++id)
+    {
+        captures.push_back(std::make_shared<FakeCapture>());
+        const auto sleepTime = (id == 2) ? kStallTime : 0ms;
+        tasks.push_back({ id, MakeJob(captures.back(), sleepTime), id % 2 == 0, false });
+    }
+
+    watchdog.RunParallel(tasks);
+
+    for (int id = 0; id < 6; ++id)
+    {
+        EXPECT_EQ(tasks[id].isDone, id != 2) << "id=" << id;
+    }
+    EXPECT_TRUE(watchdog.IsQuarantined(2));
+}
+
+
+TEST(CaptureWatchdogTests, ClearsAliveTokenWhenDestroyed)
+{
+    const auto capture = std::make_shared<FakeCapture>();
+    CaptureWatchdog::AliveToken alive;
+    {
+        CaptureWatchdog watchdog;
+        watchdog.SetDeadline(kDeadline);
+        alive = watchdog.GetAliveToken();
+        EXPECT_TRUE(*alive);
+
+        EXPECT_FALSE(watchdog.Run(1, MakeJob(capture, kStallTime), true));
+    }
+    EXPECT_FALSE(*alive);
+
+    // Lets the detached worker finish before the process exits.
+    std::this_thread::sleep_for(kStallTime);
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include "Debug.h"
+
+
+
+namespace
+{
+    std::string g_lastLog;
+
+
+    void UNITY_INTERFACE_API OnLog(const char* message)
+    {
+        g_lastLog = message;
+    }
+
+
+    // Outputs to OnLog() while alive and returns the body of the last line.
+    class ScopedUnityLog
+    {
+    public:
+        ScopedUnityLog()
+        {
+            g_lastLog.clear();
+            Debug::SetLogFunc(OnLog);
+            Debug::SetMode(Debug::Mode::UnityLog);
+        }
+
+        ~ScopedUnityLog()
+        {
+            Debug::SetMode(Debug::Mode::File);
+            Debug::SetLogFunc(nullptr);
+        }
+
+        std::string GetBody() const
+        {
+            const auto pos = g_lastLog.find("] ");
+            return pos == std::string::npos ? g_lastLog : g_lastLog.substr(pos + 2);
+        }
+    };
+
+
+    enum class TestEnum
+    {
+        Value = 3,
+    };
+}
+
+
+// ---
+
+
+TEST(DebugTests, OutputsSupportedTypes)
+{
+    ScopedUnityLog log;
+
+    const std::string str = "str";
+    Debug::Log("a", 'b', str, -1, 2u, 0.5f, TestEnum::Value);
+    EXPECT_EQ(log.GetBody(), "abstr-120.53");
+}
+
+
+TEST(DebugTests, OutputsValuesOfAtomics)
+{
+    ScopedUnityLog log;
+
+    const std::atomic<UINT> width = 1920;
+    std::atomic<int> height = -1080;
+    Debug::Log("width=", width, ", height=", height);
+    EXPECT_EQ(log.GetBody(), "width=1920, height=-1080");
+}
\ No newline at end of file
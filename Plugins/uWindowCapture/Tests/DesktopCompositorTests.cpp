@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "DesktopCompositor.h"
+
+
+
+namespace
+{
+    // A monitor whose frame encodes the monitor and the position of each pixel.
+    struct SyntheticMonitor
+    {
+        SyntheticMonitor(int id, const RECT& rect, UINT width, UINT height)
+            : id(id)
+            , rect(rect)
+            , width(width)
+            , height(height)
+        {
+            for (UINT y = 0; y < height; ++y)
+            {
+                for (UINT x = 0; x < width; ++x)
+                {
+                    pixels.push_back(GetPixel(x, y));
+                }
+            }
+        }
+
+        UINT GetPixel(UINT x, UINT y) const
+        {
+            return (static_cast<UINT>(id + 1) << 24) | (y << 12) | x;
+        }
+
+        DesktopCompositor::Source ToSource()
+        {
+            return { id, rect, version, [this](const DesktopCompositor::FrameReader& reader)
+            {
+                ++readCount;
+                if (!isReadable) return false;
+                reader(reinterpret_cast<const BYTE*>(pixels.data()), width, height);
+                return true;
+            }};
+        }
+
+        int id;
+        RECT rect;
+        UINT width;
+        UINT height;
+        std::vector<UINT> pixels;
+        UINT64 version = 1;
+        bool isReadable = true;
+        int readCount = 0;
+    };
+
+
+    std::vector<DesktopCompositor::Source> ToSources(const std::vector<SyntheticMonitor*>& monitors)
+    {
+        std::vector<DesktopCompositor::Source> sources;
+        for (auto monitor : monitors)
+        {
+            sources.push_back(monitor->ToSource());
+        }
+        return sources;
+    }
+
+
+    // Checks every pixel of the output against the nearest neighbor of the monitor covering it, or 0 if none.
+    void ExpectComposed(const DesktopCompositor& compositor, const std::vector<SyntheticMonitor*>& monitors)
+    {
+        const auto& bounds = compositor.GetBounds();
+        const auto* buffer = reinterpret_cast<const UINT*>(compositor.GetBuffer());
+        for (LONG y = bounds.top; y < bounds.bottom; ++y)
+        {
+            for (LONG x = bounds.left; x < bounds.right; ++x)
+            {
+                UINT expected = 0;
+                for (const auto monitor : monitors)
+                {
+                    const auto& rect = monitor->rect;
+                    if (x < rect.left || rect.right <= x || y < rect.top || rect.bottom <= y) continue;
+                    const UINT srcX = (x - rect.left) * monitor->width / (rect.right - rect.left);
+                    const UINT srcY = (y - rect.top) * monitor->height / (rect.bottom - rect.top);
+                    expected = monitor->GetPixel(srcX, srcY);
+                }
+
+                const auto actual = buffer[(y - bounds.top) * compositor.GetWidth() + (x - bounds.left)];
+                ASSERT_EQ(actual, expected) << "x=" << x << ", y=" << y;
+            }
+        }
+    }
+}
+
+
+// ---
+
+
+TEST(DesktopCompositorTests, ComposesMonitorsOnNegativeCoordinates)
+{
+    // The secondary monitor is at the left of and above the primary one.
+    SyntheticMonitor primary(0, { 0, 0, 160, 120 }, 160, 120);
+    SyntheticMonitor secondary(1, { -200, -50, 0, 100 }, 200, 150);
+
+    DesktopCompositor compositor;
+    ASSERT_TRUE(compositor.Compose(ToSources({ &primary, &secondary })));
+
+    const auto& bounds = compositor.GetBounds();
+    EXPECT_EQ(bounds.left, -200);
+    EXPECT_EQ(bounds.top, -50);
+    EXPECT_EQ(compositor.GetWidth(), 360u);
+    EXPECT_EQ(compositor.GetHeight(), 170u);
+    EXPECT_EQ(compositor.GetLastCopiedCount(), 2u);
+
+    ExpectComposed(compositor, { &primary, &secondary });
+}
+
+
+TEST(DesktopCompositorTests, ScalesFramesOfMonitorsWithDifferentDpi)
+{
+    // Frames of 150% and 50% of the monitor rects, as given by monitors with a DPI different from the primary one.
+    SyntheticMonitor primary(0, { 0, 0, 160, 120 }, 160, 120);
+    SyntheticMonitor larger(1, { -100, -80, 0, 0 }, 150, 120);
+    SyntheticMonitor smaller(2, { 160, 20, 240, 100 }, 40, 40);
+
+    DesktopCompositor compositor;
+    ASSERT_TRUE(compositor.Compose(ToSources({ &primary, &larger, &smaller })));
+
+    EXPECT_EQ(compositor.GetWidth(), 340u);
+    EXPECT_EQ(compositor.GetHeight(), 200u);
+
+    ExpectComposed(compositor, { &primary, &larger, &smaller });
+}
+
+
+TEST(DesktopCompositorTests, CopiesOnlyChangedMonitors)
+{
+    SyntheticMonitor primary(0, { 0, 0, 64, 48 }, 64, 48);
+    SyntheticMonitor secondary(1, { -64, 0, 0, 48 }, 32, 24);
+
+    DesktopCompositor compositor;
+    ASSERT_TRUE(compositor.Compose(ToSources({ &primary, &secondary })));
+
+    ASSERT_TRUE(compositor.Compose(ToSources({ &primary, &secondary })));
+    EXPECT_EQ(compositor.GetLastCopiedCount(), 0u);
+
+    ++secondary.version;
+    ASSERT_TRUE(compositor.Compose(ToSources({ &primary, &secondary })));
+    EXPECT_EQ(compositor.GetLastCopiedCount(), 1u);
+    EXPECT_EQ(primary.readCount, 1);
+    EXPECT_EQ(secondary.readCount, 2);
+
+    // A frame which could not be read is tried again on the next composition.
+    ++primary.version;
+    primary.isReadable = false;
+    ASSERT_TRUE(compositor.Compose(ToSources({ &primary, &secondary })));
+    EXPECT_EQ(compositor.GetLastCopiedCount(), 0u);
+
+    primary.isReadable = true;
+    ASSERT_TRUE(compositor.Compose(ToSources({ &primary, &secondary })));
+    EXPECT_EQ(compositor.GetLastCopiedCount(), 1u);
+}
+
+
+TEST(DesktopCompositorTests, RedrawsEverythingWhenMonitorsMove)
+{
+    SyntheticMonitor primary(0, { 0, 0, 64, 48 }, 64, 48);
+    SyntheticMonitor secondary(1, { 64, 0, 128, 48 }, 64, 48);
+
+    DesktopCompositor compositor;
+    ASSERT_TRUE(compositor.Compose(ToSources({ &primary, &secondary })));
+
+    // Moving the secondary monitor to the top-left leaves the area it covered before empty.
+    secondary.rect = { -64, -48, 0, 0 };
+    ASSERT_TRUE(compositor.Compose(ToSources({ &primary, &secondary })));
+    EXPECT_EQ(compositor.GetLastCopiedCount(), 2u);
+    EXPECT_EQ(compositor.GetBounds().left, -64);
+    EXPECT_EQ(compositor.GetBounds().top, -48);
+
+    ExpectComposed(compositor, { &primary, &secondary });
+}
+
+
+TEST(DesktopCompositorTests, FailsWithoutMonitors)
+{
+    DesktopCompositor compositor;
+    EXPECT_FALSE(compositor.Compose({}));
+}
\ No newline at end of file
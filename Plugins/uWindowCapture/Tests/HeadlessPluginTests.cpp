@@ -0,0 +1,265 @@
+#include <gtest/gtest.h>
+#include <Windows.h>
+#include <chrono>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Message.h"
+
+
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    constexpr UINT kWindowCount = 4;
+    constexpr UINT kWidth = 64;
+    constexpr UINT kHeight = 32;
+    constexpr auto kTimeout = 5s;
+
+
+    // Drives the built plugin through its exports as a headless host does.
+    class HeadlessPlugin
+    {
+    public:
+        HeadlessPlugin()
+        {
+            const char* path = std::getenv("UWC_PLUGIN_PATH");
+            module_ = ::LoadLibraryA(path ? path : UWC_PLUGIN_PATH);
+            if (!module_) return;
+
+            Load(SetSyntheticWindowBackend, "UwcSetSyntheticWindowBackend");
+            Load(SetHeadless, "UwcSetHeadless");
+            Load(Initialize, "UwcInitialize");
+            Load(Finalize, "UwcFinalize");
+            Load(GetMessageCount, "UwcGetMessageCount");
+            Load(GetMessages, "UwcGetMessages");
+            Load(ClearMessages, "UwcClearMessages");
+            Load(RequestCaptureWindow, "UwcRequestCaptureWindow");
+            Load(RequestCaptureGroup, "UwcRequestCaptureGroup");
+            Load(GetLastReleasedCaptureGroupSequence, "UwcGetLastReleasedCaptureGroupSequence");
+            Load(GetWindowCaptureGroupSequence, "UwcGetWindowCaptureGroupSequence");
+            Load(GetWindowPixels, "UwcGetWindowPixels");
+            Load(GetWindowIdFromPoint, "UwcGetWindowIdFromPoint");
+            Load(GetWindowIdsFromPoints, "UwcGetWindowIdsFromPoints");
+        }
+
+        ~HeadlessPlugin()
+        {
+            if (module_) ::FreeLibrary(module_);
+        }
+
+        bool IsLoaded() const
+        {
+            return module_ && isComplete_;
+        }
+
+        // Moves the messages which have come so far to the given list.
+        void TakeMessages(std::vector<Message>& messages)
+        {
+            const UINT count = GetMessageCount();
+            const Message* head = GetMessages();
+            if (count > 0 && head)
+            {
+                messages.insert(messages.end(), head, head + count);
+            }
+            ClearMessages();
+        }
+
+        void (__stdcall* SetSyntheticWindowBackend)(UINT, UINT, UINT, UINT) = nullptr;
+        void (__stdcall* SetHeadless)(bool) = nullptr;
+        void (__stdcall* Initialize)() = nullptr;
+        void (__stdcall* Finalize)() = nullptr;
+        UINT (__stdcall* GetMessageCount)() = nullptr;
+        const Message* (__stdcall* GetMessages)() = nullptr;
+        void (__stdcall* ClearMessages)() = nullptr;
+        void (__stdcall* RequestCaptureWindow)(int, int) = nullptr;
+        UINT (__stdcall* RequestCaptureGroup)(const int*, int) = nullptr;
+        UINT (__stdcall* GetLastReleasedCaptureGroupSequence)() = nullptr;
+        UINT (__stdcall* GetWindowCaptureGroupSequence)(int) = nullptr;
+        bool (__stdcall* GetWindowPixels)(int, BYTE*, int, int, int, int) = nullptr;
+        int (__stdcall* GetWindowIdFromPoint)(int, int) = nullptr;
+        void (__stdcall* GetWindowIdsFromPoints)(const POINT*, int*, int) = nullptr;
+
+    private:
+        template <class Func>
+        void Load(Func& func, const char* name)
+        {
+            func = reinterpret_cast<Func>(::GetProcAddress(module_, name));
+            if (!func) isComplete_ = false;
+        }
+
+        HMODULE module_ = nullptr;
+        bool isComplete_ = true;
+    };
+
+
+    std::set<int> CollectIds(const std::vector<Message>& messages, MessageType type)
+    {
+        std::set<int> ids;
+        for (const auto& message : messages)
+        {
+            if (message.type == type) ids.insert(message.windowId);
+        }
+        return ids;
+    }
+
+
+    // Initializes the plugin with the synthetic windows in headless mode and waits for all of them to be added.
+    std::set<int> StartHeadless(HeadlessPlugin& plugin)
+    {
+        plugin.SetSyntheticWindowBackend(kWindowCount, kWidth, kHeight, 0);
+        plugin.SetHeadless(true);
+        plugin.Initialize();
+
+        std::vector<Message> messages;
+        std::set<int> ids;
+        const auto deadline = std::chrono::steady_clock::now() + kTimeout;
+        while (ids.size() < kWindowCount && std::chrono::steady_clock::now() < deadline)
+        {
+            plugin.TakeMessages(messages);
+            ids = CollectIds(messages, MessageType::WindowAdded);
+            std::this_thread::sleep_for(10ms);
+        }
+        return ids;
+    }
+
+
+    // Requests regular captures of the windows until all of them are reported as captured and returns the captured ones.
+    std::set<int> CaptureWindows(HeadlessPlugin& plugin, const std::set<int>& ids)
+    {
+        std::vector<Message> messages;
+        plugin.TakeMessages(messages);
+        messages.clear();
+
+        std::set<int> capturedIds;
+        const auto deadline = std::chrono::steady_clock::now() + kTimeout;
+        while (capturedIds != ids && std::chrono::steady_clock::now() < deadline)
+        {
+            for (const int id : ids)
+            {
+                plugin.RequestCaptureWindow(id, 0 /* CapturePriority::High */);
+            }
+            std::this_thread::sleep_for(10ms);
+            plugin.TakeMessages(messages);
+            capturedIds = CollectIds(messages, MessageType::WindowCaptured);
+        }
+        return capturedIds;
+    }
+}
+
+
+// ---
+
+
+TEST(HeadlessPluginTests, CapturesSyntheticWindowsWithoutGraphicsDevice)
+{
+    HeadlessPlugin plugin;
+    if (!plugin.IsLoaded())
+    {
+        GTEST_SKIP() << "The plugin is not built; set UWC_PLUGIN_PATH to uWindowCapture.dll";
+    }
+
+    const auto ids = StartHeadless(plugin);
+    ASSERT_EQ(ids.size(), kWindowCount);
+
+    const auto capturedIds = CaptureWindows(plugin, ids);
+    EXPECT_EQ(capturedIds, ids);
+
+    // Synthetic frames are opaque, either a color made of channels of 64 or more or the white bar.
+    for (const int id : capturedIds)
+    {
+        constexpr int kSize = 8;
+        std::vector<BYTE> pixels(kSize * kSize * 4);
+        ASSERT_TRUE(plugin.GetWindowPixels(id, pixels.data(), 0, 0, kSize, kSize)) << "id=" << id;
+        for (size_t i = 0; i < pixels.size(); i += 4)
+        {
+            EXPECT_GE(pixels[i + 0], 64) << "id=" << id;
+            EXPECT_GE(pixels[i + 1], 64) << "id=" << id;
+            EXPECT_GE(pixels[i + 2], 64) << "id=" << id;
+            EXPECT_EQ(pixels[i + 3], 255) << "id=" << id;
+        }
+    }
+
+    plugin.Finalize();
+}
+
+
+TEST(HeadlessPluginTests, ReleasesCaptureGroupsWithoutRendering)
+{
+    HeadlessPlugin plugin;
+    if (!plugin.IsLoaded())
+    {
+        GTEST_SKIP() << "The plugin is not built; set UWC_PLUGIN_PATH to uWindowCapture.dll";
+    }
+
+    const auto ids = StartHeadless(plugin);
+    ASSERT_EQ(ids.size(), kWindowCount);
+
+    const std::vector<int> groupIds(ids.begin(), ids.end());
+    const UINT sequence = plugin.RequestCaptureGroup(groupIds.data(), static_cast<int>(groupIds.size()));
+    ASSERT_GT(sequence, 0u);
+
+    const auto deadline = std::chrono::steady_clock::now() + kTimeout;
+    while (plugin.GetLastReleasedCaptureGroupSequence() < sequence && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(10ms);
+    }
+    ASSERT_GE(plugin.GetLastReleasedCaptureGroupSequence(), sequence);
+
+    for (const int id : ids)
+    {
+        EXPECT_EQ(plugin.GetWindowCaptureGroupSequence(id), sequence) << "id=" << id;
+    }
+
+    // The members are not held back by the released group anymore.
+    EXPECT_EQ(CaptureWindows(plugin, ids), ids);
+
+    plugin.Finalize();
+}
+
+
+TEST(HeadlessPluginTests, FindsSameWindowsForSingleAndBatchedPoints)
+{
+    HeadlessPlugin plugin;
+    if (!plugin.IsLoaded())
+    {
+        GTEST_SKIP() << "The plugin is not built; set UWC_PLUGIN_PATH to uWindowCapture.dll";
+    }
+
+    const auto ids = StartHeadless(plugin);
+    ASSERT_EQ(ids.size(), kWindowCount);
+
+    // The synthetic windows are cascaded from the origin, so this covers all of them and the area around.
+    std::vector<POINT> points;
+    for (LONG y = -8; y < 160; y += 5)
+    {
+        for (LONG x = -8; x < 192; x += 7)
+        {
+            points.push_back({ x, y });
+        }
+    }
+
+    // The spatial index is built right after the windows have been added.
+    std::vector<int> batchedIds(points.size(), -1);
+    const auto deadline = std::chrono::steady_clock::now() + kTimeout;
+    do
+    {
+        std::this_thread::sleep_for(10ms);
+        plugin.GetWindowIdsFromPoints(points.data(), batchedIds.data(), static_cast<int>(points.size()));
+    }
+    while (std::set<int>(batchedIds.begin(), batchedIds.end()).size() <= kWindowCount && std::chrono::steady_clock::now() < deadline);
+
+    std::set<int> foundIds;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        const int id = plugin.GetWindowIdFromPoint(points[i].x, points[i].y);
+        EXPECT_EQ(batchedIds[i], id) << "x=" << points[i].x << ", y=" << points[i].y;
+        if (id >= 0) foundIds.insert(id);
+    }
+    EXPECT_EQ(foundIds, ids);
+
+    plugin.Finalize();
+}
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include <functional>
+#include <vector>
+#include "RectSet.h"
+
+
+
+namespace
+{
+    bool Contains(const RECT& rect, LONG x, LONG y)
+    {
+        return rect.left <= x && x < rect.right && rect.top <= y && y < rect.bottom;
+    }
+
+
+    // Checks every pixel in the bounds: it must be covered by exactly one rectangle if expected, otherwise by none.
+    void ExpectCoverage(const RectSet& set, const RECT& bounds, const std::function<bool(LONG, LONG)>& isExpected)
+    {
+        for (LONG y = bounds.top; y < bounds.bottom; ++y)
+        {
+            for (LONG x = bounds.left; x < bounds.right; ++x)
+            {
+                int count = 0;
+                for (const auto& rect : set.GetRects())
+                {
+                    if (Contains(rect, x, y)) ++count;
+                }
+                ASSERT_EQ(count, isExpected(x, y) ? 1 : 0) << "x=" << x << ", y=" << y;
+            }
+        }
+    }
+
+
+    float GetVisibleFraction(const RECT& rect, const std::vector<RECT>& monitors, const std::vector<RECT>& occluders)
+    {
+        const auto region = RectSet::GetVisibleRegion(rect, monitors, occluders);
+        const LONGLONG area = static_cast<LONGLONG>(rect.right - rect.left) * (rect.bottom - rect.top);
+        return static_cast<float>(region.GetArea()) / area;
+    }
+}
+
+
+// ---
+
+
+TEST(RectSetTests, UnitesOverlappingRects)
+{
+    const RECT a = { 0, 0, 10, 10 };
+    const RECT b = { 5, 5, 15, 15 };
+    RectSet set(a);
+    set.Unite(b);
+
+    EXPECT_EQ(set.GetArea(), 175);
+    ExpectCoverage(set, { -1, -1, 16, 16 }, [&](LONG x, LONG y) { return Contains(a, x, y) || Contains(b, x, y); });
+}
+
+
+TEST(RectSetTests, UnitesNestedRects)
+{
+    const RECT outer = { 0, 0, 10, 10 };
+    const RECT inner = { 2, 2, 4, 4 };
+
+    RectSet set(outer);
+    set.Unite(inner);
+    EXPECT_EQ(set.GetArea(), 100);
+    ExpectCoverage(set, { -1, -1, 11, 11 }, [&](LONG x, LONG y) { return Contains(outer, x, y); });
+
+    RectSet reversed(inner);
+    reversed.Unite(outer);
+    EXPECT_EQ(reversed.GetArea(), 100);
+    ExpectCoverage(reversed, { -1, -1, 11, 11 }, [&](LONG x, LONG y) { return Contains(outer, x, y); });
+}
+
+
+TEST(RectSetTests, UnitesRectsTouchingAtEdge)
+{
+    RectSet set({ 0, 0, 10, 10 });
+    set.Unite({ 10, 0, 20, 10 });
+
+    EXPECT_EQ(set.GetArea(), 200);
+    EXPECT_EQ(set.GetRects().size(), 2u);
+}
+
+
+TEST(RectSetTests, IgnoresEmptyRects)
+{
+    RectSet set({ 5, 5, 5, 10 });
+    EXPECT_TRUE(set.IsEmpty());
+
+    set.Unite({ 0, 0, 10, 10 });
+    set.Unite({ 3, 3, 3, 3 });
+    set.Subtract({ 4, 0, 2, 10 });
+    EXPECT_EQ(set.GetArea(), 100);
+}
+
+
+TEST(RectSetTests, SubtractsOverlappingRect)
+{
+    const RECT a = { 0, 0, 10, 10 };
+    const RECT b = { 5, 5, 15, 15 };
+    RectSet set(a);
+    set.Subtract(b);
+
+    EXPECT_EQ(set.GetArea(), 75);
+    ExpectCoverage(set, { -1, -1, 16, 16 }, [&](LONG x, LONG y) { return Contains(a, x, y) && !Contains(b, x, y); });
+}
+
+
+TEST(RectSetTests, SubtractsNestedRect)
+{
+    const RECT outer = { 0, 0, 10, 10 };
+    const RECT inner = { 2, 3, 4, 7 };
+    RectSet set(outer);
+    set.Subtract(inner);
+
+    EXPECT_EQ(set.GetArea(), 92);
+    ExpectCoverage(set, { -1, -1, 11, 11 }, [&](LONG x, LONG y) { return Contains(outer, x, y) && !Contains(inner, x, y); });
+
+    set.Subtract(outer);
+    EXPECT_TRUE(set.IsEmpty());
+}
+
+
+TEST(RectSetTests, KeepsRectTouchingSubtractedOneAtEdge)
+{
+    RectSet set({ 0, 0, 10, 10 });
+    set.Subtract({ 10, 0, 20, 10 });
+    set.Subtract({ 0, -10, 10, 0 });
+
+    EXPECT_EQ(set.GetArea(), 100);
+    EXPECT_EQ(set.GetRects().size(), 1u);
+}
+
+
+TEST(RectSetTests, HandlesNegativeCoordinates)
+{
+    const RECT a = { -20, -10, -5, 5 };
+    const RECT b = { -10, -20, 0, 0 };
+    RectSet set(a);
+    set.Subtract(b);
+
+    EXPECT_EQ(set.GetArea(), 175);
+    ExpectCoverage(set, { -21, -21, 1, 6 }, [&](LONG x, LONG y) { return Contains(a, x, y) && !Contains(b, x, y); });
+
+    set.Intersect({ -30, -5, -15, 30 });
+    EXPECT_EQ(set.GetArea(), 50);
+}
+
+
+TEST(RectSetTests, GivesVisibleFractionAcrossMonitors)
+{
+    // The secondary monitor is on the left of the primary one.
+    const std::vector<RECT> monitors = { { 0, 0, 1920, 1080 }, { -1280, 0, 0, 1024 } };
+
+    EXPECT_FLOAT_EQ(GetVisibleFraction({ -100, 0, 100, 100 }, monitors, {}), 1.f);
+    EXPECT_FLOAT_EQ(GetVisibleFraction({ -100, 1000, 100, 1100 }, monitors, {}), (100 * 24 + 100 * 80) / 20000.f);
+    EXPECT_FLOAT_EQ(GetVisibleFraction({ -1380, -50, -1180, 50 }, monitors, {}), 0.25f);
+    EXPECT_FLOAT_EQ(GetVisibleFraction({ 3000, 0, 3100, 100 }, monitors, {}), 0.f);
+}
+
+
+TEST(RectSetTests, CountsMirroredMonitorsOnce)
+{
+    const std::vector<RECT> monitors = { { 0, 0, 1920, 1080 }, { 0, 0, 1920, 1080 }, { 0, 0, 1280, 720 } };
+
+    EXPECT_FLOAT_EQ(GetVisibleFraction({ 0, 0, 100, 100 }, monitors, {}), 1.f);
+}
+
+
+TEST(RectSetTests, GivesVisibleFractionUnderOccluders)
+{
+    const std::vector<RECT> monitors = { { -1920, 0, 1920, 1080 } };
+    const RECT window = { -50, 0, 50, 100 };
+
+    // Overlapping, nested and touching occluders.
+    EXPECT_FLOAT_EQ(GetVisibleFraction(window, monitors, { { 0, 0, 200, 200 } }), 0.5f);
+    EXPECT_FLOAT_EQ(GetVisibleFraction(window, monitors, { { -25, 25, 25, 75 } }), 0.75f);
+    EXPECT_FLOAT_EQ(GetVisibleFraction(window, monitors, { { 50, 0, 150, 100 }, { -50, 100, 50, 200 } }), 1.f);
+
+    // Occluders overlapping each other are not subtracted twice.
+    EXPECT_FLOAT_EQ(GetVisibleFraction(window, monitors, { { -50, 0, 0, 100 }, { -25, 0, 25, 100 } }), 0.25f);
+    EXPECT_FLOAT_EQ(GetVisibleFraction(window, monitors, { { -100, -100, 100, 200 } }), 0.f);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "SnapshotTable.h"
+
+
+
+namespace
+{
+    using Table = SnapshotTable<std::shared_ptr<int>>;
+
+
+    std::vector<int> GetValues(const Table::Snapshot& snapshot)
+    {
+        std::vector<int> values;
+        for (const auto& value : snapshot)
+        {
+            values.push_back(*value);
+        }
+        return values;
+    }
+}
+
+
+// ---
+
+
+TEST(SnapshotTableTests, ReturnsNullUntilPublished)
+{
+    Table table;
+    table.Set(0, std::make_shared<int>(1));
+    EXPECT_EQ(table.Acquire(), nullptr);
+
+    table.Publish();
+    const auto snapshot = table.Acquire();
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_EQ(snapshot->GetSize(), 1u);
+
+    table.Unpublish();
+    EXPECT_EQ(table.Acquire(), nullptr);
+}
+
+
+TEST(SnapshotTableTests, KeepsPublishedVersionsImmutable)
+{
+    Table table;
+    table.Set(1, std::make_shared<int>(1));
+    table.Set(200, std::make_shared<int>(200));
+    table.Publish();
+    const auto first = table.Acquire();
+
+    table.Set(1, std::make_shared<int>(2));
+    table.Reset(200);
+    table.Set(70, std::make_shared<int>(70));
+    table.Publish();
+    const auto second = table.Acquire();
+
+    EXPECT_EQ(GetValues(*first), std::vector<int>({ 1, 200 }));
+    EXPECT_EQ(GetValues(*second), std::vector<int>({ 2, 70 }));
+    EXPECT_EQ(first->GetSize(), 2u);
+    EXPECT_EQ(second->GetSize(), 2u);
+    EXPECT_LT(first->GetVersion(), second->GetVersion());
+    EXPECT_EQ(second->Get(200), nullptr);
+    EXPECT_EQ(second->Get(100000), nullptr);
+}
+
+
+TEST(SnapshotTableTests, SharesUnchangedEntriesBetweenVersions)
+{
+    Table table;
+    table.Set(0, std::make_shared<int>(0));
+    table.Set(100, std::make_shared<int>(100));
+    table.Publish();
+    const auto first = table.Acquire();
+
+    table.Set(0, std::make_shared<int>(1));
+    table.Publish();
+    const auto second = table.Acquire();
+
+    EXPECT_NE(first->Get(0), second->Get(0));
+
+    // The chunk of the unchanged entry is not copied, so the entry itself is the same one.
+    EXPECT_EQ(&first->Get(100), &second->Get(100));
+    EXPECT_EQ(second->Get(100).use_count(), 1);
+}
+
+
+TEST(SnapshotTableTests, ReadersSeeConsistentVersionsWhilePublishing)
+{
+    constexpr size_t kCount = 256;
+    constexpr int kPublishCount = 2000;
+
+    // Every version holds kCount entries which all have the value of the version.
+    Table table;
+    for (size_t i = 0; i < kCount; ++i)
+    {
+        table.Set(i, std::make_shared<int>(0));
+    }
+    table.Publish();
+
+    std::atomic<bool> isDone = false;
+    std::atomic<int> errorCount = 0;
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i)
+    {
+        readers.emplace_back([&]
+        {
+            int lastValue = 0;
+            while (!isDone)
+            {
+                const auto snapshot = table.Acquire();
+                const int value = *snapshot->Get(0);
+                if (value < lastValue || snapshot->GetSize() != kCount) ++errorCount;
+                for (const auto& entry : *snapshot)
+                {
+                    if (*entry != value) ++errorCount;
+                }
+                lastValue = value;
+            }
+        });
+    }
+
+    for (int version = 1; version <= kPublishCount; ++version)
+    {
+        for (size_t i = 0; i < kCount; ++i)
+        {
+            table.Set(i, std::make_shared<int>(version));
+        }
+        table.Publish();
+    }
+
+    isDone = true;
+    for (auto& reader : readers) reader.join();
+
+    EXPECT_EQ(errorCount, 0);
+    EXPECT_EQ(*table.Acquire()->Get(kCount - 1), kPublishCount);
+}
\ No newline at end of file
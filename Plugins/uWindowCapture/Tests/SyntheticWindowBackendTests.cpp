@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "SyntheticWindowBackend.h"
+#include "WindowSpatialIndex.h"
+
+
+
+namespace
+{
+    std::vector<WindowData> Enumerate(SyntheticWindowBackend& backend)
+    {
+        std::vector<WindowData> windows;
+        backend.EnumerateWindows(windows);
+        return windows;
+    }
+}
+
+
+// ---
+
+
+TEST(SyntheticWindowBackendTests, EnumeratesWindowsFromTheFront)
+{
+    SyntheticWindowBackend backend({ 3, 64, 32, 0 });
+    const auto windows = Enumerate(backend);
+
+    ASSERT_EQ(windows.size(), 3u);
+    for (UINT i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ(windows[i].zOrder, i);
+        EXPECT_FALSE(windows[i].isDesktop);
+        EXPECT_TRUE(backend.IsWindow(windows[i].hWnd));
+        EXPECT_TRUE(backend.IsWindowVisible(windows[i].hWnd));
+    }
+}
+
+
+TEST(SyntheticWindowBackendTests, HandlesAreOutsideOfTheRangeOfRealWindows)
+{
+#if UINTPTR_MAX > 0xffffffff
+    SyntheticWindowBackend backend({ 4, 64, 32, 0 });
+    for (const auto& data : Enumerate(backend))
+    {
+        EXPECT_GT(reinterpret_cast<UINT_PTR>(data.hWnd), static_cast<UINT_PTR>(0xffffffff));
+    }
+#else
+    GTEST_SKIP() << "32-bit builds have no free handle range";
+#endif
+}
+
+
+TEST(SyntheticWindowBackendTests, AnswersPerWindowQueries)
+{
+    SyntheticWindowBackend backend({ 2, 64, 32, 0 });
+    const auto windows = Enumerate(backend);
+
+    WindowAttributes first, second;
+    ASSERT_TRUE(backend.GetWindowAttributes(windows[0].hWnd, first));
+    ASSERT_TRUE(backend.GetWindowAttributes(windows[1].hWnd, second));
+    EXPECT_EQ(first.processId, Platform::GetCurrentProcessId());
+    EXPECT_EQ(first.hParent, nullptr);
+    EXPECT_FALSE(first.className.empty());
+    EXPECT_NE(first.threadId, second.threadId);
+
+    std::wstring title;
+    EXPECT_TRUE(backend.GetWindowTitle(windows[0].hWnd, title));
+    EXPECT_FALSE(title.empty());
+
+    EXPECT_TRUE(backend.GetWindowState(windows[0].hWnd, WindowState::Enabled));
+    EXPECT_FALSE(backend.GetWindowState(windows[0].hWnd, WindowState::Iconic));
+    EXPECT_FALSE(backend.GetWindowState(windows[0].hWnd, WindowState::Cloaked));
+    EXPECT_FALSE(backend.HasIcons());
+}
+
+
+TEST(SyntheticWindowBackendTests, FindsFrontmostWindowAtPoint)
+{
+    SyntheticWindowBackend backend({ 2, 64, 32, 0 });
+    const auto windows = Enumerate(backend);
+
+    // The second window is cascaded to the bottom right of the first one.
+    EXPECT_EQ(backend.GetWindowFromPoint({ 30, 30 }), windows[0].hWnd);
+    EXPECT_EQ(backend.GetWindowFromPoint({ 80, 50 }), windows[1].hWnd);
+    EXPECT_EQ(backend.GetWindowFromPoint({ 200, 200 }), nullptr);
+    EXPECT_EQ(backend.GetParentWindow(windows[0].hWnd), nullptr);
+}
+
+
+TEST(SyntheticWindowBackendTests, HitTestAgreesWithSpatialIndex)
+{
+    SyntheticWindowBackend backend({ 40, 64, 32, 0 });
+    const auto windows = Enumerate(backend);
+
+    // Indexed as WindowManager::UpdateSpatialIndex() does, with the enumeration order as the ids.
+    RECT bounds = {};
+    std::vector<WindowSpatialIndex::Entry> entries;
+    for (UINT i = 0; i < windows.size(); ++i)
+    {
+        ::UnionRect(&bounds, &bounds, &windows[i].windowRect);
+        entries.push_back({ static_cast<int>(i), windows[i].zOrder, windows[i].windowRect });
+    }
+    WindowSpatialIndex index;
+    index.Build(bounds, std::move(entries));
+
+    std::vector<POINT> points;
+    for (LONG y = -8; y < bounds.bottom + 8; y += 5)
+    {
+        for (LONG x = -8; x < bounds.right + 8; x += 7)
+        {
+            points.push_back({ x, y });
+        }
+    }
+    std::vector<int> ids(points.size());
+    index.Find(points.data(), ids.data(), static_cast<int>(points.size()));
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        const auto hWnd = backend.GetWindowFromPoint(points[i]);
+        const auto expected = (ids[i] >= 0) ? windows[ids[i]].hWnd : nullptr;
+        EXPECT_EQ(hWnd, expected) << "x=" << points[i].x << ", y=" << points[i].y;
+    }
+}
+
+
+TEST(SyntheticWindowBackendTests, RejectsUnknownHandles)
+{
+    SyntheticWindowBackend backend({ 1, 64, 32, 0 });
+    const auto hWnd = reinterpret_cast<HWND>(static_cast<UINT_PTR>(0x1234));
+
+    WindowAttributes attributes;
+    std::wstring title;
+    Buffer<BYTE> buffer;
+    UINT width = 0, height = 0;
+    EXPECT_FALSE(backend.IsWindow(hWnd));
+    EXPECT_FALSE(backend.GetWindowAttributes(hWnd, attributes));
+    EXPECT_FALSE(backend.GetWindowTitle(hWnd, title));
+    EXPECT_FALSE(backend.GetWindowState(hWnd, WindowState::Enabled));
+    EXPECT_FALSE(backend.CaptureFrame(hWnd, buffer, width, height));
+}
+
+
+TEST(SyntheticWindowBackendTests, CapturesFramesOfTheConfiguredSize)
+{
+    SyntheticWindowBackend backend({ 1, 64, 32, 0 });
+    const auto windows = Enumerate(backend);
+
+    Buffer<BYTE> buffer;
+    UINT width = 0, height = 0;
+    ASSERT_TRUE(backend.CaptureFrame(windows[0].hWnd, buffer, width, height));
+    EXPECT_EQ(width, 64u);
+    EXPECT_EQ(height, 32u);
+    EXPECT_GE(buffer.Size(), width * height * 4);
+}
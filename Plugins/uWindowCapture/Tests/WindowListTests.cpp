@@ -0,0 +1,313 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "WindowList.h"
+
+
+
+namespace
+{
+    HWND ToHandle(UINT_PTR value)
+    {
+        return reinterpret_cast<HWND>(value * 4);
+    }
+
+
+    WindowData MakeWindow(UINT_PTR hWnd, UINT zOrder, UINT_PTR hOwner = 0)
+    {
+        WindowData data = {};
+        data.hWnd = ToHandle(hWnd);
+        data.hOwner = hOwner ? ToHandle(hOwner) : NULL;
+        data.windowRect = { 0, 0, 100, 100 };
+        data.clientRect = { 0, 0, 100, 100 };
+        data.zOrder = zOrder;
+        return data;
+    }
+
+
+    WindowData MakeDesktop(UINT_PTR hMonitor)
+    {
+        WindowData data = {};
+        data.isDesktop = TRUE;
+        data.hWnd = ToHandle(1);
+        data.hMonitor = reinterpret_cast<HMONITOR>(hMonitor);
+        return data;
+    }
+
+
+    // Gives ids in the order of the additions and records what the list reports.
+    class TestListener : public WindowList::Listener
+    {
+    public:
+        struct ThreadInfo
+        {
+            DWORD processId;
+            DWORD threadId;
+            bool isAltTab;
+            HWND hParent = NULL;
+        };
+
+        bool OnWindowAdding(WindowList::Node& node) override
+        {
+            node.id = nextId++;
+            const auto it = threads.find(node.data.hWnd);
+            if (it != threads.end())
+            {
+                node.processId = it->second.processId;
+                node.threadId = it->second.threadId;
+                node.isAltTab = it->second.isAltTab;
+                node.hParent = it->second.hParent;
+            }
+            return true;
+        }
+
+        void OnWindowAdded(const WindowList::Node& node) override
+        {
+            added.push_back(node.id);
+            parents[node.id] = node.parentId;
+            if (list && list->FindParentByScan(node) != node.parentId)
+            {
+                ++parentMismatchCount;
+            }
+        }
+
+        void OnWindowUpdated(const WindowList::Node& node, const WindowData&, bool hasOrderChanged) override
+        {
+            updated.push_back(node.id);
+            if (hasOrderChanged)
+            {
+                reordered.push_back(node.id);
+            }
+        }
+
+        void OnWindowRemoved(const WindowList::Node& node) override
+        {
+            removed.push_back(node.id);
+        }
+
+        void Clear()
+        {
+            added.clear();
+            updated.clear();
+            reordered.clear();
+            removed.clear();
+        }
+
+        // Checks the parent of each added node against the scan if given.
+        const WindowList* list = nullptr;
+        int parentMismatchCount = 0;
+
+        int nextId = 0;
+        std::unordered_map<HWND, ThreadInfo> threads;
+        std::unordered_map<int, int> parents;
+        std::vector<int> added;
+        std::vector<int> updated;
+        std::vector<int> reordered;
+        std::vector<int> removed;
+    };
+}
+
+
+// ---
+
+
+TEST(WindowListTests, AddsWindowsInEnumerationOrder)
+{
+    WindowList list;
+    TestListener listener;
+
+    list.Update({ MakeWindow(30, 0), MakeWindow(10, 1), MakeWindow(20, 2) }, listener);
+
+    EXPECT_EQ(list.GetSize(), 3u);
+    EXPECT_EQ(listener.added, (std::vector<int>{ 0, 1, 2 }));
+    EXPECT_TRUE(listener.updated.empty());
+    EXPECT_TRUE(listener.removed.empty());
+}
+
+
+TEST(WindowListTests, KeepsExistingWindowsAndRemovesMissingOnes)
+{
+    WindowList list;
+    TestListener listener;
+
+    list.Update({ MakeWindow(10, 0), MakeWindow(20, 1), MakeWindow(30, 2) }, listener);
+    listener.Clear();
+
+    list.Update({ MakeWindow(30, 0), MakeWindow(40, 1), MakeWindow(10, 2) }, listener);
+
+    EXPECT_EQ(list.GetSize(), 3u);
+    EXPECT_EQ(listener.added, (std::vector<int>{ 3 }));
+    EXPECT_EQ(listener.updated, (std::vector<int>{ 0, 2 }));
+    EXPECT_EQ(listener.removed, (std::vector<int>{ 1 }));
+}
+
+
+TEST(WindowListTests, ReportsOrderChangesOnlyWhenWindowAboveChanges)
+{
+    WindowList list;
+    TestListener listener;
+
+    list.Update({ MakeWindow(10, 3), MakeWindow(20, 2), MakeWindow(30, 1), MakeWindow(40, 0) }, listener);
+    listener.Clear();
+
+    // Every z-order shifts, but the windows kept stay in the same order.
+    list.Update({ MakeWindow(50, 3), MakeWindow(10, 2), MakeWindow(20, 1), MakeWindow(30, 0) }, listener);
+    EXPECT_EQ(listener.updated, (std::vector<int>{ 0, 1, 2 }));
+    EXPECT_TRUE(listener.reordered.empty());
+    listener.Clear();
+
+    // Bringing 30 to the front changes the window above 30 and above 50 only.
+    list.Update({ MakeWindow(30, 3), MakeWindow(50, 2), MakeWindow(10, 1), MakeWindow(20, 0) }, listener);
+    EXPECT_EQ(listener.updated, (std::vector<int>{ 0, 1, 2, 4 }));
+    EXPECT_EQ(listener.reordered, (std::vector<int>{ 2, 4 }));
+}
+
+
+TEST(WindowListTests, TakesFirstOfDuplicatedWindows)
+{
+    WindowList list;
+    TestListener listener;
+
+    list.Update({ MakeWindow(10, 0), MakeWindow(10, 1) }, listener);
+
+    EXPECT_EQ(list.GetSize(), 1u);
+    EXPECT_EQ(listener.added, (std::vector<int>{ 0 }));
+}
+
+
+TEST(WindowListTests, KeysDesktopsByMonitor)
+{
+    WindowList list;
+    TestListener listener;
+
+    list.Update({ MakeDesktop(1), MakeDesktop(2) }, listener);
+    EXPECT_EQ(list.GetSize(), 2u);
+
+    listener.Clear();
+    list.Update({ MakeDesktop(2) }, listener);
+    EXPECT_EQ(listener.updated, (std::vector<int>{ 1 }));
+    EXPECT_EQ(listener.removed, (std::vector<int>{ 0 }));
+}
+
+
+TEST(WindowListTests, ResolvesOwnerAsParent)
+{
+    WindowList list;
+    TestListener listener;
+
+    // The owner is given first as in the enumeration.
+    list.Update({ MakeWindow(10, 1), MakeWindow(20, 0, 10) }, listener);
+
+    EXPECT_EQ(listener.parents[0], -1);
+    EXPECT_EQ(listener.parents[1], 0);
+}
+
+
+TEST(WindowListTests, ResolvesNearestWindowOfSameThreadAsParent)
+{
+    WindowList list;
+    TestListener listener;
+    listener.threads[ToHandle(10)] = { 1, 1, true };
+    listener.threads[ToHandle(20)] = { 1, 1, true };
+    listener.threads[ToHandle(30)] = { 1, 1, false };
+    listener.threads[ToHandle(40)] = { 2, 2, true };
+
+    list.Update({ MakeWindow(10, 3), MakeWindow(20, 2), MakeWindow(40, 1) }, listener);
+    list.Update({ MakeWindow(10, 4), MakeWindow(20, 3), MakeWindow(40, 2), MakeWindow(30, 0) }, listener);
+
+    EXPECT_EQ(listener.parents[3], 1);
+}
+
+
+TEST(WindowListTests, FindsSameParentsAsScanOverRandomUpdates)
+{
+    constexpr UINT_PTR kHandleCount = 64;
+    constexpr int kPassCount = 200;
+    constexpr int kProbeCount = 32;
+
+    std::mt19937 random(1234);
+    const auto next = [&](UINT range) { return static_cast<UINT>(random() % range); };
+
+    WindowList list;
+    TestListener listener;
+    listener.list = &list;
+
+    // A few threads whose windows own each other at random, so that every rule of the lookup is hit.
+    std::unordered_map<UINT_PTR, UINT_PTR> owners;
+    for (UINT_PTR hWnd = 1; hWnd <= kHandleCount; ++hWnd)
+    {
+        const auto processId = 1 + next(2);
+        const auto threadId = 1 + next(3);
+        const auto hParent = next(4) == 0 ? ToHandle(1 + next(kHandleCount)) : NULL;
+        listener.threads[ToHandle(hWnd)] = { processId, threadId, next(2) == 0, hParent };
+        owners[hWnd] = next(3) == 0 ? 1 + next(kHandleCount) : 0;
+    }
+
+    for (int pass = 0; pass < kPassCount; ++pass)
+    {
+        std::vector<UINT_PTR> handles;
+        for (UINT_PTR hWnd = 1; hWnd <= kHandleCount; ++hWnd)
+        {
+            if (next(10) < 7) handles.push_back(hWnd);
+        }
+        std::shuffle(handles.begin(), handles.end(), random);
+
+        std::vector<WindowData> dataList;
+        for (const auto hWnd : handles)
+        {
+            dataList.push_back(MakeWindow(hWnd, static_cast<UINT>(dataList.size()), owners[hWnd]));
+        }
+        list.Update(dataList, listener);
+
+        // The indices must also stay in sync for windows which are not in the list.
+        for (int i = 0; i < kProbeCount; ++i)
+        {
+            WindowList::Node node;
+            node.data = MakeWindow(kHandleCount + 1, next(kHandleCount), 1 + next(kHandleCount));
+            node.hParent = ToHandle(1 + next(kHandleCount));
+            node.processId = 1 + next(2);
+            node.threadId = 1 + next(3);
+            EXPECT_EQ(list.FindParent(node), list.FindParentByScan(node)) << "pass=" << pass;
+        }
+    }
+
+    EXPECT_GT(listener.added.size(), kHandleCount);
+    EXPECT_EQ(listener.parentMismatchCount, 0);
+}
+
+
+TEST(WindowListTests, ReconcilesThousandsOfWindows)
+{
+    for (const UINT count : { 1000u, 5000u, 10000u })
+    {
+        WindowList list;
+        TestListener listener;
+
+        std::vector<WindowData> dataList;
+        for (UINT i = 0; i < count; ++i)
+        {
+            dataList.push_back(MakeWindow(i + 1, i));
+        }
+        list.Update(dataList, listener);
+        ASSERT_EQ(list.GetSize(), count);
+        ASSERT_EQ(listener.added.size(), count);
+        listener.Clear();
+
+        // Replaces every tenth window as the benchmark does.
+        UINT replacedCount = 0;
+        for (UINT i = 0; i < count; i += 10, ++replacedCount)
+        {
+            dataList[i] = MakeWindow(count + i + 1, i);
+        }
+        list.Update(dataList, listener);
+
+        EXPECT_EQ(list.GetSize(), count) << "count=" << count;
+        EXPECT_EQ(listener.added.size(), replacedCount) << "count=" << count;
+        EXPECT_EQ(listener.removed.size(), replacedCount) << "count=" << count;
+        EXPECT_EQ(listener.updated.size(), count - replacedCount) << "count=" << count;
+        // The windows kept stay in the same order.
+        EXPECT_TRUE(listener.reordered.empty()) << "count=" << count;
+    }
+}
\ No newline at end of file
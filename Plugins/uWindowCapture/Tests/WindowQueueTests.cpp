@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+#include "WindowQueue.h"
+
+
+
+TEST(WindowQueueTests, DequeuesInRequestOrder)
+{
+    WindowQueue queue;
+    queue.Enqueue(1);
+    queue.Enqueue(2);
+    queue.Enqueue(3);
+
+    EXPECT_EQ(queue.Dequeue(), 1);
+    EXPECT_EQ(queue.Dequeue(), 2);
+    EXPECT_EQ(queue.Dequeue(), 3);
+    EXPECT_EQ(queue.Dequeue(), -1);
+    EXPECT_TRUE(queue.Empty());
+}
+
+
+TEST(WindowQueueTests, IgnoresQueuedWindows)
+{
+    WindowQueue queue;
+    queue.Enqueue(1);
+    queue.Enqueue(2);
+    queue.Enqueue(1);
+
+    EXPECT_EQ(queue.Dequeue(), 1);
+    EXPECT_EQ(queue.Dequeue(), 2);
+    EXPECT_EQ(queue.Dequeue(), -1);
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "WindowZOrderCounter.h"
+
+
+
+namespace
+{
+    struct SyntheticWindow
+    {
+        UINT_PTR hWnd;
+        bool isVisible;
+    };
+
+
+    HWND ToHandle(UINT_PTR value)
+    {
+        return reinterpret_cast<HWND>(value * 4);
+    }
+
+
+    // The number of visible windows above the given one in the current z-order as ::GetWindowZOrder() walks it.
+    UINT GetZOrder(const std::vector<SyntheticWindow>& zOrderList, UINT_PTR hWnd)
+    {
+        UINT zOrder = 0;
+        for (const auto& window : zOrderList)
+        {
+            if (window.hWnd == hWnd) break;
+            if (window.isVisible) ++zOrder;
+        }
+        return zOrder;
+    }
+
+
+    HWND GetPrevWindow(const std::vector<SyntheticWindow>& zOrderList, UINT_PTR hWnd)
+    {
+        HWND hPrev = NULL;
+        for (const auto& window : zOrderList)
+        {
+            if (window.hWnd == hWnd) break;
+            hPrev = ToHandle(window.hWnd);
+        }
+        return hPrev;
+    }
+
+
+    // Counts the windows given by the enumeration as Win32WindowBackend does, while the z-order may differ from it.
+    std::vector<UINT> Count(
+        WindowZOrderCounter& counter,
+        const std::vector<SyntheticWindow>& enumerated,
+        const std::vector<SyntheticWindow>& zOrderList,
+        int* walkCount = nullptr)
+    {
+        std::vector<UINT> zOrders;
+        counter.Reset();
+        for (const auto& window : enumerated)
+        {
+            const auto hWnd = ToHandle(window.hWnd);
+            if (counter.IsNextOf(GetPrevWindow(zOrderList, window.hWnd)))
+            {
+                zOrders.push_back(counter.Add(hWnd, window.isVisible));
+            }
+            else
+            {
+                if (walkCount) ++*walkCount;
+                zOrders.push_back(counter.Add(hWnd, window.isVisible, GetZOrder(zOrderList, window.hWnd)));
+            }
+        }
+        return zOrders;
+    }
+}
+
+
+// ---
+
+
+TEST(WindowZOrderCounterTests, CountsVisibleWindowsAbove)
+{
+    const std::vector<SyntheticWindow> windows =
+    {
+        { 1, true }, { 2, false }, { 3, true }, { 4, true }, { 5, false }, { 6, true },
+    };
+
+    WindowZOrderCounter counter;
+    int walkCount = 0;
+    const auto zOrders = Count(counter, windows, windows, &walkCount);
+
+    EXPECT_EQ(zOrders, (std::vector<UINT>{ 0, 1, 1, 2, 3, 3 }));
+    EXPECT_EQ(walkCount, 0);
+}
+
+
+TEST(WindowZOrderCounterTests, TracksLastWindow)
+{
+    WindowZOrderCounter counter;
+    EXPECT_TRUE(counter.IsNextOf(NULL));
+
+    counter.Add(ToHandle(1), true);
+    EXPECT_TRUE(counter.IsNextOf(ToHandle(1)));
+    EXPECT_FALSE(counter.IsNextOf(NULL));
+
+    counter.Add(ToHandle(2), false);
+    EXPECT_TRUE(counter.IsNextOf(ToHandle(2)));
+
+    counter.Reset();
+    EXPECT_TRUE(counter.IsNextOf(NULL));
+    EXPECT_EQ(counter.Add(ToHandle(3), true), 0u);
+}
+
+
+TEST(WindowZOrderCounterTests, ResumesCountingFromWalkedZOrder)
+{
+    // Window 2 has been brought to the front during the enumeration which has already given window 1.
+    const std::vector<SyntheticWindow> enumerated =
+    {
+        { 1, true }, { 3, true }, { 4, false }, { 5, true },
+    };
+    const std::vector<SyntheticWindow> zOrderList =
+    {
+        { 2, true }, { 1, true }, { 3, true }, { 4, false }, { 5, true },
+    };
+
+    WindowZOrderCounter counter;
+    int walkCount = 0;
+    const auto zOrders = Count(counter, enumerated, zOrderList, &walkCount);
+
+    // Only the first window is walked, the rest follow it in the chain.
+    EXPECT_EQ(zOrders, (std::vector<UINT>{ 1, 2, 3, 3 }));
+    EXPECT_EQ(walkCount, 1);
+}
+
+
+TEST(WindowZOrderCounterTests, MatchesWalkOverShuffledEnumerations)
+{
+    constexpr UINT_PTR kWindowCount = 32;
+
+    std::vector<SyntheticWindow> zOrderList;
+    for (UINT_PTR hWnd = 1; hWnd <= kWindowCount; ++hWnd)
+    {
+        zOrderList.push_back({ hWnd, hWnd % 3 != 0 });
+    }
+
+    // Swaps neighbours so that the enumeration falls out of the chain here and there.
+    WindowZOrderCounter counter;
+    for (UINT_PTR stride = 2; stride < kWindowCount; ++stride)
+    {
+        auto enumerated = zOrderList;
+        for (size_t i = 0; i + 1 < enumerated.size(); i += stride)
+        {
+            std::swap(enumerated[i], enumerated[i + 1]);
+        }
+
+        const auto zOrders = Count(counter, enumerated, zOrderList);
+        for (size_t i = 0; i < enumerated.size(); ++i)
+        {
+            EXPECT_EQ(zOrders[i], GetZOrder(zOrderList, enumerated[i].hWnd)) << "stride=" << stride << ", i=" << i;
+        }
+    }
+}
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include "Platform.h"
+#include "Debug.h"
 
 
 template <class T>
@@ -0,0 +1,44 @@
+#include "CaptureGroup.h"
+
+
+
+CaptureGroup::CaptureGroup(UINT sequence, std::vector<int>&& ids)
+    : sequence_(sequence)
+    , ids_(std::move(ids))
+    , remainingIds_(ids_.begin(), ids_.end())
+{
+}
+
+
+void CaptureGroup::Start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // The timestamp is in microseconds of the steady clock shared by all members.
+    startTime_ = std::chrono::steady_clock::now();
+    timestamp_ = std::chrono::duration_cast<std::chrono::microseconds>(startTime_.time_since_epoch()).count();
+    isStarted_ = true;
+}
+
+
+void CaptureGroup::FinishMember(int id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    remainingIds_.erase(id);
+}
+
+
+int CaptureGroup::GetRemainingCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(remainingIds_.size());
+}
+
+
+bool CaptureGroup::IsExpired(std::chrono::milliseconds timeout) const
+{
+    if (!isStarted_) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::chrono::steady_clock::now() - startTime_ > timeout;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Platform.h"
+#include <vector>
+#include <unordered_set>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+
+
+// A set of windows captured at the same instant. The frames of the members are held back
+// until all of them have been uploaded (or given up) and are then rendered in the same frame.
+class CaptureGroup
+{
+public:
+    CaptureGroup(UINT sequence, std::vector<int>&& ids);
+
+    UINT GetSequence() const { return sequence_; }
+    const std::vector<int>& GetIds() const { return ids_; }
+    ULONGLONG GetTimestamp() const { return timestamp_; }
+    void Start();
+
+    void FinishMember(int id);
+    int GetRemainingCount() const;
+    bool IsExpired(std::chrono::milliseconds timeout) const;
+
+    bool IsReleased() const { return isReleased_; }
+    void Release() { isReleased_ = true; }
+
+private:
+    const UINT sequence_;
+    const std::vector<int> ids_;
+    std::chrono::steady_clock::time_point startTime_;
+    std::atomic<ULONGLONG> timestamp_ = 0;
+    std::atomic<bool> isStarted_ = false;
+    std::atomic<bool> isReleased_ = false;
+    std::unordered_set<int> remainingIds_;
+    mutable std::mutex mutex_;
+};
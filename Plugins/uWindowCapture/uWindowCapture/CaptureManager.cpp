@@ -2,6 +2,7 @@
 #include "CaptureManager.h"
 #include "WindowManager.h"
 #include "Window.h"
+#include "TraceRecorder.h"
 #include "Debug.h"
 #include "Util.h"
 
@@ -12,6 +13,7 @@ using namespace Microsoft::WRL;
 namespace
 {
     constexpr auto kLoopMinTime = std::chrono::microseconds(100);
+    constexpr auto kCaptureGroupTimeout = std::chrono::milliseconds(1000);
 }
 
 
@@ -30,34 +32,33 @@ CaptureManager::CaptureManager()
 
     windowCaptureThreadLoop_.Start([this] 
     {
-        // at first, check the high-priority queue.
-        int id = highPriorityQueue_.Dequeue();
+        bool hasWorked = false;
 
-        // move an item in the mid-priority queue to the high-priority queue to give a chance to it.
-        if (id >= 0 && !middlePriorityQueue_.Empty())
+        // capture groups go first since their members should be captured back-to-back.
+        if (const auto group = PopCaptureGroup())
         {
-            const auto midId = middlePriorityQueue_.Dequeue();
-            highPriorityQueue_.Enqueue(midId);
+            CaptureGroupMembers(group);
+            hasWorked = true;
         }
 
-        // second, check the mid-priority queue.
-        if (id < 0)
+        // nothing is rendered in headless mode, so the groups are released here instead.
+        if (WindowManager::IsHeadless())
         {
-            id = middlePriorityQueue_.Dequeue();
+            ReleaseCaptureGroups();
         }
 
-        // at last, check the low-priority queue.
-        if (id < 0)
-        {
-            id = lowPriorityQueue_.Dequeue();
-        }
+        // then, the requested windows in the order of their priorities.
+        const int id = scheduler_.Pop();
 
         // update the window if needed.
+        // a capture which can block runs in a worker thread so that a hung window cannot block this loop.
         if (id >= 0)
         {
             if (auto window = WindowManager::Get().GetWindow(id))
             {
-                window->Capture();
+                const auto alive = captureWatchdog_.GetAliveToken();
+                captureWatchdog_.Run(id, [window, alive] { window->Capture(*alive); }, window->CanCaptureBlock());
+                hasWorked = true;
             }
         }
 
@@ -65,6 +66,8 @@ CaptureManager::CaptureManager()
         {
             wgcManager->UpdateFromCaptureThread();
         }
+
+        return hasWorked;
     }, kLoopMinTime);
 
     iconCaptureThreadLoop_.Start([this] 
@@ -75,8 +78,10 @@ CaptureManager::CaptureManager()
             if (auto window = WindowManager::Get().GetWindow(id))
             {
                 window->CaptureIcon();
+                return true;
             }
         }
+        return false;
     }, kLoopMinTime);
 }
 
@@ -90,28 +95,156 @@ CaptureManager::~CaptureManager()
 
 void CaptureManager::RequestCapture(int id, CapturePriority priority)
 {
-    switch (priority)
+    const auto window = WindowManager::Get().GetWindow(id);
+
+    // A request keeps the capture resources of the window alive even if it is throttled below.
+    if (window)
+    {
+        window->RenewCaptureLease();
+    }
+
+    scheduler_.Request(id, priority, window && window->IsOccluded());
+}
+
+
+void CaptureManager::RequestCaptureIcon(int id)
+{
+    iconQueue_.Enqueue(id);
+}
+
+
+UINT CaptureManager::RequestCaptureGroup(const int* ids, int count)
+{
+    if (count <= 0) return 0;
+
+    std::vector<int> groupIds(ids, ids + count);
+    std::sort(groupIds.begin(), groupIds.end());
+    groupIds.erase(std::unique(groupIds.begin(), groupIds.end()), groupIds.end());
+
+    const UINT sequence = ++lastCaptureGroupSequence_;
+    {
+        std::lock_guard<std::mutex> lock(captureGroupMutex_);
+        requestedCaptureGroups_.push_back(std::make_shared<CaptureGroup>(sequence, std::move(groupIds)));
+    }
+    windowCaptureThreadLoop_.Wake();
+
+    return sequence;
+}
+
+
+std::shared_ptr<CaptureGroup> CaptureManager::PopCaptureGroup()
+{
+    std::lock_guard<std::mutex> lock(captureGroupMutex_);
+
+    if (requestedCaptureGroups_.empty()) return nullptr;
+
+    auto group = requestedCaptureGroups_.front();
+    requestedCaptureGroups_.pop_front();
+    activeCaptureGroups_.push_back(group);
+
+    return group;
+}
+
+
+void CaptureManager::CaptureGroupMembers(const std::shared_ptr<CaptureGroup>& group)
+{
+    UWC_SCOPE_TIMER(CaptureGroupMembers)
+    UWC_TRACE_SCOPE("CaptureGroup", -1)
+
+    std::vector<CaptureWatchdog::Task> tasks;
+    tasks.reserve(group->GetIds().size());
+    const auto alive = captureWatchdog_.GetAliveToken();
+
+    for (const int id : group->GetIds())
     {
-        case CapturePriority::High:
+        const auto window = WindowManager::Get().GetWindow(id);
+        if (!window)
         {
-            highPriorityQueue_.Enqueue(id);
-            break;
+            group->FinishMember(id);
+            continue;
         }
-        case CapturePriority::Middle:
+
+        window->RenewCaptureLease();
+        tasks.push_back({ id, [window, group, alive] { window->CaptureInGroup(group, *alive); }, window->CanCaptureBlock(), false });
+    }
+
+    // members which can block are captured in parallel as far as the workers allow.
+    group->Start();
+    captureWatchdog_.RunParallel(tasks);
+
+    // stalled or quarantined members are not waited for.
+    for (const auto& task : tasks)
+    {
+        if (!task.isDone)
         {
-            middlePriorityQueue_.Enqueue(id);
-            break;
+            group->FinishMember(task.id);
         }
-        case CapturePriority::Low:
+    }
+}
+
+
+void CaptureManager::ReleaseCaptureGroups()
+{
+    // Run this scope in the unity rendering thread before the windows are rendered
+    // so that all members of a group are rendered in the same frame,
+    // or in the window capture thread in headless mode.
+    std::vector<std::shared_ptr<CaptureGroup>> releasedGroups;
+    UINT releasedSequence = 0;
+    {
+        std::lock_guard<std::mutex> lock(captureGroupMutex_);
+
+        for (auto it = activeCaptureGroups_.begin(); it != activeCaptureGroups_.end();)
         {
-            lowPriorityQueue_.Enqueue(id);
-            break;
+            const auto& group = *it;
+            if (group->GetRemainingCount() > 0 && !group->IsExpired(kCaptureGroupTimeout))
+            {
+                ++it;
+                continue;
+            }
+
+            group->Release();
+            releasedSequence = max(releasedSequence, group->GetSequence());
+            releasedGroups.push_back(group);
+            it = activeCaptureGroups_.erase(it);
         }
     }
+
+    // Window::Render() lets the members go otherwise.
+    if (WindowManager::IsHeadless())
+    {
+        for (const auto& group : releasedGroups)
+        {
+            for (const int id : group->GetIds())
+            {
+                if (const auto window = WindowManager::Get().GetWindow(id))
+                {
+                    window->ReleaseCaptureGroup();
+                }
+            }
+        }
+    }
+
+    // Published after the members so that their group sequences are set when the host sees it.
+    if (releasedSequence > lastReleasedCaptureGroupSequence_)
+    {
+        lastReleasedCaptureGroupSequence_ = releasedSequence;
+    }
 }
 
 
-void CaptureManager::RequestCaptureIcon(int id)
+void CaptureManager::SetCaptureDeadline(UINT milliseconds)
 {
-    iconQueue_.Enqueue(id);
+    captureWatchdog_.SetDeadline(std::chrono::milliseconds(max(milliseconds, 1u)));
+}
+
+
+bool CaptureManager::IsCaptureQuarantined(int id) const
+{
+    return captureWatchdog_.IsQuarantined(id);
+}
+
+
+CaptureStallStats CaptureManager::GetCaptureStallStats() const
+{
+    return captureWatchdog_.GetStats();
 }
\ No newline at end of file
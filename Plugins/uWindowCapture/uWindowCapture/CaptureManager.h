@@ -2,18 +2,17 @@
 
 #include <Windows.h>
 #include <deque>
+#include <vector>
+#include <memory>
+#include <chrono>
 #include <mutex>
+#include <atomic>
 
 #include "WindowQueue.h"
 #include "Thread.h"
-
-
-enum class CapturePriority
-{
-    High = 0,
-    Middle = 1,
-    Low  = 2,
-};
+#include "CaptureScheduler.h"
+#include "CaptureWatchdog.h"
+#include "CaptureGroup.h"
 
 
 class CaptureManager
@@ -23,12 +22,30 @@ public:
     ~CaptureManager();
     void RequestCapture(int id, CapturePriority priority);
     void RequestCaptureIcon(int id);
+    UINT RequestCaptureGroup(const int* ids, int count);
+    void ReleaseCaptureGroups();
+    UINT GetLastReleasedCaptureGroupSequence() const { return lastReleasedCaptureGroupSequence_; }
+    void SetOccludedWindowCapturePolicy(OccludedWindowCapturePolicy policy) { scheduler_.SetOccludedWindowCapturePolicy(policy); }
+    OccludedWindowCapturePolicy GetOccludedWindowCapturePolicy() const { return scheduler_.GetOccludedWindowCapturePolicy(); }
+    void SetWindowImportance(const int* ids, const float* weights, int count) { scheduler_.SetWindowImportance(ids, weights, count); }
+    void SetCaptureBudget(float maxCapturesPerSecond, float minCapturesPerSecondPerWindow) { scheduler_.SetCaptureBudget(maxCapturesPerSecond, minCapturesPerSecondPerWindow); }
+    void SetCaptureDeadline(UINT milliseconds);
+    bool IsCaptureQuarantined(int id) const;
+    CaptureStallStats GetCaptureStallStats() const;
 
 private:
+    std::shared_ptr<CaptureGroup> PopCaptureGroup();
+    void CaptureGroupMembers(const std::shared_ptr<CaptureGroup>& group);
+
     ThreadLoop windowCaptureThreadLoop_ = { L"uWindowCapture - Window Capture Thread" };
     ThreadLoop iconCaptureThreadLoop_ = { L"uWindowCapture - Icon Capture Thread" };
-    WindowQueue highPriorityQueue_;
-    WindowQueue middlePriorityQueue_;
-    WindowQueue lowPriorityQueue_;
+    CaptureScheduler scheduler_;
     WindowQueue iconQueue_;
+    CaptureWatchdog captureWatchdog_;
+
+    std::deque<std::shared_ptr<CaptureGroup>> requestedCaptureGroups_;
+    std::vector<std::shared_ptr<CaptureGroup>> activeCaptureGroups_;
+    std::mutex captureGroupMutex_;
+    std::atomic<UINT> lastCaptureGroupSequence_ = 0;
+    std::atomic<UINT> lastReleasedCaptureGroupSequence_ = 0;
 };
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <limits>
+#include "CaptureScheduler.h"
+
+
+
+namespace
+{
+    // One spare token so that a request arriving a bit late does not lose its share of the rate.
+    constexpr float kMaxCaptureTokens = 2.f;
+
+    // The total budget may be spent in bursts of this length, e.g. when all the windows are requested in a frame.
+    constexpr float kTotalBurstSeconds = 0.1f;
+
+    // Schedules of unlisted windows which have not been requested for this long are dropped.
+    constexpr auto kUnlistedScheduleLifetime = std::chrono::seconds(10);
+}
+
+
+// ---
+
+
+bool CaptureScheduler::Request(int id, CapturePriority priority, bool isOccluded)
+{
+    const auto policy = occludedWindowCapturePolicy_.load();
+    if (policy != OccludedWindowCapturePolicy::Capture && isOccluded)
+    {
+        if (policy == OccludedWindowCapturePolicy::Skip) return false;
+        priority = CapturePriority::Low;
+    }
+
+    if (!ConsumeCaptureToken(id)) return false;
+
+    switch (priority)
+    {
+        case CapturePriority::High:
+        {
+            highPriorityQueue_.Enqueue(id);
+            break;
+        }
+        case CapturePriority::Middle:
+        {
+            middlePriorityQueue_.Enqueue(id);
+            break;
+        }
+        case CapturePriority::Low:
+        {
+            lowPriorityQueue_.Enqueue(id);
+            break;
+        }
+    }
+
+    return true;
+}
+
+
+int CaptureScheduler::Pop()
+{
+    // check the high-priority queue first.
+    int id = highPriorityQueue_.Dequeue();
+
+    // move an item in the mid-priority queue to the high-priority queue to give a chance to it.
+    if (id >= 0 && !middlePriorityQueue_.Empty())
+    {
+        const auto midId = middlePriorityQueue_.Dequeue();
+        highPriorityQueue_.Enqueue(midId);
+    }
+
+    // second, check the mid-priority queue.
+    if (id < 0)
+    {
+        id = middlePriorityQueue_.Dequeue();
+    }
+
+    // at last, check the low-priority queue.
+    if (id < 0)
+    {
+        id = lowPriorityQueue_.Dequeue();
+    }
+
+    return id;
+}
+
+
+void CaptureScheduler::SetWindowImportance(const int* ids, const float* weights, int count)
+{
+    std::lock_guard<std::mutex> lock(captureScheduleMutex_);
+
+    // windows are captured on every request as before until importance is given.
+    if (count <= 0 || !ids || !weights)
+    {
+        isImportanceGiven_ = false;
+        captureSchedules_.clear();
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (!isImportanceGiven_)
+    {
+        isImportanceGiven_ = true;
+        totalBucket_ = TokenBucket();
+        totalBucket_.tokens = max(maxCapturesPerSecond_ * kTotalBurstSeconds, kMaxCaptureTokens);
+        totalBucket_.lastRefillTime = now;
+    }
+
+    // keep the tokens of the known windows so that the rate stays continuous.
+    for (auto it = captureSchedules_.begin(); it != captureSchedules_.end();)
+    {
+        auto& schedule = it->second;
+        if (!schedule.isListed && now - schedule.bucket.lastRefillTime > kUnlistedScheduleLifetime)
+        {
+            it = captureSchedules_.erase(it);
+            continue;
+        }
+        schedule.weight = 0.f;
+        schedule.isListed = false;
+        ++it;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        auto& schedule = GetCaptureSchedule(ids[i], now);
+        schedule.weight = max(weights[i], 0.f);
+        schedule.isListed = true;
+    }
+
+    UpdateCaptureRates();
+}
+
+
+void CaptureScheduler::SetCaptureBudget(float maxCapturesPerSecond, float minCapturesPerSecondPerWindow)
+{
+    std::lock_guard<std::mutex> lock(captureScheduleMutex_);
+    maxCapturesPerSecond_ = max(maxCapturesPerSecond, 0.f);
+    minCapturesPerSecondPerWindow_ = std::clamp(minCapturesPerSecondPerWindow, 0.f, maxCapturesPerSecond_);
+    UpdateCaptureRates();
+}
+
+
+float CaptureScheduler::GetCaptureRate(int id)
+{
+    std::lock_guard<std::mutex> lock(captureScheduleMutex_);
+    if (!isImportanceGiven_) return std::numeric_limits<float>::infinity();
+
+    const auto it = captureSchedules_.find(id);
+    return (it != captureSchedules_.end()) ? it->second.bucket.rate : minCapturesPerSecondPerWindow_;
+}
+
+
+void CaptureScheduler::TokenBucket::Refill(std::chrono::steady_clock::time_point now, float maxTokens)
+{
+    const auto dt = std::chrono::duration<float>(now - lastRefillTime).count();
+    lastRefillTime = now;
+    tokens = min(tokens + rate * dt, maxTokens);
+}
+
+
+bool CaptureScheduler::ConsumeCaptureToken(int id)
+{
+    std::lock_guard<std::mutex> lock(captureScheduleMutex_);
+    if (!isImportanceGiven_) return true;
+
+    const auto now = std::chrono::steady_clock::now();
+    auto& bucket = GetCaptureSchedule(id, now).bucket;
+    bucket.Refill(now, kMaxCaptureTokens);
+    totalBucket_.Refill(now, max(maxCapturesPerSecond_ * kTotalBurstSeconds, kMaxCaptureTokens));
+
+    if (bucket.tokens < 1.f || totalBucket_.tokens < 1.f) return false;
+
+    bucket.tokens -= 1.f;
+    totalBucket_.tokens -= 1.f;
+    return true;
+}
+
+
+CaptureScheduler::CaptureSchedule& CaptureScheduler::GetCaptureSchedule(int id, std::chrono::steady_clock::time_point now)
+{
+    const auto it = captureSchedules_.find(id);
+    if (it != captureSchedules_.end()) return it->second;
+
+    // windows which are not listed get the floor rate until they are.
+    CaptureSchedule schedule;
+    schedule.bucket.rate = minCapturesPerSecondPerWindow_;
+    schedule.bucket.lastRefillTime = now;
+    return captureSchedules_.emplace(id, schedule).first->second;
+}
+
+
+void CaptureScheduler::UpdateCaptureRates()
+{
+    int count = 0;
+    float totalWeight = 0.f;
+    for (const auto& pair : captureSchedules_)
+    {
+        if (!pair.second.isListed) continue;
+        ++count;
+        totalWeight += pair.second.weight;
+    }
+
+    // every listed window gets the floor rate for liveness and the rest of the budget is
+    // shared in proportion to the weights. the total budget also caps the unlisted windows.
+    const float minRate = (count > 0) ? min(minCapturesPerSecondPerWindow_, maxCapturesPerSecond_ / count) : minCapturesPerSecondPerWindow_;
+    const float sharedRate = max(maxCapturesPerSecond_ - minRate * count, 0.f);
+
+    for (auto& pair : captureSchedules_)
+    {
+        auto& schedule = pair.second;
+        if (!schedule.isListed)
+        {
+            schedule.bucket.rate = minCapturesPerSecondPerWindow_;
+            continue;
+        }
+
+        schedule.bucket.rate = minRate;
+        if (totalWeight > 0.f)
+        {
+            schedule.bucket.rate += sharedRate * schedule.weight / totalWeight;
+        }
+    }
+
+    totalBucket_.rate = maxCapturesPerSecond_;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <unordered_map>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+
+#include "Platform.h"
+#include "WindowQueue.h"
+
+
+enum class CapturePriority
+{
+    High = 0,
+    Middle = 1,
+    Low  = 2,
+};
+
+
+enum class OccludedWindowCapturePolicy
+{
+    Capture = 0,
+    Deprioritize = 1,
+    Skip = 2,
+};
+
+
+// Decides which window is captured next from the requests: the priority queues,
+// the capture budget shared by weighted windows and the policy for occluded windows.
+class CaptureScheduler
+{
+public:
+    bool Request(int id, CapturePriority priority, bool isOccluded);
+    int Pop();
+    void SetOccludedWindowCapturePolicy(OccludedWindowCapturePolicy policy) { occludedWindowCapturePolicy_ = policy; }
+    OccludedWindowCapturePolicy GetOccludedWindowCapturePolicy() const { return occludedWindowCapturePolicy_; }
+    void SetWindowImportance(const int* ids, const float* weights, int count);
+    void SetCaptureBudget(float maxCapturesPerSecond, float minCapturesPerSecondPerWindow);
+
+    // Captures per second allowed for the window, or infinity while no importance is given.
+    float GetCaptureRate(int id);
+
+private:
+    struct TokenBucket
+    {
+        float rate = 0.f;
+        float tokens = 1.f;
+        std::chrono::steady_clock::time_point lastRefillTime;
+
+        void Refill(std::chrono::steady_clock::time_point now, float maxTokens);
+    };
+
+    struct CaptureSchedule
+    {
+        TokenBucket bucket;
+        float weight = 0.f;
+        bool isListed = false;
+    };
+
+    bool ConsumeCaptureToken(int id);
+    CaptureSchedule& GetCaptureSchedule(int id, std::chrono::steady_clock::time_point now);
+    void UpdateCaptureRates();
+
+    WindowQueue highPriorityQueue_;
+    WindowQueue middlePriorityQueue_;
+    WindowQueue lowPriorityQueue_;
+    std::atomic<OccludedWindowCapturePolicy> occludedWindowCapturePolicy_ = OccludedWindowCapturePolicy::Capture;
+
+    // Once importance is given, every window is throttled: the listed ones by their weights,
+    // the others at the floor rate, and all of them together by the total budget.
+    bool isImportanceGiven_ = false;
+    std::unordered_map<int, CaptureSchedule> captureSchedules_;
+    TokenBucket totalBucket_;
+    float maxCapturesPerSecond_ = 120.f;
+    float minCapturesPerSecondPerWindow_ = 1.f;
+    std::mutex captureScheduleMutex_;
+};
\ No newline at end of file
@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <thread>
+#include <condition_variable>
+#include "CaptureWatchdog.h"
+#include "Thread.h"
+#include "TraceRecorder.h"
+#include "Debug.h"
+
+
+
+namespace
+{
+    constexpr auto kDefaultDeadline = std::chrono::milliseconds(1000);
+    constexpr auto kMinBackOff = std::chrono::milliseconds(1000);
+    constexpr auto kMaxBackOff = std::chrono::milliseconds(60000);
+    constexpr auto kStuckWorkerStopTimeout = std::chrono::milliseconds(100);
+    constexpr auto kInfiniteTimeout = std::chrono::milliseconds(-1);
+    constexpr size_t kMaxWorkerCount = 4;
+    const std::wstring kWorkerThreadName = L"uWindowCapture - Capture Worker Thread";
+}
+
+
+// ---
+
+
+struct CaptureWatchdog::Worker
+{
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    Job job;
+    bool hasJob = false;
+    bool isRunning = true;
+    std::chrono::steady_clock::time_point jobStartTime;
+    std::chrono::microseconds lastJobTime = std::chrono::microseconds::zero();
+};
+
+
+CaptureWatchdog::CaptureWatchdog()
+    : deadline_(kDefaultDeadline)
+    , alive_(std::make_shared<std::atomic<bool>>(true))
+{
+    workers_.resize(kMaxWorkerCount);
+}
+
+
+CaptureWatchdog::~CaptureWatchdog()
+{
+    *alive_ = false;
+
+    for (const auto& worker : workers_)
+    {
+        if (worker)
+        {
+            StopWorker(worker, kInfiniteTimeout);
+        }
+    }
+
+    // Stuck workers cannot be interrupted, so they are detached if they do not finish soon.
+    for (const auto& worker : stuckWorkers_)
+    {
+        StopWorker(worker, kStuckWorkerStopTimeout);
+    }
+}
+
+
+std::shared_ptr<CaptureWatchdog::Worker> CaptureWatchdog::CreateWorker() const
+{
+    auto worker = std::make_shared<Worker>();
+
+    // All the workers are accounted as one entry of the thread loop stats, where a job is an iteration.
+    static ThreadLoopCounters* const counters = ThreadLoop::Register(kWorkerThreadName);
+
+    // The thread keeps its own reference since a stuck worker may outlive the watchdog.
+    worker->thread = std::thread([worker]
+    {
+        using namespace std::chrono;
+
+        TraceRecorder::SetThreadName(kWorkerThreadName);
+
+        auto cpuTimeUs = Platform::GetCurrentThreadCpuTime();
+        auto waitStartTime = steady_clock::now();
+
+        std::unique_lock<std::mutex> lock(worker->mutex);
+        while (true)
+        {
+            worker->condition.wait(lock, [&] { return worker->hasJob || !worker->isRunning; });
+            if (!worker->hasJob) break;
+
+            const auto job = std::move(worker->job);
+            const auto jobStartTime = steady_clock::now();
+            worker->jobStartTime = jobStartTime;
+            lock.unlock();
+
+            job();
+
+            const auto jobEndTime = steady_clock::now();
+            const auto currentCpuTimeUs = Platform::GetCurrentThreadCpuTime();
+            counters->iterationCount.fetch_add(1, std::memory_order_relaxed);
+            counters->workedIterationCount.fetch_add(1, std::memory_order_relaxed);
+            counters->loopTimeUs.fetch_add(duration_cast<microseconds>(jobEndTime - jobStartTime).count(), std::memory_order_relaxed);
+            counters->runningTimeUs.fetch_add(duration_cast<microseconds>(jobEndTime - waitStartTime).count(), std::memory_order_relaxed);
+            counters->cpuTimeUs.fetch_add(currentCpuTimeUs - cpuTimeUs, std::memory_order_relaxed);
+            cpuTimeUs = currentCpuTimeUs;
+            waitStartTime = jobEndTime;
+
+            lock.lock();
+            worker->lastJobTime = duration_cast<microseconds>(jobEndTime - jobStartTime);
+            worker->hasJob = false;
+            worker->condition.notify_all();
+        }
+    });
+
+    Platform::SetThreadName(worker->thread, kWorkerThreadName);
+
+    return worker;
+}
+
+
+void CaptureWatchdog::StopWorker(const std::shared_ptr<Worker>& worker, milliseconds timeout)
+{
+    bool isFinished = true;
+    {
+        std::unique_lock<std::mutex> lock(worker->mutex);
+        worker->isRunning = false;
+        worker->condition.notify_all();
+        if (timeout != kInfiniteTimeout)
+        {
+            isFinished = worker->condition.wait_for(lock, timeout, [&] { return !worker->hasJob; });
+        }
+    }
+
+    if (isFinished)
+    {
+        worker->thread.join();
+    }
+    else
+    {
+        Debug::Error(__FUNCTION__, " => A capture worker is still stuck and is detached.");
+        worker->thread.detach();
+    }
+}
+
+
+bool CaptureWatchdog::Run(int id, const Job& job, bool canBlock)
+{
+    std::vector<Task> tasks = { { id, job, canBlock, false } };
+    RunParallel(tasks);
+    return tasks[0].isDone;
+}
+
+
+void CaptureWatchdog::RunParallel(std::vector<Task>& tasks)
+{
+    CollectStuckWorkers();
+
+    // Captures which cannot block skip the hand-off to a worker unless the window has stalled before.
+    std::vector<Task*> blockingTasks;
+    std::vector<Task*> inlineTasks;
+    for (auto& task : tasks)
+    {
+        task.isDone = false;
+        if (IsQuarantined(task.id)) continue;
+
+        if (task.canBlock || HasStalled(task.id))
+        {
+            blockingTasks.push_back(&task);
+        }
+        else
+        {
+            inlineTasks.push_back(&task);
+        }
+    }
+
+    const auto runInlineTasks = [&]
+    {
+        for (auto* task : inlineTasks)
+        {
+            task->job();
+            task->isDone = true;
+        }
+        inlineTasks.clear();
+    };
+
+    for (size_t begin = 0; begin < blockingTasks.size(); begin += kMaxWorkerCount)
+    {
+        const size_t end = min(begin + kMaxWorkerCount, blockingTasks.size());
+
+        // Dispatch a batch to the workers first and then wait for all of them with one deadline.
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto& worker = workers_[i - begin];
+            if (!worker)
+            {
+                worker = CreateWorker();
+            }
+
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->job = blockingTasks[i]->job;
+            worker->hasJob = true;
+            worker->condition.notify_all();
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + deadline_.load();
+
+        // The other captures run here while the workers are busy.
+        runInlineTasks();
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto& task = *blockingTasks[i];
+            auto& worker = workers_[i - begin];
+            {
+                std::unique_lock<std::mutex> lock(worker->mutex);
+                task.isDone = worker->condition.wait_until(lock, deadline, [&] { return !worker->hasJob; });
+            }
+
+            if (task.isDone)
+            {
+                ReleaseWindow(task.id);
+                continue;
+            }
+
+            Debug::Error(__FUNCTION__, " => Capture of window (id=", task.id, ") exceeded the deadline.");
+            QuarantineWindow(task.id);
+
+            stuckWorkers_.push_back(std::move(worker));
+            worker = nullptr;
+
+            std::lock_guard<std::mutex> statsLock(statsMutex_);
+            ++stats_.stallCount;
+            stats_.stuckWorkerCount = static_cast<UINT>(stuckWorkers_.size());
+        }
+    }
+
+    runInlineTasks();
+}
+
+
+void CaptureWatchdog::CollectStuckWorkers()
+{
+    for (auto it = stuckWorkers_.begin(); it != stuckWorkers_.end();)
+    {
+        const auto& worker = *it;
+
+        std::chrono::microseconds jobTime;
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            if (worker->hasJob)
+            {
+                ++it;
+                continue;
+            }
+            jobTime = worker->lastJobTime;
+        }
+
+        StopWorker(worker, kInfiniteTimeout);
+        it = stuckWorkers_.erase(it);
+
+        const float stallTime = jobTime.count() / 1000.f;
+        std::lock_guard<std::mutex> statsLock(statsMutex_);
+        stats_.lastStallTime = stallTime;
+        stats_.maxStallTime = max(stats_.maxStallTime, stallTime);
+        stats_.totalStallTime += stallTime;
+        stats_.stuckWorkerCount = static_cast<UINT>(stuckWorkers_.size());
+    }
+}
+
+
+void CaptureWatchdog::QuarantineWindow(int id)
+{
+    std::lock_guard<std::mutex> lock(quarantineMutex_);
+
+    const auto now = std::chrono::steady_clock::now();
+
+    // The back-off doubles while the window keeps stalling.
+    milliseconds backOff = kMinBackOff;
+    const auto found = quarantines_.find(id);
+    if (found != quarantines_.end())
+    {
+        backOff = min(found->second.backOff * 2, kMaxBackOff);
+    }
+
+    quarantines_[id] = { now + backOff, backOff };
+
+    // Forget the windows which have not been captured since (e.g. closed ones).
+    for (auto it = quarantines_.begin(); it != quarantines_.end();)
+    {
+        if (now > it->second.endTime + kMaxBackOff)
+        {
+            it = quarantines_.erase(it);
+            continue;
+        }
+        ++it;
+    }
+}
+
+
+void CaptureWatchdog::ReleaseWindow(int id)
+{
+    std::lock_guard<std::mutex> lock(quarantineMutex_);
+    quarantines_.erase(id);
+}
+
+
+bool CaptureWatchdog::HasStalled(int id) const
+{
+    std::lock_guard<std::mutex> lock(quarantineMutex_);
+    return quarantines_.find(id) != quarantines_.end();
+}
+
+
+bool CaptureWatchdog::IsQuarantined(int id) const
+{
+    std::lock_guard<std::mutex> lock(quarantineMutex_);
+
+    const auto it = quarantines_.find(id);
+    if (it == quarantines_.end()) return false;
+
+    return std::chrono::steady_clock::now() < it->second.endTime;
+}
+
+
+CaptureStallStats CaptureWatchdog::GetStats() const
+{
+    CaptureStallStats stats;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats = stats_;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(quarantineMutex_);
+    stats.quarantinedWindowCount = static_cast<UINT>(std::count_if(
+        quarantines_.begin(),
+        quarantines_.end(),
+        [&](const auto& pair) { return now < pair.second.endTime; }));
+
+    return stats;
+}
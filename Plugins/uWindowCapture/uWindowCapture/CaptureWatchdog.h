@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Platform.h"
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+
+
+struct CaptureStallStats
+{
+    UINT stallCount;
+    UINT quarantinedWindowCount;
+    UINT stuckWorkerCount;
+    float lastStallTime;
+    float maxStallTime;
+    float totalStallTime;
+};
+
+
+// Runs captures which can block (e.g. PrintWindow() on a window whose UI thread hangs) in a worker thread
+// with a deadline, and the others inline. A capture which exceeds the deadline quarantines the window for
+// a back-off period, and the stuck worker is left behind and replaced by a fresh one so that the other
+// windows keep being captured. The window keeps going to a worker until it is captured in time again.
+//
+// Stuck workers which have not finished when the watchdog is destroyed are detached. Their jobs check
+// the alive token before touching anything the owner has destroyed in the meantime; nothing can protect
+// them if the module itself is unloaded before they return.
+class CaptureWatchdog
+{
+public:
+    using Job = std::function<void()>;
+    using AliveToken = std::shared_ptr<const std::atomic<bool>>;
+    using milliseconds = std::chrono::milliseconds;
+
+    struct Task
+    {
+        int id;
+        Job job;
+        bool canBlock;
+        bool isDone;
+    };
+
+    CaptureWatchdog();
+    ~CaptureWatchdog();
+
+    bool Run(int id, const Job& job, bool canBlock);
+    void RunParallel(std::vector<Task>& tasks);
+    bool IsQuarantined(int id) const;
+    AliveToken GetAliveToken() const { return alive_; }
+    void SetDeadline(milliseconds deadline) { deadline_ = deadline; }
+    milliseconds GetDeadline() const { return deadline_; }
+    CaptureStallStats GetStats() const;
+
+private:
+    struct Worker;
+
+    struct QuarantineEntry
+    {
+        std::chrono::steady_clock::time_point endTime;
+        milliseconds backOff;
+    };
+
+    std::shared_ptr<Worker> CreateWorker() const;
+    static void StopWorker(const std::shared_ptr<Worker>& worker, milliseconds timeout);
+    void QuarantineWindow(int id);
+    void ReleaseWindow(int id);
+    bool HasStalled(int id) const;
+    void CollectStuckWorkers();
+
+    // Owned by the thread which calls Run().
+    std::vector<std::shared_ptr<Worker>> workers_;
+    std::vector<std::shared_ptr<Worker>> stuckWorkers_;
+
+    std::unordered_map<int, QuarantineEntry> quarantines_;
+    mutable std::mutex quarantineMutex_;
+    std::atomic<milliseconds> deadline_;
+    const std::shared_ptr<std::atomic<bool>> alive_;
+
+    CaptureStallStats stats_ = {};
+    mutable std::mutex statsMutex_;
+};
@@ -4,6 +4,7 @@
 #include "WindowManager.h"
 #include "Unity.h"
 #include "Message.h"
+#include "TraceRecorder.h"
 
 using namespace Microsoft::WRL;
 
@@ -29,8 +30,13 @@ void Cursor::StartCapture()
         if (isCaptureRequested_)
         {
             isCaptureRequested_ = false;
-            Capture();
+            if (Capture() && WindowManager::IsHeadless())
+            {
+                MessageManager::Get().Add({ MessageType::CursorCaptured, -1, nullptr });
+            }
+            return true;
         }
+        return false;
     }, std::chrono::microseconds(100));
 }
 
@@ -97,6 +103,8 @@ ID3D11Texture2D* Cursor::GetUnityTexturePtr() const
 
 bool Cursor::Capture()
 {
+    UWC_TRACE_SCOPE("CaptureCursor", -1)
+
     std::lock_guard<std::mutex> lock(cursorMutex_);
 
     CURSORINFO cursorInfo;
@@ -213,7 +221,7 @@ bool Cursor::Capture()
     ::SelectObject(hDcMem, preObject);
 
     {
-        std::lock_guard<std::mutex> lock(bufferMutex_);
+        std::lock_guard<ProfiledMutex> lock(bufferMutex_);
 
         auto buffer32 = buffer_.As<UINT>();
         const auto desktop32 = desktop.As<UINT>();
@@ -257,6 +265,8 @@ bool Cursor::Upload()
 
     if (!unityTexture_.load() || buffer_.Empty()) return false;
 
+    UWC_TRACE_SCOPE("UploadCursor", -1)
+
     {
         D3D11_TEXTURE2D_DESC desc;
         unityTexture_.load()->GetDesc(&desc);
@@ -270,7 +280,7 @@ bool Cursor::Upload()
     auto& uploader = WindowManager::GetUploadManager();
     if (!uploader) return false;
 
-    std::lock_guard<std::mutex> lock(sharedTextureMutex_);
+    std::lock_guard<ProfiledMutex> lock(sharedTextureMutex_);
 
     sharedTexture_ = uploader->CreateCompatibleSharedTexture(unityTexture_.load());
     if (!sharedTexture_)
@@ -288,7 +298,7 @@ bool Cursor::Upload()
     }
 
     {
-        std::lock_guard<std::mutex> lock(bufferMutex_);
+        std::lock_guard<ProfiledMutex> lock(bufferMutex_);
         ComPtr<ID3D11DeviceContext> context;
         uploader->GetDevice()->GetImmediateContext(&context);
         context->UpdateSubresource(sharedTexture_.Get(), 0, nullptr, buffer_.Get(), GetWidth() * 4, 0);
@@ -308,7 +318,9 @@ bool Cursor::Render()
 
     if (!unityTexture_.load() || !sharedTexture_ || !sharedHandle_) return false;
 
-    std::lock_guard<std::mutex> lock(sharedTextureMutex_);
+    UWC_TRACE_SCOPE("RenderCursor", -1)
+
+    std::lock_guard<ProfiledMutex> lock(sharedTextureMutex_);
 
     ComPtr<ID3D11DeviceContext> context;
     GetUnityDevice()->GetImmediateContext(&context);
@@ -332,7 +344,7 @@ bool Cursor::Render()
 
 void Cursor::CreateBitmapIfNeeded(HDC hDc, UINT width, UINT height)
 {
-    std::lock_guard<std::mutex> lock(bufferMutex_);
+    std::lock_guard<ProfiledMutex> lock(bufferMutex_);
 
     if (width_ == width && height_ == height) return;
 
@@ -7,6 +7,7 @@
 #include <atomic>
 
 #include "Buffer.h"
+#include "ProfiledMutex.h"
 #include "Thread.h"
 
 
@@ -43,11 +44,11 @@ private:
     std::atomic<ID3D11Texture2D*> unityTexture_ = nullptr;
     Microsoft::WRL::ComPtr<ID3D11Texture2D> sharedTexture_;
     HANDLE sharedHandle_;
-    std::mutex sharedTextureMutex_;
+    ProfiledMutex sharedTextureMutex_ { "Cursor::sharedTextureMutex_" };
 
     Buffer<BYTE> buffer_;
     HBITMAP bitmap_ = nullptr;
-    std::mutex bufferMutex_;
+    ProfiledMutex bufferMutex_ { "Cursor::bufferMutex_" };
 
     std::atomic<UINT> width_ = 0;
     std::atomic<UINT> height_ = 0;
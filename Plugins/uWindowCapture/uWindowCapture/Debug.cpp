@@ -1,22 +1,194 @@
-#pragma once
-
-#include <Windows.h>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <condition_variable>
+#include <chrono>
 #include "Debug.h"
 
 
+
+namespace
+{
+    constexpr size_t kRecordCount = 1024;
+    constexpr size_t kNotifyInterval = kRecordCount / 4;
+    constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+    constexpr auto kRepeatInterval = std::chrono::seconds(1);
+    constexpr size_t kRepeatSlotCount = 8;
+    constexpr size_t kRepeatPreviewSize = 64;
+
+
+    // Multi-producer / single-consumer ring of formatted lines.
+    // Producers never block; when the ring is full the line is dropped and counted.
+    class LogFileWriter
+    {
+    public:
+        bool Start(const char* path)
+        {
+            fs_.open(path);
+            if (!fs_.good()) return false;
+
+            if (!records_)
+            {
+                records_ = std::make_unique<Record[]>(kRecordCount);
+            }
+            for (size_t i = 0; i < kRecordCount; ++i)
+            {
+                records_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            enqueueIndex_.store(0, std::memory_order_relaxed);
+            dequeueIndex_ = 0;
+            droppedCount_ = 0;
+
+            isRunning_ = true;
+            thread_ = std::thread([this] { ThreadFunc(); });
+            return true;
+        }
+
+        void Stop()
+        {
+            if (!thread_.joinable()) return;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                isRunning_ = false;
+            }
+            condition_.notify_one();
+            thread_.join();
+
+            fs_.close();
+        }
+
+        void Push(const char* message, size_t size)
+        {
+            if (!isRunning_) return;
+
+            auto index = enqueueIndex_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                auto& record = records_[index % kRecordCount];
+                const auto sequence = record.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(index);
+                if (diff == 0)
+                {
+                    if (enqueueIndex_.compare_exchange_weak(index, index + 1, std::memory_order_relaxed))
+                    {
+                        memcpy(record.message, message, size);
+                        record.size = size;
+                        record.sequence.store(index + 1, std::memory_order_release);
+                        break;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    droppedCount_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                else
+                {
+                    index = enqueueIndex_.load(std::memory_order_relaxed);
+                }
+            }
+
+            if ((index + 1) % kNotifyInterval == 0)
+            {
+                condition_.notify_one();
+            }
+        }
+
+    private:
+        struct Record
+        {
+            std::atomic<size_t> sequence = 0;
+            size_t size = 0;
+            char message[Debug::kMessageSize];
+        };
+
+        bool Pop(std::string& batch)
+        {
+            auto& record = records_[dequeueIndex_ % kRecordCount];
+            if (record.sequence.load(std::memory_order_acquire) != dequeueIndex_ + 1) return false;
+
+            batch.append(record.message, record.size);
+            batch.push_back('\n');
+            record.sequence.store(dequeueIndex_ + kRecordCount, std::memory_order_release);
+            ++dequeueIndex_;
+            return true;
+        }
+
+        void WriteAll(std::string& batch)
+        {
+            batch.clear();
+            while (Pop(batch));
+
+            if (const auto dropped = droppedCount_.exchange(0))
+            {
+                char buf[64];
+                snprintf(buf, 64, "[uWC::Err] %u log lines were dropped.\n", dropped);
+                batch.append(buf);
+            }
+
+            if (batch.empty() || !fs_.good()) return;
+
+            fs_.write(batch.data(), batch.size());
+            fs_.flush();
+        }
+
+        void ThreadFunc()
+        {
+            std::string batch;
+            batch.reserve(kRecordCount * 128);
+
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    condition_.wait_for(lock, kFlushInterval, [this] { return !isRunning_; });
+                }
+
+                WriteAll(batch);
+
+                if (!isRunning_) break;
+            }
+        }
+
+        std::ofstream fs_;
+        std::unique_ptr<Record[]> records_;
+        std::atomic<size_t> enqueueIndex_ = 0;
+        size_t dequeueIndex_ = 0;
+        std::atomic<UINT> droppedCount_ = 0;
+        std::thread thread_;
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        std::atomic<bool> isRunning_ = false;
+    };
+
+    LogFileWriter g_fileWriter;
+
+
+    size_t Hash(const char* str, size_t size)
+    {
+        size_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ static_cast<unsigned char>(str[i])) * 1099511628211ull;
+        }
+        return hash;
+    }
+}
+
+
 decltype(Debug::mode_)    Debug::mode_ = Debug::Mode::File;
 decltype(Debug::logFunc_) Debug::logFunc_ = nullptr;
 decltype(Debug::errFunc_) Debug::errFunc_ = nullptr;
-decltype(Debug::fs_)      Debug::fs_;
-decltype(Debug::ss_)      Debug::ss_;
-decltype(Debug::mutex_)   Debug::mutex_;
+decltype(Debug::mutex_)   Debug::mutex_("Debug::mutex_");
 
 
 void Debug::Initialize()
 {
     if (mode_ == Mode::File)
     {
-        fs_.open("uWindowCapture.log");
+        g_fileWriter.Start("uWindowCapture.log");
         Debug::Log("Start");
     }
 }
@@ -27,20 +199,165 @@ void Debug::Finalize()
     if (mode_ == Mode::File)
     {
         Debug::Log("Stop");
-        fs_.close();
+        g_fileWriter.Stop();
+    }
+}
+
+
+void Debug::Line::Append(const char* str, size_t length)
+{
+    const auto n = min(length, kMessageSize - 1 - size);
+    memcpy(message + size, str, n);
+    size += n;
+    message[size] = '\0';
+}
+
+
+Debug::Line& Debug::GetLine()
+{
+    thread_local Line line;
+    return line;
+}
+
+
+void Debug::OutputHeader(Line& line, Level level)
+{
+    line.Append(level == Level::Log ? "[uWC::Log]" : "[uWC::Err]");
+
+    const auto t = time(nullptr);
+    tm tm{};
+    Platform::GetLocalTime(t, tm);
+    char buf[64];
+    strftime(buf, 64, "%F %T", &tm);
+    line.Append("[");
+    line.Append(buf);
+    line.Append("] ");
+
+    line.bodyOffset = line.size;
+}
+
+
+void Debug::Flush(Level level, Line& line)
+{
+    // Identical lines from the same thread are logged at most once per interval,
+    // and the number of suppressed repeats is reported when the interval has passed.
+    struct Repeat
+    {
+        size_t hash = 0;
+        std::chrono::steady_clock::time_point time;
+        UINT count = 0;
+        Level level = Level::Log;
+        char preview[kRepeatPreviewSize] = {};
+    };
+    thread_local Repeat repeats[kRepeatSlotCount];
+
+    const auto* body = line.message + line.bodyOffset;
+    const auto bodySize = line.size - line.bodyOffset;
+    const auto hash = Hash(body, bodySize);
+    const auto now = std::chrono::steady_clock::now();
+
+    auto* slot = &repeats[0];
+    for (auto& repeat : repeats)
+    {
+        if (repeat.hash == hash)
+        {
+            slot = &repeat;
+            break;
+        }
+        if (repeat.time < slot->time)
+        {
+            slot = &repeat;
+        }
+    }
+
+    if (slot->hash == hash && now - slot->time < kRepeatInterval)
+    {
+        ++slot->count;
+        return;
+    }
+
+    if (slot->count > 0)
+    {
+        Line summary;
+        summary.Clear();
+        OutputHeader(summary, slot->level);
+        summary.AppendFormat("Repeated %u more times: ", slot->count);
+        summary.Append(slot->preview);
+        Emit(slot->level, summary);
+    }
+
+    slot->hash = hash;
+    slot->time = now;
+    slot->count = 0;
+    slot->level = level;
+    const auto previewSize = min(bodySize, kRepeatPreviewSize - 1);
+    memcpy(slot->preview, body, previewSize);
+    slot->preview[previewSize] = '\0';
+
+    Emit(level, line);
+}
+
+
+void Debug::Emit(Level level, const Line& line)
+{
+    switch (mode_)
+    {
+        case Mode::None:
+        {
+            return;
+        }
+        case Mode::File:
+        {
+            g_fileWriter.Push(line.message, line.size);
+            break;
+        }
+        case Mode::UnityLog:
+        {
+            std::lock_guard<ProfiledMutex> lock(mutex_);
+            switch (level)
+            {
+                case Level::Log   :
+                    if (logFunc_) logFunc_(line.message);
+                    break;
+                case Level::Error :
+                    if (errFunc_) errFunc_(line.message);
+                    break;
+            }
+            break;
+        }
     }
 }
 
 
 void OutputApiError(const char* apiName)
 {
-    const auto error = ::GetLastError();
+    const auto error = Platform::GetLastError();
     Debug::Error(apiName, "() failed with error code: ", error);
 }
 
 
 void OutputApiError(const char* func, const char* apiName)
 {
-    const auto error = ::GetLastError();
+    const auto error = Platform::GetLastError();
     Debug::Error(func, "() => ", apiName, "() failed with error code: ", error);
-}
\ No newline at end of file
+}
+
+
+ScopedTimer::ScopedTimer(TimerFuncType&& func)
+    : func_(func)
+    , start_(std::chrono::steady_clock::now())
+{
+}
+
+
+ScopedTimer::~ScopedTimer()
+{
+    func_(GetElapsedTime());
+}
+
+
+ScopedTimer::microseconds ScopedTimer::GetElapsedTime() const
+{
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<microseconds>(end - start_);
+}
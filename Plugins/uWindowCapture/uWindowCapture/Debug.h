@@ -1,11 +1,19 @@
 #pragma once
 
 #include <time.h>
-#include <fstream>
-#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <string>
 #include <mutex>
+#include <atomic>
+#include <type_traits>
+#include <chrono>
+#include <functional>
 
 #include "IUnityInterface.h"
+#include "ProfiledMutex.h"
+
+// #define UWC_DEBUG_ON
 
 
 // Error handling
@@ -32,6 +40,8 @@ public:
     static void SetLogFunc(DebugLogFuncPtr func) { logFunc_ = func; }
     static void SetErrorFunc(DebugLogFuncPtr func) { errFunc_ = func; }
 
+    static constexpr size_t kMessageSize = 512;
+
 private:
     enum class Level
     {
@@ -39,106 +49,144 @@ private:
         Error
     };
 
-    template <class T>
-    static void Output(T&& arg)
+    struct Line
     {
-        if (mode_ == Mode::None) return;
-        if (ss_.good())
+        char message[kMessageSize];
+        size_t size = 0;
+        size_t bodyOffset = 0;
+
+        void Clear() { size = 0; bodyOffset = 0; message[0] = '\0'; }
+        void Append(const char* str, size_t length);
+        void Append(const char* str) { if (str) Append(str, strlen(str)); }
+
+        template <class... Args>
+        void AppendFormat(const char* format, Args... args)
         {
-            ss_ << std::forward<T>(arg);
+            if (size + 1 >= kMessageSize) return;
+            const int n = snprintf(message + size, kMessageSize - size, format, args...);
+            size = (n < 0 || static_cast<size_t>(n) >= kMessageSize - size) ? kMessageSize - 1 : size + n;
         }
-    }
+    };
+
+    template <class T>
+    struct IsUnsupported : std::false_type {};
+
+    template <class T>
+    struct IsAtomic : std::false_type {};
 
-    static void Flush(Level level)
+    template <class T>
+    struct IsAtomic<std::atomic<T>> : std::true_type {};
+
+    template <class T>
+    static void Output(Line& line, const T& arg)
     {
-        switch (mode_)
+        if constexpr (std::is_convertible_v<const T&, const char*>)
+        {
+            line.Append(arg);
+        }
+        else if constexpr (std::is_same_v<T, std::string>)
+        {
+            line.Append(arg.c_str(), arg.size());
+        }
+        else if constexpr (std::is_same_v<T, char>)
+        {
+            line.Append(&arg, 1);
+        }
+        else if constexpr (std::is_enum_v<T>)
+        {
+            Output(line, static_cast<std::underlying_type_t<T>>(arg));
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            line.AppendFormat("%g", static_cast<double>(arg));
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+        {
+            line.AppendFormat("%lld", static_cast<long long>(arg));
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            line.AppendFormat("%llu", static_cast<unsigned long long>(arg));
+        }
+        else if constexpr (std::is_pointer_v<T>)
+        {
+            line.AppendFormat("%p", static_cast<const void*>(arg));
+        }
+        else if constexpr (IsAtomic<T>::value)
+        {
+            Output(line, arg.load());
+        }
+        else
         {
-            case Mode::None:
-            {
-                return;
-            }
-            case Mode::File:
-            {
-                if (fs_.good() && ss_.good())
-                {
-                    const auto str = ss_.str();
-                    fs_ << str << std::endl;
-                    fs_.flush();
-                }
-                break;
-            }
-            case Mode::UnityLog:
-            {
-                if (ss_.good())
-                {
-                    switch (level)
-                    {
-                        case Level::Log   : 
-                            if (logFunc_) logFunc_(ss_.str().c_str()); 
-                            break;
-                        case Level::Error : 
-                            if (errFunc_) errFunc_(ss_.str().c_str()); 
-                            break;
-                    }
-                }
-                break;
-            }
+            static_assert(IsUnsupported<T>::value, "Debug cannot output this type.");
         }
-        ss_.str("");
-        ss_.clear(std::stringstream::goodbit);
     }
 
-    template <class Arg, class... RestArgs>
-    static void _Log(Level level, Arg&& arg, RestArgs&&... restArgs)
-    {
-        Output(std::forward<Arg>(arg));
-        _Log(level, std::forward<RestArgs>(restArgs)...);
-    }
+    static Line& GetLine();
+    static void OutputHeader(Line& line, Level level);
+    static void Flush(Level level, Line& line);
+    static void Emit(Level level, const Line& line);
 
-    static void _Log(Level level)
+    template <class... Args>
+    static void Write(Level level, const Args&... args)
     {
-        Flush(level);
-    }
-
-    static void OutputTime()
-    {
-        auto t = time(nullptr);
-        tm tm{};
-        localtime_s(&tm, &t);
-        char buf[64];
-        strftime(buf, 64, "%F %T", &tm);
-        Output("[");;
-        Output(buf);
-        Output("]");
+        if (mode_ == Mode::None) return;
+        auto& line = GetLine();
+        line.Clear();
+        OutputHeader(line, level);
+        (Output(line, args), ...);
+        Flush(level, line);
     }
 
 public:
     template <class Arg, class... RestArgs>
-    static void Log(Arg&& arg, RestArgs&&... restArgs)
+    static void Log(const Arg& arg, const RestArgs&... restArgs)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        Output("[uWC::Log]");
-        OutputTime();
-        Output(" ");
-        _Log(Level::Log, std::forward<Arg>(arg), std::forward<RestArgs>(restArgs)...);
+        Write(Level::Log, arg, restArgs...);
     }
 
     template <class Arg, class... RestArgs>
-    static void Error(Arg&& arg, RestArgs&&... restArgs)
+    static void Error(const Arg& arg, const RestArgs&... restArgs)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        Output("[uWC::Err]");
-        OutputTime();
-        Output(" ");
-        _Log(Level::Error, std::forward<Arg>(arg), std::forward<RestArgs>(restArgs)...);
+        Write(Level::Error, arg, restArgs...);
     }
 
 private:
-    static bool isInitialized_;
     static Mode mode_;
-    static std::ofstream fs_;
-    static std::ostringstream ss_;
     static DebugLogFuncPtr logFunc_;
     static DebugLogFuncPtr errFunc_;
-    static std::mutex mutex_;
+    static ProfiledMutex mutex_;
+};
+
+
+// Timer
+class ScopedTimer
+{
+public:
+    using microseconds = std::chrono::microseconds;
+    using TimerFuncType = std::function<void(microseconds)>;
+    ScopedTimer(TimerFuncType&& func);
+    ~ScopedTimer();
+    microseconds GetElapsedTime() const;
+
+private:
+    const TimerFuncType func_;
+    const std::chrono::time_point<std::chrono::steady_clock> start_;
 };
+
+
+#ifdef UWC_DEBUG_ON
+#define UWC_FUNCTION_SCOPE_TIMER \
+    ScopedTimer _timer_##__COUNTER__([](std::chrono::microseconds us) \
+    { \
+        Debug::Log(__FUNCTION__, "@", __FILE__, ":", __LINE__, " => ", us.count(), " [us]"); \
+    });
+#define UWC_SCOPE_TIMER(Name) \
+    ScopedTimer _timer_##__COUNTER__([](std::chrono::microseconds us) \
+    { \
+        Debug::Log(#Name, " => ", us.count(), " [us]"); \
+    });
+#else
+#define UWC_FUNCTION_SCOPE_TIMER
+#define UWC_SCOPE_TIMER(Name)
+#endif
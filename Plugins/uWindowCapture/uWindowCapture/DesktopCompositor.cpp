@@ -0,0 +1,134 @@
+#include <future>
+#include "DesktopCompositor.h"
+#include "Debug.h"
+
+
+
+namespace
+{
+    constexpr UINT kBytesPerPixel = 4;
+
+    bool IsSameRect(const RECT& a, const RECT& b)
+    {
+        return
+            a.left == b.left && a.top == b.top &&
+            a.right == b.right && a.bottom == b.bottom;
+    }
+}
+
+
+// ---
+
+
+bool DesktopCompositor::Compose(const std::vector<Source>& sources)
+{
+    UWC_SCOPE_TIMER(ComposeDesktops)
+
+    lastCopiedCount_ = 0;
+
+    if (!UpdateLayout(sources)) return false;
+
+    // Copy the changed monitors in parallel. They never overlap in the output buffer.
+    std::vector<std::pair<const Source*, std::future<bool>>> copies;
+    copies.reserve(sources.size());
+
+    for (const auto& source : sources)
+    {
+        const auto it = versions_.find(source.id);
+        if (it != versions_.end() && it->second == source.version) continue;
+
+        copies.emplace_back(&source, std::async(std::launch::async, [this, &source]
+        {
+            return source.read([&](const BYTE* pixels, UINT width, UINT height)
+            {
+                Copy(pixels, width, height, source.rect);
+            });
+        }));
+    }
+
+    for (auto& copy : copies)
+    {
+        if (!copy.second.get()) continue;
+
+        versions_[copy.first->id] = copy.first->version;
+        ++lastCopiedCount_;
+    }
+
+    return true;
+}
+
+
+bool DesktopCompositor::UpdateLayout(const std::vector<Source>& sources)
+{
+    if (sources.empty()) return false;
+
+    RECT bounds = sources[0].rect;
+    bool hasLayoutChanged = layout_.size() != sources.size();
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        const auto& source = sources[i];
+        ::UnionRect(&bounds, &bounds, &source.rect);
+
+        if (!hasLayoutChanged)
+        {
+            const auto& prev = layout_[i];
+            hasLayoutChanged = prev.first != source.id || !IsSameRect(prev.second, source.rect);
+        }
+    }
+
+    const LONG width = bounds.right - bounds.left;
+    const LONG height = bounds.bottom - bounds.top;
+    if (width <= 0 || height <= 0) return false;
+
+    if (!hasLayoutChanged && IsSameRect(bounds, bounds_)) return true;
+
+    // Monitors are added, removed or moved, so redraw everything from a cleared buffer.
+    bounds_ = bounds;
+    buffer_.ExpandIfNeeded(width * height * kBytesPerPixel);
+    buffer_.Clear();
+
+    layout_.clear();
+    for (const auto& source : sources)
+    {
+        layout_.emplace_back(source.id, source.rect);
+    }
+    versions_.clear();
+
+    return true;
+}
+
+
+void DesktopCompositor::Copy(const BYTE* pixels, UINT width, UINT height, const RECT& rect)
+{
+    if (!pixels || width == 0 || height == 0) return;
+
+    const LONG dstWidth = rect.right - rect.left;
+    const LONG dstHeight = rect.bottom - rect.top;
+    if (dstWidth <= 0 || dstHeight <= 0) return;
+
+    const UINT dstPitch = GetWidth() * kBytesPerPixel;
+    const UINT srcPitch = width * kBytesPerPixel;
+    BYTE* dstOrigin = buffer_.Get(
+        (rect.top - bounds_.top) * dstPitch +
+        (rect.left - bounds_.left) * kBytesPerPixel);
+
+    for (LONG y = 0; y < dstHeight; ++y)
+    {
+        const UINT srcY = static_cast<UINT>(static_cast<UINT64>(y) * height / dstHeight);
+        const BYTE* srcRow = pixels + srcY * srcPitch;
+        BYTE* dstRow = dstOrigin + y * dstPitch;
+
+        if (static_cast<UINT>(dstWidth) == width)
+        {
+            memcpy(dstRow, srcRow, srcPitch);
+            continue;
+        }
+
+        const auto* src = reinterpret_cast<const UINT*>(srcRow);
+        auto* dst = reinterpret_cast<UINT*>(dstRow);
+        for (LONG x = 0; x < dstWidth; ++x)
+        {
+            dst[x] = src[static_cast<UINT64>(x) * width / dstWidth];
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Platform.h"
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "Buffer.h"
+
+
+// Composes the frames of all monitors into one BGRA buffer laid out by the monitor rects
+// on the virtual screen. Frames whose size differs from their rect (e.g. monitors with
+// different DPI) are scaled with the nearest neighbor.
+class DesktopCompositor
+{
+public:
+    using FrameReader = std::function<void(const BYTE* pixels, UINT width, UINT height)>;
+
+    struct Source
+    {
+        int id;
+        RECT rect;
+        UINT64 version;
+        std::function<bool(const FrameReader&)> read;
+    };
+
+    bool Compose(const std::vector<Source>& sources);
+
+    const BYTE* GetBuffer() const { return buffer_.Get(); }
+    const RECT& GetBounds() const { return bounds_; }
+    UINT GetWidth() const { return bounds_.right - bounds_.left; }
+    UINT GetHeight() const { return bounds_.bottom - bounds_.top; }
+    UINT GetLastCopiedCount() const { return lastCopiedCount_; }
+
+private:
+    bool UpdateLayout(const std::vector<Source>& sources);
+    void Copy(const BYTE* pixels, UINT width, UINT height, const RECT& rect);
+
+    Buffer<BYTE> buffer_;
+    RECT bounds_ = {};
+    std::vector<std::pair<int, RECT>> layout_;
+    std::unordered_map<int, UINT64> versions_;
+    UINT lastCopiedCount_ = 0;
+};
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "FrameLatencyTracker.h"
+
+
+
+namespace
+{
+    constexpr float kMicrosecondsToMilliseconds = 1.f / 1000.f;
+
+
+    UINT ToDuration(UINT64 from, UINT64 to)
+    {
+        return (to > from) ? static_cast<UINT>(min(to - from, 0xffffffffull)) : 0;
+    }
+
+
+    float GetPercentile(const UINT* values, UINT count, float percentile)
+    {
+        if (count == 0) return 0.f;
+
+        UINT sorted[FrameLatencyTracker::kFrameCount];
+        std::copy(values, values + count, sorted);
+        const auto index = static_cast<UINT>((count - 1) * percentile);
+        std::nth_element(sorted, sorted + index, sorted + count);
+        return sorted[index] * kMicrosecondsToMilliseconds;
+    }
+
+
+    float GetStandardDeviation(const UINT* values, UINT count)
+    {
+        if (count < 2) return 0.f;
+
+        double sum = 0.0;
+        for (UINT i = 0; i < count; ++i) sum += values[i];
+        const double mean = sum / count;
+
+        double variance = 0.0;
+        for (UINT i = 0; i < count; ++i) variance += (values[i] - mean) * (values[i] - mean);
+        variance /= count - 1;
+
+        return static_cast<float>(std::sqrt(variance)) * kMicrosecondsToMilliseconds;
+    }
+}
+
+
+// ---
+
+
+UINT64 FrameLatencyTracker::GetTime()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+
+void FrameLatencyTracker::OnCaptured(UINT64 captureStartTime, UINT width, UINT height)
+{
+    const auto now = GetTime();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (lastCaptureStartTime_ > 0)
+    {
+        intervals_[intervalCount_ % kFrameCount] = ToDuration(lastCaptureStartTime_, captureStartTime);
+        ++intervalCount_;
+    }
+    lastCaptureStartTime_ = captureStartTime;
+
+    // A frame which has not been uploaded yet is replaced, so keep its resize flag.
+    const bool isResized = (width_ > 0 && (width != width_ || height != height_));
+    capturedFrame_.isResized = isResized || (hasCapturedFrame_ && capturedFrame_.isResized);
+    capturedFrame_.captureStartTime = captureStartTime;
+    capturedFrame_.captureEndTime = now;
+    hasCapturedFrame_ = true;
+    width_ = width;
+    height_ = height;
+}
+
+
+void FrameLatencyTracker::OnUploaded()
+{
+    const auto now = GetTime();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!hasCapturedFrame_) return;
+
+    const bool isResized = hasUploadedFrame_ && uploadedFrame_.isResized;
+    uploadedFrame_ = capturedFrame_;
+    uploadedFrame_.uploadTime = now;
+    uploadedFrame_.isResized |= isResized;
+    hasUploadedFrame_ = true;
+    hasCapturedFrame_ = false;
+}
+
+
+void FrameLatencyTracker::OnRendered()
+{
+    const auto now = GetTime();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!hasUploadedFrame_) return;
+    hasUploadedFrame_ = false;
+
+    const auto& frame = uploadedFrame_;
+    lastCaptureTime_ = ToDuration(frame.captureStartTime, frame.captureEndTime);
+    lastUploadTime_ = ToDuration(frame.captureEndTime, frame.uploadTime);
+    lastRenderTime_ = ToDuration(frame.uploadTime, now);
+
+    const auto latency = ToDuration(frame.captureStartTime, now);
+    if (frame.isResized)
+    {
+        ++resizedFrameCount_;
+        lastResizedLatency_ = latency;
+    }
+    else
+    {
+        latencies_[latencyCount_ % kFrameCount] = latency;
+        ++latencyCount_;
+    }
+}
+
+
+FrameLatencyStats FrameLatencyTracker::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto latencyCount = min(latencyCount_, kFrameCount);
+    const auto intervalCount = min(intervalCount_, kFrameCount);
+
+    FrameLatencyStats stats {};
+    stats.frameCount = latencyCount;
+    stats.p50CaptureToRenderTime = GetPercentile(latencies_, latencyCount, 0.5f);
+    stats.p99CaptureToRenderTime = GetPercentile(latencies_, latencyCount, 0.99f);
+    stats.p50CaptureIntervalTime = GetPercentile(intervals_, intervalCount, 0.5f);
+    stats.captureIntervalJitter = GetStandardDeviation(intervals_, intervalCount);
+    stats.lastCaptureTime = lastCaptureTime_ * kMicrosecondsToMilliseconds;
+    stats.lastUploadTime = lastUploadTime_ * kMicrosecondsToMilliseconds;
+    stats.lastRenderTime = lastRenderTime_ * kMicrosecondsToMilliseconds;
+    stats.resizedFrameCount = resizedFrameCount_;
+    stats.lastResizedCaptureToRenderTime = lastResizedLatency_ * kMicrosecondsToMilliseconds;
+    return stats;
+}
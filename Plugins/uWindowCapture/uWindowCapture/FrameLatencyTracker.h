@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Platform.h"
+#include <mutex>
+
+
+// Durations are in milliseconds.
+struct FrameLatencyStats
+{
+    UINT frameCount;
+    float p50CaptureToRenderTime;
+    float p99CaptureToRenderTime;
+    float p50CaptureIntervalTime;
+    float captureIntervalJitter;
+    float lastCaptureTime;
+    float lastUploadTime;
+    float lastRenderTime;
+    UINT resizedFrameCount;
+    float lastResizedCaptureToRenderTime;
+};
+
+
+// Follows each frame of a window from the start of its capture until its copy to the Unity texture is issued.
+// The first frame after a resize also pays for recreating textures, so it is kept out of the distribution.
+class FrameLatencyTracker
+{
+public:
+    static constexpr UINT kFrameCount = 128;
+
+    static UINT64 GetTime();
+
+    void OnCaptured(UINT64 captureStartTime, UINT width, UINT height);
+    void OnUploaded();
+    void OnRendered();
+    FrameLatencyStats GetStats() const;
+
+private:
+    struct Frame
+    {
+        UINT64 captureStartTime = 0;
+        UINT64 captureEndTime = 0;
+        UINT64 uploadTime = 0;
+        bool isResized = false;
+    };
+
+    mutable std::mutex mutex_;
+    Frame capturedFrame_;
+    Frame uploadedFrame_;
+    bool hasCapturedFrame_ = false;
+    bool hasUploadedFrame_ = false;
+    UINT width_ = 0;
+    UINT height_ = 0;
+    UINT64 lastCaptureStartTime_ = 0;
+
+    UINT latencies_[kFrameCount] = {};
+    UINT latencyCount_ = 0;
+    UINT intervals_[kFrameCount] = {};
+    UINT intervalCount_ = 0;
+
+    UINT lastCaptureTime_ = 0;
+    UINT lastUploadTime_ = 0;
+    UINT lastRenderTime_ = 0;
+    UINT resizedFrameCount_ = 0;
+    UINT lastResizedLatency_ = 0;
+};
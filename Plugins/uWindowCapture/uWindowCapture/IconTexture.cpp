@@ -37,21 +37,26 @@ IconTexture::~IconTexture()
 
 void IconTexture::InitIcon()
 {
-    try
+    // Windows of backends without icons (e.g. synthetic ones) get the default icon.
+    const auto& backend = WindowManager::GetWindowBackend();
+    if (backend && backend->HasIcons())
     {
-        if (window_->IsUWP())
+        try
         {
-            InitIconHandleForStoreApp();
+            if (window_->IsUWP())
+            {
+                InitIconHandleForStoreApp();
+            }
+            else
+            {
+                InitIconHandleForWin32App();
+            }
         }
-        else
+        catch (const std::exception& e)
         {
-            InitIconHandleForWin32App();
+            Debug::Error(__FUNCTION__, " => Exception ", e.what());
         }
     }
-    catch (const std::exception& e)
-    {
-        Debug::Error(__FUNCTION__, " => Exception ", e.what());
-    }
 
     if (!hIcon_)
     {
@@ -117,11 +122,25 @@ void IconTexture::InitIconHandleForStoreApp()
         processId = window_->GetProcessId();
     }
 
+    if (const auto& metadataManager = WindowManager::GetMetadataManager())
+    {
+        appLogoPath_ = metadataManager->GetAppLogoPath(processId);
+    }
+    else
+    {
+        appLogoPath_ = FindAppLogoPath(processId);
+    }
+    CreateIconFromAppLogoPath();
+}
+
+
+std::wstring IconTexture::FindAppLogoPath(DWORD processId)
+{
     const auto hProcess = ::OpenProcess(
         PROCESS_QUERY_LIMITED_INFORMATION,
         FALSE,
         processId);
-    if (!hProcess) return;
+    if (!hProcess) return L"";
     ScopedReleaser processCloser([&] { ::CloseHandle(hProcess); });
 
     WCHAR dirPathBuf[512];
@@ -131,21 +150,21 @@ void IconTexture::InitIconHandleForStoreApp()
         if (!::QueryFullProcessImageNameW(hProcess, 0, dirPathBuf, &len))
         {
             OutputApiError(__FUNCTION__, "QueryFullProcessImageNameW");
-            return;
+            return L"";
         }
     }
     catch (...)
     {
         OutputApiError(__FUNCTION__, "QueryFullProcessImageNameW");
-        return;
+        return L"";
     }
 
-    if (!::PathRemoveFileSpecW(dirPathBuf)) return;
+    if (!::PathRemoveFileSpecW(dirPathBuf)) return L"";
     const std::wstring dirPath = dirPathBuf;
 
     const auto appManifestPath = dirPath + L"\\AppxManifest.xml";
     std::wifstream fs(appManifestPath);
-    if (!fs) return;
+    if (!fs) return L"";
 
     std::wstring logoRelativePath;
     {
@@ -160,15 +179,13 @@ void IconTexture::InitIconHandleForStoreApp()
                 break;
             }
         }
-        if (logoRelativePath.empty()) return;
+        if (logoRelativePath.empty()) return L"";
     }
 
     const auto logoPath = std::wstring(dirPath) + L"\\" + logoRelativePath;
     if (::PathFileExistsW(logoPath.c_str()))
     {
-        appLogoPath_ = logoPath;
-        CreateIconFromAppLogoPath();
-        return;
+        return logoPath;
     }
 
     std::wstring logoDirRelativePath;
@@ -177,7 +194,7 @@ void IconTexture::InitIconHandleForStoreApp()
     {
         std::wregex regex(L"(.+)\\\\([^\\.\\\\]+?)\\.(.+)$");
         std::wsmatch match {};
-        if (!std::regex_search(logoRelativePath, match, regex)) return;
+        if (!std::regex_search(logoRelativePath, match, regex)) return L"";
 
         logoDirRelativePath = match[1].str();
         logoFileName = match[2].str();
@@ -211,15 +228,14 @@ void IconTexture::InitIconHandleForStoreApp()
     } 
     while (FindNextFileW(hFile, &fd));
 
-    if (maxScale == 0) return;
+    if (maxScale == 0) return L"";
 
-    appLogoPath_ = 
+    return
         dirPath + L"\\" + 
         logoDirRelativePath + L"\\" +
         logoFileName + L".scale-" + 
         std::to_wstring(maxScale) +
         L"." + logoFileExt;
-    CreateIconFromAppLogoPath();
 }
 
 
@@ -303,7 +319,7 @@ bool IconTexture::Capture()
     }
 
     {
-        std::lock_guard<std::mutex> lock(bufferMutex_);
+        std::lock_guard<ProfiledMutex> lock(bufferMutex_);
         buffer_.ExpandIfNeeded(width_ * height_ * 4);
 
         auto* buffer32 = buffer_.As<UINT>();
@@ -349,7 +365,7 @@ bool IconTexture::Upload()
 {
     if (!unityTexture_.load() || buffer_.Empty()) return false;
 
-    std::lock_guard<std::mutex> lock(sharedTextureMutex_);
+    std::lock_guard<ProfiledMutex> lock(sharedTextureMutex_);
 
     {
         D3D11_TEXTURE2D_DESC desc;
@@ -380,7 +396,7 @@ bool IconTexture::Upload()
     }
 
     {
-        std::lock_guard<std::mutex> lock(bufferMutex_);
+        std::lock_guard<ProfiledMutex> lock(bufferMutex_);
         ComPtr<ID3D11DeviceContext> context;
         uploader->GetDevice()->GetImmediateContext(&context);
         context->UpdateSubresource(sharedTexture_.Get(), 0, nullptr, buffer_.Get(), GetWidth() * 4, 0);
@@ -405,7 +421,7 @@ bool IconTexture::Render()
 {
     if (!unityTexture_.load() || !sharedTexture_ || !sharedHandle_) return false;
 
-    std::lock_guard<std::mutex> lock(sharedTextureMutex_);
+    std::lock_guard<ProfiledMutex> lock(sharedTextureMutex_);
 
     ComPtr<ID3D11DeviceContext> context;
     GetUnityDevice()->GetImmediateContext(&context);
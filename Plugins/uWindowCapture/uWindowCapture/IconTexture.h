@@ -9,6 +9,7 @@
 #include <atomic>
 
 #include "Buffer.h"
+#include "ProfiledMutex.h"
 
 
 class Window;
@@ -35,6 +36,8 @@ public:
     bool Render();
     bool RenderOnce();
 
+    static std::wstring FindAppLogoPath(DWORD processId);
+
 private:
     void InitIconHandleForWin32App();
     void InitIconHandleForStoreApp();
@@ -46,10 +49,10 @@ private:
     std::atomic<ID3D11Texture2D*> unityTexture_ = nullptr;
     Microsoft::WRL::ComPtr<ID3D11Texture2D> sharedTexture_;
     HANDLE sharedHandle_ = nullptr;
-    std::mutex sharedTextureMutex_;
+    ProfiledMutex sharedTextureMutex_ { "IconTexture::sharedTextureMutex_" };
 
     Buffer<BYTE> buffer_;
-    std::mutex bufferMutex_;
+    ProfiledMutex bufferMutex_ { "IconTexture::bufferMutex_" };
 
     std::atomic<bool> hasCaptured_ = false;
     std::atomic<bool> hasUploaded_ = false;
@@ -0,0 +1,230 @@
+#include "LatencyHistogram.h"
+
+
+
+namespace
+{
+    constexpr float kMicrosecondsToMilliseconds = 1.f / 1000.f;
+}
+
+
+// ---
+
+
+UINT LatencyHistogram::GetBucketIndex(UINT us)
+{
+    if (us < kSubBucketCount) return us;
+
+    const UINT msb = Platform::GetMostSignificantBit(us);
+
+    const UINT shift = msb - kSubBucketBits;
+    const UINT sub = (us >> shift) & (kSubBucketCount - 1);
+    return min((shift + 1) * kSubBucketCount + sub, kBucketCount - 1);
+}
+
+
+UINT LatencyHistogram::GetBucketValue(UINT index)
+{
+    if (index < kSubBucketCount) return index;
+
+    // The middle of the bucket.
+    const UINT shift = index / kSubBucketCount - 1;
+    const UINT sub = index % kSubBucketCount;
+    return ((kSubBucketCount + sub) << shift) + ((1u << shift) >> 1);
+}
+
+
+void LatencyHistogram::Record(UINT us)
+{
+    counts_[GetBucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+
+    UINT prevMax = max_.load(std::memory_order_relaxed);
+    while (us > prevMax && !max_.compare_exchange_weak(prevMax, us, std::memory_order_relaxed));
+}
+
+
+void LatencyHistogram::AddTo(UINT* counts, UINT& maxUs) const
+{
+    for (UINT i = 0; i < kBucketCount; ++i)
+    {
+        counts[i] += counts_[i].load(std::memory_order_relaxed);
+    }
+    maxUs = max(maxUs, max_.load(std::memory_order_relaxed));
+}
+
+
+void LatencyHistogram::Reset()
+{
+    for (auto& count : counts_)
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+    max_.store(0, std::memory_order_relaxed);
+}
+
+
+LatencyStats LatencyHistogram::GetStats() const
+{
+    UINT counts[kBucketCount] = {};
+    UINT maxUs = 0;
+    AddTo(counts, maxUs);
+    return GetStats(counts, maxUs);
+}
+
+
+LatencyStats LatencyHistogram::GetStats(const UINT* counts, UINT maxUs)
+{
+    LatencyStats stats = {};
+
+    UINT64 total = 0;
+    for (UINT i = 0; i < kBucketCount; ++i)
+    {
+        total += counts[i];
+    }
+    if (total == 0) return stats;
+
+    const auto getPercentile = [&](UINT64 percent)
+    {
+        // The bucket which contains the n-th smallest value (1-origin).
+        const UINT64 n = max((total * percent + 99) / 100, 1ull);
+        UINT64 sum = 0;
+        for (UINT i = 0; i < kBucketCount; ++i)
+        {
+            sum += counts[i];
+            if (sum >= n)
+            {
+                return min(GetBucketValue(i), maxUs) * kMicrosecondsToMilliseconds;
+            }
+        }
+        return maxUs * kMicrosecondsToMilliseconds;
+    };
+
+    stats.count = static_cast<UINT>(min(total, static_cast<UINT64>(UINT_MAX)));
+    stats.p50Time = getPercentile(50);
+    stats.p90Time = getPercentile(90);
+    stats.p99Time = getPercentile(99);
+    stats.maxTime = maxUs * kMicrosecondsToMilliseconds;
+
+    return stats;
+}
+
+
+// ---
+
+
+void LatencyHistogramSet::Reset()
+{
+    for (auto& histogram : histograms_)
+    {
+        histogram.Reset();
+    }
+}
+
+
+// ---
+
+
+std::atomic<bool> LatencyMetrics::isEnabled_ = true;
+std::mutex LatencyMetrics::shardsMutex_;
+
+// Never deleted since threads may still record to their shards while the module is unloaded.
+std::vector<LatencyMetrics::Shard*>* LatencyMetrics::shards_ = new std::vector<LatencyMetrics::Shard*>();
+
+
+LatencyMetrics::Shard* LatencyMetrics::GetShard()
+{
+    // A shard is given back when its thread exits and reused by the next new thread.
+    struct ShardHolder
+    {
+        Shard* shard = nullptr;
+        ~ShardHolder()
+        {
+            if (shard) shard->isUsed = false;
+        }
+    };
+    thread_local ShardHolder holder;
+
+    if (holder.shard) return holder.shard;
+
+    std::lock_guard<std::mutex> lock(shardsMutex_);
+
+    for (auto* shard : *shards_)
+    {
+        bool isUsed = false;
+        if (shard->isUsed.compare_exchange_strong(isUsed, true))
+        {
+            holder.shard = shard;
+            return shard;
+        }
+    }
+
+    auto* shard = new Shard();
+    shard->isUsed = true;
+    shards_->push_back(shard);
+    holder.shard = shard;
+
+    return shard;
+}
+
+
+void LatencyMetrics::Record(PipelineStage stage, UINT us)
+{
+    if (!IsEnabled()) return;
+    GetShard()->histograms.Record(stage, us);
+}
+
+
+LatencyStats LatencyMetrics::GetStats(PipelineStage stage)
+{
+    UINT counts[LatencyHistogram::kBucketCount] = {};
+    UINT maxUs = 0;
+    {
+        std::lock_guard<std::mutex> lock(shardsMutex_);
+        for (const auto* shard : *shards_)
+        {
+            shard->histograms.Get(stage).AddTo(counts, maxUs);
+        }
+    }
+    return LatencyHistogram::GetStats(counts, maxUs);
+}
+
+
+void LatencyMetrics::Reset()
+{
+    std::lock_guard<std::mutex> lock(shardsMutex_);
+    for (auto* shard : *shards_)
+    {
+        shard->histograms.Reset();
+    }
+}
+
+
+// ---
+
+
+ScopedStageTimer::ScopedStageTimer(PipelineStage stage, LatencyHistogramSet* histograms)
+    : stage_(stage)
+    , histograms_(histograms)
+    , isEnabled_(LatencyMetrics::IsEnabled())
+{
+    if (isEnabled_)
+    {
+        start_ = std::chrono::steady_clock::now();
+    }
+}
+
+
+ScopedStageTimer::~ScopedStageTimer()
+{
+    if (!isEnabled_) return;
+
+    const auto elapsed = std::chrono::steady_clock::now() - start_;
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    const UINT clamped = static_cast<UINT>(min(us, static_cast<std::chrono::microseconds::rep>(UINT_MAX)));
+
+    LatencyMetrics::Record(stage_, clamped);
+    if (histograms_)
+    {
+        histograms_->Record(stage_, clamped);
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Platform.h"
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+
+
+enum class PipelineStage
+{
+    Enumerate = 0,
+    CaptureByPrintWindow = 1,
+    CaptureByBitBlt = 2,
+    CaptureByWindowsGraphicsCapture = 3,
+    GetDIBits = 4,
+    Upload = 5,
+    Render = 6,
+    GetPixels = 7,
+    Count = 8,
+};
+
+
+// Durations are in milliseconds.
+struct LatencyStats
+{
+    UINT count;
+    float p50Time;
+    float p90Time;
+    float p99Time;
+    float maxTime;
+};
+
+
+// Log-linear histogram of durations in microseconds which any thread can record to without locks.
+// Each power of two is split into linear sub-buckets, so percentiles are within 1/8 of the true values.
+class LatencyHistogram
+{
+public:
+    static constexpr UINT kSubBucketBits = 3;
+    static constexpr UINT kSubBucketCount = 1 << kSubBucketBits;
+    static constexpr UINT kBucketCount = 24 * kSubBucketCount;
+
+    void Record(UINT us);
+    void AddTo(UINT* counts, UINT& maxUs) const;
+    void Reset();
+    LatencyStats GetStats() const;
+
+    static LatencyStats GetStats(const UINT* counts, UINT maxUs);
+
+private:
+    static UINT GetBucketIndex(UINT us);
+    static UINT GetBucketValue(UINT index);
+
+    std::atomic<UINT> counts_[kBucketCount] = {};
+    std::atomic<UINT> max_ = 0;
+};
+
+
+class LatencyHistogramSet
+{
+public:
+    void Record(PipelineStage stage, UINT us) { Get(stage).Record(us); }
+    LatencyStats GetStats(PipelineStage stage) const { return Get(stage).GetStats(); }
+    void Reset();
+
+    LatencyHistogram& Get(PipelineStage stage) { return histograms_[static_cast<int>(stage)]; }
+    const LatencyHistogram& Get(PipelineStage stage) const { return histograms_[static_cast<int>(stage)]; }
+
+private:
+    LatencyHistogram histograms_[static_cast<int>(PipelineStage::Count)];
+};
+
+
+// Process-wide histograms of the pipeline stages. Each thread records to its own shard
+// and the shards are summed only when the stats are read.
+class LatencyMetrics
+{
+public:
+    static void SetEnabled(bool enabled) { isEnabled_.store(enabled, std::memory_order_relaxed); }
+    static bool IsEnabled() { return isEnabled_.load(std::memory_order_relaxed); }
+    static void Record(PipelineStage stage, UINT us);
+    static LatencyStats GetStats(PipelineStage stage);
+    static void Reset();
+
+private:
+    struct Shard
+    {
+        LatencyHistogramSet histograms;
+        std::atomic<bool> isUsed = false;
+    };
+
+    static Shard* GetShard();
+
+    static std::atomic<bool> isEnabled_;
+    static std::vector<Shard*>* shards_;
+    static std::mutex shardsMutex_;
+};
+
+
+// Records the duration of the scope to the process-wide histogram of the stage
+// and optionally to the given per-window ones. Only a relaxed load is paid while disabled.
+class ScopedStageTimer
+{
+public:
+    explicit ScopedStageTimer(PipelineStage stage, LatencyHistogramSet* histograms = nullptr);
+    ~ScopedStageTimer();
+
+private:
+    const PipelineStage stage_;
+    LatencyHistogramSet* const histograms_;
+    const bool isEnabled_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+
+#define UWC_STAGE_TIMER(Stage, Histograms) \
+    ScopedStageTimer _stageTimer_##__COUNTER__(PipelineStage::Stage, Histograms);
@@ -2,6 +2,7 @@
 #include <dxgi1_2.h>
 #include <Windows.h>
 #include <memory>
+#include <algorithm>
 
 #include "IUnityInterface.h"
 #include "IUnityGraphics.h"
@@ -14,6 +15,9 @@
 #include "Cursor.h"
 #include "WindowTexture.h"
 #include "WindowManager.h"
+#include "TraceRecorder.h"
+#include "ProfiledMutex.h"
+#include "Thread.h"
 
 #include "Util.h"
 
@@ -103,6 +107,12 @@ bool g_hasInitialized = false;
 // unity interafece to access ID3D11Device.
 IUnityInterfaces* g_unity = nullptr;
 
+// fake windows used instead of the real ones if windowCount > 0.
+SyntheticWindowSettings g_syntheticWindowSettings = {};
+
+// capture without Unity's graphics device if true.
+bool g_isHeadless = false;
+
 
 std::shared_ptr<Window> GetWindow(int id)
 {
@@ -125,6 +135,8 @@ extern "C"
         MessageManager::Create();
 
         WindowManager::Create();
+        WindowManager::Get().SetSyntheticWindowSettings(g_syntheticWindowSettings);
+        WindowManager::Get().SetHeadless(g_isHeadless);
         WindowManager::Get().Initialize();
     }
 
@@ -187,6 +199,25 @@ extern "C"
         Debug::SetErrorFunc(func);
     }
 
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcSetSyntheticWindowBackend(UINT windowCount, UINT width, UINT height, UINT churnInterval)
+    {
+        // Takes effect from the next UwcInitialize().
+        g_syntheticWindowSettings = { windowCount, width, height, churnInterval };
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcSetHeadless(bool isHeadless)
+    {
+        // Takes effect from the next UwcInitialize(), which a headless host calls by itself
+        // since no graphics device event comes.
+        g_isHeadless = isHeadless;
+    }
+
+    UNITY_INTERFACE_EXPORT bool UNITY_INTERFACE_API UwcIsHeadless()
+    {
+        if (WindowManager::IsNull()) return g_isHeadless;
+        return WindowManager::IsHeadless();
+    }
+
     void UNITY_INTERFACE_API OnRenderEvent(int id)
     {
         if (WindowManager::IsNull()) return;
@@ -272,6 +303,105 @@ extern "C"
         WindowManager::GetCaptureManager()->RequestCaptureIcon(id);
     }
 
+    UNITY_INTERFACE_EXPORT UINT UNITY_INTERFACE_API UwcRequestCaptureGroup(const int* ids, int count)
+    {
+        if (WindowManager::IsNull()) return 0;
+        return WindowManager::GetCaptureManager()->RequestCaptureGroup(ids, count);
+    }
+
+    UNITY_INTERFACE_EXPORT UINT UNITY_INTERFACE_API UwcGetLastReleasedCaptureGroupSequence()
+    {
+        if (WindowManager::IsNull()) return 0;
+        return WindowManager::GetCaptureManager()->GetLastReleasedCaptureGroupSequence();
+    }
+
+    UNITY_INTERFACE_EXPORT UINT UNITY_INTERFACE_API UwcGetWindowCaptureGroupSequence(int id)
+    {
+        if (auto window = GetWindow(id))
+        {
+            return window->GetCaptureGroupSequence();
+        }
+        return 0;
+    }
+
+    UNITY_INTERFACE_EXPORT ULONGLONG UNITY_INTERFACE_API UwcGetWindowCaptureGroupTimestamp(int id)
+    {
+        if (auto window = GetWindow(id))
+        {
+            return window->GetCaptureGroupTimestamp();
+        }
+        return 0;
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcSetWindowImportance(const int* ids, const float* weights, int count)
+    {
+        if (WindowManager::IsNull()) return;
+
+        // Null arrays clear the importance as count <= 0 does.
+        if (!ids || !weights) count = 0;
+        WindowManager::GetCaptureManager()->SetWindowImportance(ids, weights, count);
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcSetCaptureBudget(float maxCapturesPerSecond, float minCapturesPerSecondPerWindow)
+    {
+        if (WindowManager::IsNull()) return;
+        WindowManager::GetCaptureManager()->SetCaptureBudget(maxCapturesPerSecond, minCapturesPerSecondPerWindow);
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcSetWindowTextureIdleTimeout(UINT milliseconds)
+    {
+        if (WindowManager::IsNull()) return;
+        WindowManager::Get().SetWindowTextureIdleTimeout(milliseconds);
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcSetCaptureDeadline(UINT milliseconds)
+    {
+        if (WindowManager::IsNull()) return;
+        WindowManager::GetCaptureManager()->SetCaptureDeadline(milliseconds);
+    }
+
+    UNITY_INTERFACE_EXPORT bool UNITY_INTERFACE_API UwcIsWindowCaptureQuarantined(int id)
+    {
+        if (WindowManager::IsNull()) return false;
+        return WindowManager::GetCaptureManager()->IsCaptureQuarantined(id);
+    }
+
+    UNITY_INTERFACE_EXPORT CaptureStallStats UNITY_INTERFACE_API UwcGetCaptureStallStats()
+    {
+        if (WindowManager::IsNull()) return {};
+        return WindowManager::GetCaptureManager()->GetCaptureStallStats();
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcSetCaptureLeaseDuration(UINT milliseconds)
+    {
+        if (WindowManager::IsNull()) return;
+        WindowManager::Get().SetCaptureLeaseDuration(milliseconds);
+    }
+
+    UNITY_INTERFACE_EXPORT IdleReleaseStats UNITY_INTERFACE_API UwcGetIdleReleaseStats()
+    {
+        if (WindowManager::IsNull()) return {};
+        return WindowManager::Get().GetIdleReleaseStats();
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcSetWindowListIntervalRange(UINT minMilliseconds, UINT maxMilliseconds)
+    {
+        if (WindowManager::IsNull()) return;
+        WindowManager::Get().SetWindowListIntervalRange(minMilliseconds, maxMilliseconds);
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcRequestUpdateWindowList()
+    {
+        if (WindowManager::IsNull()) return;
+        WindowManager::Get().RequestWindowListUpdate();
+    }
+
+    UNITY_INTERFACE_EXPORT WindowListStats UNITY_INTERFACE_API UwcGetWindowListStats()
+    {
+        if (WindowManager::IsNull()) return {};
+        return WindowManager::Get().GetWindowListStats();
+    }
+
     UNITY_INTERFACE_EXPORT HWND UNITY_INTERFACE_API UwcGetWindowOwnerHandle(int id)
     {
         if (auto window = GetWindow(id))
@@ -371,6 +501,143 @@ extern "C"
         return nullptr;
     }
 
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcSetLockProfilerEnabled(bool enabled)
+    {
+        LockProfiler::SetEnabled(enabled);
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcResetLockStats()
+    {
+        LockProfiler::Reset();
+    }
+
+    UNITY_INTERFACE_EXPORT UINT UNITY_INTERFACE_API UwcGetLockCount()
+    {
+        return LockProfiler::GetLockCount();
+    }
+
+    UNITY_INTERFACE_EXPORT const char* UNITY_INTERFACE_API UwcGetLockName(UINT index)
+    {
+        return LockProfiler::GetLockName(index);
+    }
+
+    UNITY_INTERFACE_EXPORT LockStats UNITY_INTERFACE_API UwcGetLockStats(UINT index)
+    {
+        return LockProfiler::GetStats(index);
+    }
+
+    UNITY_INTERFACE_EXPORT UINT UNITY_INTERFACE_API UwcGetThreadCount()
+    {
+        return ThreadLoop::GetThreadCount();
+    }
+
+    UNITY_INTERFACE_EXPORT const wchar_t* UNITY_INTERFACE_API UwcGetThreadName(UINT index)
+    {
+        return ThreadLoop::GetThreadName(index);
+    }
+
+    UNITY_INTERFACE_EXPORT ThreadLoopStats UNITY_INTERFACE_API UwcGetThreadStats(UINT index)
+    {
+        return ThreadLoop::GetStats(index);
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcResetThreadStats()
+    {
+        ThreadLoop::ResetStats();
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcStartTrace()
+    {
+        TraceRecorder::Start();
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcStopTrace()
+    {
+        TraceRecorder::Stop();
+    }
+
+    UNITY_INTERFACE_EXPORT bool UNITY_INTERFACE_API UwcIsTraceRecording()
+    {
+        return TraceRecorder::IsRecording();
+    }
+
+    UNITY_INTERFACE_EXPORT bool UNITY_INTERFACE_API UwcDumpTrace(const char* path)
+    {
+        if (!path) return false;
+        return TraceRecorder::Dump(path);
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcSetLatencyMetricsEnabled(bool enabled)
+    {
+        LatencyMetrics::SetEnabled(enabled);
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcResetLatencyMetrics()
+    {
+        LatencyMetrics::Reset();
+    }
+
+    UNITY_INTERFACE_EXPORT LatencyStats UNITY_INTERFACE_API UwcGetStageLatencyStats(PipelineStage stage)
+    {
+        if (stage < PipelineStage::Enumerate || stage >= PipelineStage::Count) return {};
+        return LatencyMetrics::GetStats(stage);
+    }
+
+    UNITY_INTERFACE_EXPORT LatencyStats UNITY_INTERFACE_API UwcGetWindowStageLatencyStats(int id, PipelineStage stage)
+    {
+        if (stage < PipelineStage::Enumerate || stage >= PipelineStage::Count) return {};
+        if (auto window = GetWindow(id))
+        {
+            return window->GetLatencyStats(stage);
+        }
+        return {};
+    }
+
+    UNITY_INTERFACE_EXPORT FrameLatencyStats UNITY_INTERFACE_API UwcGetWindowFrameLatencyStats(int id)
+    {
+        if (auto window = GetWindow(id))
+        {
+            return window->GetFrameLatencyStats();
+        }
+        return {};
+    }
+
+    UNITY_INTERFACE_EXPORT bool UNITY_INTERFACE_API UwcComposeVirtualDesktop()
+    {
+        if (WindowManager::IsNull()) return false;
+        return WindowManager::Get().ComposeVirtualDesktop();
+    }
+
+    UNITY_INTERFACE_EXPORT const BYTE* UNITY_INTERFACE_API UwcGetVirtualDesktopBuffer()
+    {
+        if (WindowManager::IsNull()) return nullptr;
+        return WindowManager::Get().GetVirtualDesktopCompositor().GetBuffer();
+    }
+
+    UNITY_INTERFACE_EXPORT int UNITY_INTERFACE_API UwcGetVirtualDesktopX()
+    {
+        if (WindowManager::IsNull()) return 0;
+        return WindowManager::Get().GetVirtualDesktopCompositor().GetBounds().left;
+    }
+
+    UNITY_INTERFACE_EXPORT int UNITY_INTERFACE_API UwcGetVirtualDesktopY()
+    {
+        if (WindowManager::IsNull()) return 0;
+        return WindowManager::Get().GetVirtualDesktopCompositor().GetBounds().top;
+    }
+
+    UNITY_INTERFACE_EXPORT UINT UNITY_INTERFACE_API UwcGetVirtualDesktopWidth()
+    {
+        if (WindowManager::IsNull()) return 0;
+        return WindowManager::Get().GetVirtualDesktopCompositor().GetWidth();
+    }
+
+    UNITY_INTERFACE_EXPORT UINT UNITY_INTERFACE_API UwcGetVirtualDesktopHeight()
+    {
+        if (WindowManager::IsNull()) return 0;
+        return WindowManager::Get().GetVirtualDesktopCompositor().GetHeight();
+    }
+
     UNITY_INTERFACE_EXPORT UINT UNITY_INTERFACE_API UwcGetWindowTextureWidth(int id)
     {
         if (auto window = GetWindow(id))
@@ -429,7 +696,7 @@ extern "C"
     {
         if (auto window = GetWindow(id))
         {
-            return static_cast<UINT>(window->GetTitle().length());
+            return static_cast<UINT>(window->GetTitle()->length());
         }
         return 0;
     }
@@ -438,7 +705,7 @@ extern "C"
     {
         if (auto window = GetWindow(id))
         {
-            return window->GetTitle().c_str();
+            return window->GetTitleForHost();
         }
         return nullptr;
     }
@@ -632,11 +899,28 @@ extern "C"
     {
         if (auto window = GetWindow(id))
         {
-            return IsUWP(window->GetProcessId());
+            // Resolving the package opens the process, so it is left to the metadata thread.
+            if (window->IsMetadataResolved(Window::kMetadataUWP))
+            {
+                return window->IsUWP() > 0;
+            }
+            if (const auto& metadataManager = WindowManager::GetMetadataManager())
+            {
+                metadataManager->RequestUpdate(id);
+            }
         }
         return false;
     }
 
+    UNITY_INTERFACE_EXPORT UINT UNITY_INTERFACE_API UwcGetWindowResolvedMetadata(int id)
+    {
+        if (auto window = GetWindow(id))
+        {
+            return window->GetResolvedMetadata();
+        }
+        return 0;
+    }
+
     UNITY_INTERFACE_EXPORT bool UNITY_INTERFACE_API UwcIsWindowBackground(int id)
     {
         if (auto window = GetWindow(id))
@@ -690,6 +974,55 @@ extern "C"
         return -1;
     }
 
+    // Unlike UwcGetWindowIdFromPoint(), the points are looked up in the spatial index of the last enumeration.
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcGetWindowIdsFromPoints(const POINT* points, int* ids, int count)
+    {
+        if (!points || !ids || count <= 0) return;
+        if (WindowManager::IsNull()) 
+        {
+            std::fill(ids, ids + count, -1);
+            return;
+        }
+        WindowManager::Get().GetWindowIdsFromPoints(points, ids, count);
+    }
+
+    UNITY_INTERFACE_EXPORT float UNITY_INTERFACE_API UwcGetWindowVisibleFraction(int id)
+    {
+        if (auto window = GetWindow(id))
+        {
+            return window->GetVisibleFraction();
+        }
+        return 0.f;
+    }
+
+    UNITY_INTERFACE_EXPORT int UNITY_INTERFACE_API UwcGetWindowVisibleRectCount(int id)
+    {
+        if (auto window = GetWindow(id))
+        {
+            return static_cast<int>(window->GetVisibleRects().size());
+        }
+        return 0;
+    }
+
+    UNITY_INTERFACE_EXPORT int UNITY_INTERFACE_API UwcGetWindowVisibleRects(int id, RECT* rects, int count)
+    {
+        if (!rects || count <= 0) return 0;
+        if (auto window = GetWindow(id))
+        {
+            const auto visibleRects = window->GetVisibleRects();
+            const int n = min(count, static_cast<int>(visibleRects.size()));
+            std::copy(visibleRects.begin(), visibleRects.begin() + n, rects);
+            return n;
+        }
+        return 0;
+    }
+
+    UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UwcSetOccludedWindowCapturePolicy(OccludedWindowCapturePolicy policy)
+    {
+        if (WindowManager::IsNull()) return;
+        WindowManager::GetCaptureManager()->SetOccludedWindowCapturePolicy(policy);
+    }
+
     UNITY_INTERFACE_EXPORT int UNITY_INTERFACE_API UwcGetWindowIdUnderCursor()
     {
         if (WindowManager::IsNull()) return -1;
@@ -8,14 +8,14 @@ UWC_SINGLETON_INSTANCE(MessageManager)
 
 UINT MessageManager::GetCount() const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<ProfiledMutex> lock(mutex_);
     return static_cast<UINT>(messages_.size());
 }
 
 
 const Message* MessageManager::GetHeadPointer() const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<ProfiledMutex> lock(mutex_);
     if (messages_.empty()) return nullptr;
     return &messages_[0];
 }
@@ -23,21 +23,21 @@ const Message* MessageManager::GetHeadPointer() const
 
 void MessageManager::Add(Message message)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<ProfiledMutex> lock(mutex_);
     messages_.push_back(message);
 }
 
 
 void MessageManager::ClearAll()
 {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<ProfiledMutex> lock(mutex_);
     messages_.clear();
 }
 
 
 void MessageManager::ExcludeRemovedWindowEvents()
 {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<ProfiledMutex> lock(mutex_);
 
     std::set<int> removedWinedowIds; 
     for (const auto& message : messages_)
@@ -1,10 +1,11 @@
 #pragma once
 
-#include <Windows.h>
+#include "Platform.h"
 #include <vector>
 #include <mutex>
 
 #include "Singleton.h"
+#include "ProfiledMutex.h"
 
 
 
@@ -17,6 +18,8 @@ enum class MessageType : int
     WindowSizeChanged = 3,
     IconCaptured = 4,
     CursorCaptured = 5,
+    WindowMoved = 6,
+    WindowZOrderChanged = 7,
     Error = 1000,
     TextureNullError = 1001,
     TextureSizeError = 1002,
@@ -46,5 +49,5 @@ public:
 
 private:
     std::vector<Message> messages_;
-    mutable std::mutex mutex_;
+    mutable ProfiledMutex mutex_ { "MessageManager::mutex_" };
 };
\ No newline at end of file
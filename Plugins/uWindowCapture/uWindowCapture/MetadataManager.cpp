@@ -0,0 +1,104 @@
+#include "MetadataManager.h"
+#include "WindowManager.h"
+#include "IconTexture.h"
+#include "Window.h"
+#include "TraceRecorder.h"
+#include "Debug.h"
+#include "Util.h"
+
+
+
+namespace
+{
+    constexpr auto kLoopMinTime = std::chrono::microseconds(100);
+}
+
+
+// ---
+
+
+MetadataManager::MetadataManager()
+{
+    threadLoop_.Start([this] 
+    {
+        const int id = queue_.Dequeue();
+        if (id >= 0)
+        {
+            if (auto window = WindowManager::Get().GetWindow(id))
+            {
+                UWC_TRACE_SCOPE("UpdateMetadata", id)
+                window->UpdateMetadata();
+                return true;
+            }
+        }
+        return false;
+    }, kLoopMinTime);
+}
+
+
+MetadataManager::~MetadataManager()
+{
+    threadLoop_.Stop();
+}
+
+
+void MetadataManager::RequestUpdate(int id)
+{
+    queue_.Enqueue(id);
+}
+
+
+bool MetadataManager::IsUWP(DWORD processId)
+{
+    {
+        std::lock_guard<std::mutex> lock(processInfoCacheMutex_);
+        const auto& info = processInfoCache_[processId];
+        if (info.hasUWP) return info.isUWP;
+    }
+
+    // Resolve it without the lock since it opens the process.
+    const bool isUWP = ::IsUWP(processId);
+
+    std::lock_guard<std::mutex> lock(processInfoCacheMutex_);
+    auto& info = processInfoCache_[processId];
+    info.hasUWP = true;
+    info.isUWP = isUWP;
+    return isUWP;
+}
+
+
+std::wstring MetadataManager::GetAppLogoPath(DWORD processId)
+{
+    {
+        std::lock_guard<std::mutex> lock(processInfoCacheMutex_);
+        const auto& info = processInfoCache_[processId];
+        if (info.hasAppLogoPath) return info.appLogoPath;
+    }
+
+    auto path = IconTexture::FindAppLogoPath(processId);
+
+    std::lock_guard<std::mutex> lock(processInfoCacheMutex_);
+    auto& info = processInfoCache_[processId];
+    info.hasAppLogoPath = true;
+    info.appLogoPath = path;
+    return path;
+}
+
+
+void MetadataManager::RemoveProcessesExcept(const std::unordered_set<DWORD>& processIds)
+{
+    // Process ids are reused by the system, so forget the ones which have no window anymore.
+    std::lock_guard<std::mutex> lock(processInfoCacheMutex_);
+
+    for (auto it = processInfoCache_.begin(); it != processInfoCache_.end();)
+    {
+        if (processIds.find(it->first) == processIds.end())
+        {
+            it = processInfoCache_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
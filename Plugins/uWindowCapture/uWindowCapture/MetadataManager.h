@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Windows.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+
+#include "WindowQueue.h"
+#include "Thread.h"
+
+
+// Resolves window metadata which may block (e.g. the title of a hung window or the package of a process)
+// in its own thread so that the window handle list thread is never kept waiting.
+class MetadataManager
+{
+public:
+    MetadataManager();
+    ~MetadataManager();
+    void RequestUpdate(int id);
+
+    bool IsUWP(DWORD processId);
+    std::wstring GetAppLogoPath(DWORD processId);
+    void RemoveProcessesExcept(const std::unordered_set<DWORD>& processIds);
+
+private:
+    struct ProcessInfo
+    {
+        bool hasUWP = false;
+        bool isUWP = false;
+        bool hasAppLogoPath = false;
+        std::wstring appLogoPath;
+    };
+
+    ThreadLoop threadLoop_ = { L"uWindowCapture - Window Metadata Thread" };
+    WindowQueue queue_;
+    std::unordered_map<DWORD, ProcessInfo> processInfoCache_;
+    std::mutex processInfoCacheMutex_;
+};
@@ -0,0 +1,21 @@
+#include <cstring>
+#include "PixelKernel.h"
+
+
+
+void CopyBgraToRgbaFlipped(const BYTE* src, UINT srcPitch, BYTE* dst, UINT width, UINT height)
+{
+    for (UINT j = 0; j < height; ++j)
+    {
+        const auto* in = src + (height - 1 - j) * static_cast<size_t>(srcPitch);
+        auto* out = dst + j * static_cast<size_t>(width) * 4;
+
+        for (UINT i = 0; i < width; ++i)
+        {
+            UINT32 pixel;
+            memcpy(&pixel, in + i * 4, 4);
+            pixel = (pixel & 0xff00ff00) | ((pixel & 0x000000ff) << 16) | ((pixel & 0x00ff0000) >> 16);
+            memcpy(out + i * 4, &pixel, 4);
+        }
+    }
+}
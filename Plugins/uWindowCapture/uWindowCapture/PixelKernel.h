@@ -0,0 +1,8 @@
+#pragma once
+
+#include "Platform.h"
+
+
+// Copies a BGRA region into RGBA rows stored from the bottom, which is the layout of Texture2D.GetPixels32().
+// srcPitch is the byte size of a source row; the destination is tightly packed.
+void CopyBgraToRgbaFlipped(const BYTE* src, UINT srcPitch, BYTE* dst, UINT width, UINT height);
@@ -0,0 +1,196 @@
+#include "Platform.h"
+
+#ifdef _WIN32
+#include <intrin.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <chrono>
+#include <cerrno>
+#endif
+
+
+
+#ifdef _WIN32
+
+
+DWORD Platform::GetCurrentThreadId()
+{
+    return ::GetCurrentThreadId();
+}
+
+
+DWORD Platform::GetCurrentProcessId()
+{
+    return ::GetCurrentProcessId();
+}
+
+
+DWORD Platform::GetLastError()
+{
+    return ::GetLastError();
+}
+
+
+UINT64 Platform::GetCurrentThreadCpuTime()
+{
+    FILETIME creation, exit, kernel, user;
+    if (!::GetThreadTimes(::GetCurrentThread(), &creation, &exit, &kernel, &user)) return 0;
+
+    const auto ToUINT64 = [](const FILETIME& time)
+    {
+        return (static_cast<UINT64>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+
+    // FILETIME is in 100-nanosecond units.
+    return (ToUINT64(kernel) + ToUINT64(user)) / 10;
+}
+
+
+void Platform::SetThreadName(std::thread& thread, const std::wstring& name)
+{
+    const auto hThread = static_cast<HANDLE>(thread.native_handle());
+    ::SetThreadDescription(hThread, name.c_str());
+}
+
+
+LONGLONG Platform::GetPerformanceCounter()
+{
+    LARGE_INTEGER counter;
+    ::QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+
+LONGLONG Platform::GetPerformanceFrequency()
+{
+    LARGE_INTEGER frequency;
+    ::QueryPerformanceFrequency(&frequency);
+    return frequency.QuadPart;
+}
+
+
+UINT Platform::GetMostSignificantBit(UINT value)
+{
+    unsigned long msb = 0;
+    _BitScanReverse(&msb, value);
+    return msb;
+}
+
+
+bool Platform::GetLocalTime(time_t time, tm& outTime)
+{
+    return localtime_s(&outTime, &time) == 0;
+}
+
+
+std::string Platform::ToUtf8(const std::wstring& str)
+{
+    if (str.empty()) return "";
+    const int size = ::WideCharToMultiByte(CP_UTF8, 0, str.c_str(), -1, nullptr, 0, nullptr, nullptr);
+    std::string buf(size, '\0');
+    ::WideCharToMultiByte(CP_UTF8, 0, str.c_str(), -1, &buf[0], size, nullptr, nullptr);
+    buf.resize(size - 1);
+    return buf;
+}
+
+
+#else
+
+
+DWORD Platform::GetCurrentThreadId()
+{
+    return static_cast<DWORD>(::syscall(SYS_gettid));
+}
+
+
+DWORD Platform::GetCurrentProcessId()
+{
+    return static_cast<DWORD>(::getpid());
+}
+
+
+DWORD Platform::GetLastError()
+{
+    return static_cast<DWORD>(errno);
+}
+
+
+UINT64 Platform::GetCurrentThreadCpuTime()
+{
+    timespec time;
+    if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) return 0;
+    return static_cast<UINT64>(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+}
+
+
+void Platform::SetThreadName(std::thread& thread, const std::wstring& name)
+{
+    // Linux limits thread names to 15 characters.
+    auto utf8 = ToUtf8(name);
+    if (utf8.size() > 15) utf8.resize(15);
+    ::pthread_setname_np(thread.native_handle(), utf8.c_str());
+}
+
+
+LONGLONG Platform::GetPerformanceCounter()
+{
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+
+LONGLONG Platform::GetPerformanceFrequency()
+{
+    return 1000000000;
+}
+
+
+UINT Platform::GetMostSignificantBit(UINT value)
+{
+    return 31 - __builtin_clz(value);
+}
+
+
+bool Platform::GetLocalTime(time_t time, tm& outTime)
+{
+    return ::localtime_r(&time, &outTime) != nullptr;
+}
+
+
+std::string Platform::ToUtf8(const std::wstring& str)
+{
+    std::string buf;
+    buf.reserve(str.size());
+    for (const wchar_t c : str)
+    {
+        const auto code = static_cast<uint32_t>(c);
+        if (code < 0x80)
+        {
+            buf += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            buf += static_cast<char>(0xc0 | (code >> 6));
+            buf += static_cast<char>(0x80 | (code & 0x3f));
+        }
+        else if (code < 0x10000)
+        {
+            buf += static_cast<char>(0xe0 | (code >> 12));
+            buf += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            buf += static_cast<char>(0x80 | (code & 0x3f));
+        }
+        else
+        {
+            buf += static_cast<char>(0xf0 | (code >> 18));
+            buf += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+            buf += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            buf += static_cast<char>(0x80 | (code & 0x3f));
+        }
+    }
+    return buf;
+}
+
+
+#endif
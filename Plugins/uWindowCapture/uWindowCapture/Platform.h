@@ -0,0 +1,125 @@
+#pragma once
+
+// The core of the plugin (scheduling, queues, buffers, messages and the reconciliation of the window list)
+// only depends on this header instead of <Windows.h>, so that it can be built and tested on other platforms.
+#ifdef _WIN32
+
+#include <Windows.h>
+
+#else
+
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+using BOOL = int;
+using BYTE = uint8_t;
+using INT = int;
+using UINT = unsigned int;
+using UINT32 = uint32_t;
+using LONG = int32_t;
+using DWORD = uint32_t;
+using LONGLONG = long long;
+using UINT64 = unsigned long long;
+using ULONGLONG = unsigned long long;
+using UINT_PTR = uintptr_t;
+using HANDLE = void*;
+using HWND = struct HWND__*;
+using HMONITOR = struct HMONITOR__*;
+using HINSTANCE = struct HINSTANCE__*;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+struct RECT
+{
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+};
+
+struct POINT
+{
+    LONG x;
+    LONG y;
+};
+
+inline void ZeroMemory(void* dest, size_t size)
+{
+    memset(dest, 0, size);
+}
+
+inline BOOL IsRectEmpty(const RECT* rect)
+{
+    return rect->left >= rect->right || rect->top >= rect->bottom;
+}
+
+inline BOOL EqualRect(const RECT* a, const RECT* b)
+{
+    return a->left == b->left && a->top == b->top && a->right == b->right && a->bottom == b->bottom;
+}
+
+inline BOOL IntersectRect(RECT* dest, const RECT* a, const RECT* b)
+{
+    const RECT rect = { max(a->left, b->left), max(a->top, b->top), min(a->right, b->right), min(a->bottom, b->bottom) };
+    if (IsRectEmpty(&rect))
+    {
+        *dest = {};
+        return FALSE;
+    }
+    *dest = rect;
+    return TRUE;
+}
+
+inline BOOL UnionRect(RECT* dest, const RECT* a, const RECT* b)
+{
+    if (IsRectEmpty(a))
+    {
+        *dest = IsRectEmpty(b) ? RECT{} : *b;
+    }
+    else if (IsRectEmpty(b))
+    {
+        *dest = *a;
+    }
+    else
+    {
+        *dest = { min(a->left, b->left), min(a->top, b->top), max(a->right, b->right), max(a->bottom, b->bottom) };
+    }
+    return !IsRectEmpty(dest);
+}
+
+#endif
+
+#include <ctime>
+#include <string>
+#include <thread>
+
+
+namespace Platform
+{
+    DWORD GetCurrentThreadId();
+    DWORD GetCurrentProcessId();
+    DWORD GetLastError();
+
+    // CPU time (user + kernel) consumed by the calling thread in microseconds.
+    UINT64 GetCurrentThreadCpuTime();
+    void SetThreadName(std::thread& thread, const std::wstring& name);
+
+    LONGLONG GetPerformanceCounter();
+    LONGLONG GetPerformanceFrequency();
+
+    // Index of the most significant set bit; the value must not be 0.
+    UINT GetMostSignificantBit(UINT value);
+
+    bool GetLocalTime(time_t time, tm& outTime);
+    std::string ToUtf8(const std::wstring& str);
+}
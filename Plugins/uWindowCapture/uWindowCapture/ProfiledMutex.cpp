@@ -0,0 +1,164 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include "ProfiledMutex.h"
+
+
+
+namespace
+{
+    struct Entry
+    {
+        std::string name;
+        LockCounters counters;
+    };
+
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Entry>> entries;
+    };
+
+
+    Registry& GetRegistry()
+    {
+        // Leaked so that mutexes with static storage can be used until the very end.
+        static auto* registry = new Registry();
+        return *registry;
+    }
+
+
+    UINT64 GetTicks()
+    {
+        return static_cast<UINT64>(Platform::GetPerformanceCounter());
+    }
+
+
+    float TicksToMilliseconds(UINT64 ticks)
+    {
+        static const double frequency = static_cast<double>(Platform::GetPerformanceFrequency());
+        return static_cast<float>(ticks * 1000.0 / frequency);
+    }
+
+
+    void UpdateMax(std::atomic<UINT64>& maxValue, UINT64 value)
+    {
+        auto current = maxValue.load(std::memory_order_relaxed);
+        while (value > current && !maxValue.compare_exchange_weak(current, value, std::memory_order_relaxed));
+    }
+}
+
+
+// ---
+
+
+std::atomic<bool> LockProfiler::isEnabled_ = false;
+
+
+LockCounters* LockProfiler::Register(const char* name)
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    for (const auto& entry : registry.entries)
+    {
+        if (entry->name == name) return &entry->counters;
+    }
+
+    registry.entries.push_back(std::make_unique<Entry>());
+    registry.entries.back()->name = name;
+    return &registry.entries.back()->counters;
+}
+
+
+UINT LockProfiler::GetLockCount()
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return static_cast<UINT>(registry.entries.size());
+}
+
+
+const char* LockProfiler::GetLockName(UINT index)
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (index >= registry.entries.size()) return nullptr;
+    return registry.entries[index]->name.c_str();
+}
+
+
+LockStats LockProfiler::GetStats(UINT index)
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (index >= registry.entries.size()) return {};
+
+    const auto& counters = registry.entries[index]->counters;
+    LockStats stats {};
+    stats.acquisitionCount = counters.acquisitionCount.load(std::memory_order_relaxed);
+    stats.contendedCount = counters.contendedCount.load(std::memory_order_relaxed);
+    stats.totalWaitTime = TicksToMilliseconds(counters.totalWaitTicks.load(std::memory_order_relaxed));
+    stats.maxWaitTime = TicksToMilliseconds(counters.maxWaitTicks.load(std::memory_order_relaxed));
+    stats.totalHoldTime = TicksToMilliseconds(counters.totalHoldTicks.load(std::memory_order_relaxed));
+    stats.maxHoldTime = TicksToMilliseconds(counters.maxHoldTicks.load(std::memory_order_relaxed));
+    return stats;
+}
+
+
+void LockProfiler::Reset()
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    for (const auto& entry : registry.entries)
+    {
+        auto& counters = entry->counters;
+        counters.acquisitionCount = 0;
+        counters.contendedCount = 0;
+        counters.totalWaitTicks = 0;
+        counters.maxWaitTicks = 0;
+        counters.totalHoldTicks = 0;
+        counters.maxHoldTicks = 0;
+    }
+}
+
+
+// ---
+
+
+#ifndef UWC_LOCK_PROFILER_OFF
+
+void ProfiledMutex::LockProfiled()
+{
+    if (!mutex_.try_lock())
+    {
+        const auto start = GetTicks();
+        mutex_.lock();
+        const auto wait = GetTicks() - start;
+
+        counters_->contendedCount.fetch_add(1, std::memory_order_relaxed);
+        counters_->totalWaitTicks.fetch_add(wait, std::memory_order_relaxed);
+        UpdateMax(counters_->maxWaitTicks, wait);
+    }
+
+    lockedTicks_ = OnAcquired();
+}
+
+
+UINT64 ProfiledMutex::OnAcquired()
+{
+    counters_->acquisitionCount.fetch_add(1, std::memory_order_relaxed);
+    return GetTicks();
+}
+
+
+void ProfiledMutex::OnReleased()
+{
+    const auto hold = GetTicks() - lockedTicks_;
+    counters_->totalHoldTicks.fetch_add(hold, std::memory_order_relaxed);
+    UpdateMax(counters_->maxHoldTicks, hold);
+}
+
+#endif
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Platform.h"
+#include <atomic>
+#include <mutex>
+
+
+// Build with UWC_LOCK_PROFILER_OFF to make ProfiledMutex a plain std::mutex.
+// #define UWC_LOCK_PROFILER_OFF
+
+
+// Durations are in milliseconds.
+struct LockStats
+{
+    UINT64 acquisitionCount;
+    UINT64 contendedCount;
+    float totalWaitTime;
+    float maxWaitTime;
+    float totalHoldTime;
+    float maxHoldTime;
+};
+
+
+// Shared by all the mutexes with the same name. Times are in QueryPerformanceCounter() ticks.
+struct LockCounters
+{
+    std::atomic<UINT64> acquisitionCount = 0;
+    std::atomic<UINT64> contendedCount = 0;
+    std::atomic<UINT64> totalWaitTicks = 0;
+    std::atomic<UINT64> maxWaitTicks = 0;
+    std::atomic<UINT64> totalHoldTicks = 0;
+    std::atomic<UINT64> maxHoldTicks = 0;
+};
+
+
+// Registry of the named locks. Recording is off by default and can be switched at runtime.
+class LockProfiler
+{
+public:
+    static void SetEnabled(bool enabled) { isEnabled_.store(enabled, std::memory_order_relaxed); }
+    static bool IsEnabled() { return isEnabled_.load(std::memory_order_relaxed); }
+    static void Reset();
+
+    static LockCounters* Register(const char* name);
+    static UINT GetLockCount();
+    static const char* GetLockName(UINT index);
+    static LockStats GetStats(UINT index);
+
+private:
+    static std::atomic<bool> isEnabled_;
+};
+
+
+#ifndef UWC_LOCK_PROFILER_OFF
+
+class ProfiledMutex
+{
+public:
+    explicit ProfiledMutex(const char* name) : counters_(LockProfiler::Register(name)) {}
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    void lock()
+    {
+        if (LockProfiler::IsEnabled())
+        {
+            LockProfiled();
+            return;
+        }
+        mutex_.lock();
+        lockedTicks_ = 0;
+    }
+
+    bool try_lock()
+    {
+        if (!mutex_.try_lock()) return false;
+        lockedTicks_ = LockProfiler::IsEnabled() ? OnAcquired() : 0;
+        return true;
+    }
+
+    void unlock()
+    {
+        if (lockedTicks_ != 0)
+        {
+            OnReleased();
+        }
+        mutex_.unlock();
+    }
+
+private:
+    void LockProfiled();
+    UINT64 OnAcquired();
+    void OnReleased();
+
+    std::mutex mutex_;
+    LockCounters* const counters_;
+    UINT64 lockedTicks_ = 0;
+};
+
+#else
+
+class ProfiledMutex : public std::mutex
+{
+public:
+    explicit ProfiledMutex(const char*) {}
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include "RectSet.h"
+
+
+
+namespace
+{
+    bool IsEmptyRect(const RECT& rect)
+    {
+        return rect.left >= rect.right || rect.top >= rect.bottom;
+    }
+
+    bool Overlaps(const RECT& a, const RECT& b)
+    {
+        return 
+            a.left < b.right && b.left < a.right &&
+            a.top < b.bottom && b.top < a.bottom;
+    }
+}
+
+
+// ---
+
+
+RectSet::RectSet(const RECT& rect)
+{
+    if (!IsEmptyRect(rect))
+    {
+        rects_.push_back(rect);
+    }
+}
+
+
+RectSet RectSet::GetVisibleRegion(const RECT& rect, const std::vector<RECT>& monitors, const std::vector<RECT>& occluders)
+{
+    RectSet region;
+    for (const auto& monitor : monitors)
+    {
+        region.Unite(monitor);
+    }
+
+    region.Intersect(rect);
+    for (const auto& occluder : occluders)
+    {
+        if (region.IsEmpty()) break;
+        region.Subtract(occluder);
+    }
+
+    return region;
+}
+
+
+void RectSet::Unite(const RECT& rect)
+{
+    if (IsEmptyRect(rect)) return;
+
+    // The rectangles are kept disjoint by removing the overlapped parts first.
+    Subtract(rect);
+    rects_.push_back(rect);
+}
+
+
+void RectSet::Intersect(const RECT& rect)
+{
+    buffer_.clear();
+
+    for (const auto& r : rects_)
+    {
+        const RECT clipped = 
+        {
+            max(r.left, rect.left),
+            max(r.top, rect.top),
+            min(r.right, rect.right),
+            min(r.bottom, rect.bottom),
+        };
+        if (!IsEmptyRect(clipped))
+        {
+            buffer_.push_back(clipped);
+        }
+    }
+
+    rects_.swap(buffer_);
+}
+
+
+void RectSet::Subtract(const RECT& rect)
+{
+    if (IsEmptyRect(rect)) return;
+
+    buffer_.clear();
+
+    for (const auto& r : rects_)
+    {
+        if (!Overlaps(r, rect))
+        {
+            buffer_.push_back(r);
+            continue;
+        }
+
+        // Split the rest into the bands above and below, and the pieces on the left and right.
+        const LONG top = max(r.top, rect.top);
+        const LONG bottom = min(r.bottom, rect.bottom);
+
+        if (r.top < rect.top)
+        {
+            buffer_.push_back({ r.left, r.top, r.right, rect.top });
+        }
+        if (rect.bottom < r.bottom)
+        {
+            buffer_.push_back({ r.left, rect.bottom, r.right, r.bottom });
+        }
+        if (r.left < rect.left)
+        {
+            buffer_.push_back({ r.left, top, rect.left, bottom });
+        }
+        if (rect.right < r.right)
+        {
+            buffer_.push_back({ rect.right, top, r.right, bottom });
+        }
+    }
+
+    rects_.swap(buffer_);
+}
+
+
+LONGLONG RectSet::GetArea() const
+{
+    LONGLONG area = 0;
+    for (const auto& r : rects_)
+    {
+        area += static_cast<LONGLONG>(r.right - r.left) * (r.bottom - r.top);
+    }
+    return area;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Platform.h"
+#include <vector>
+
+
+// Set of non-overlapping rectangles, e.g. the visible region of a window covered by other windows.
+class RectSet
+{
+public:
+    RectSet() = default;
+    explicit RectSet(const RECT& rect);
+
+    // Part of rect inside the union of the monitors (which may overlap when mirrored) and not covered by the occluders.
+    static RectSet GetVisibleRegion(const RECT& rect, const std::vector<RECT>& monitors, const std::vector<RECT>& occluders);
+
+    void Unite(const RECT& rect);
+    void Intersect(const RECT& rect);
+    void Subtract(const RECT& rect);
+
+    bool IsEmpty() const { return rects_.empty(); }
+    LONGLONG GetArea() const;
+    const std::vector<RECT>& GetRects() const { return rects_; }
+    std::vector<RECT> Release() { return std::move(rects_); }
+
+private:
+    std::vector<RECT> rects_;
+    std::vector<RECT> buffer_;
+};
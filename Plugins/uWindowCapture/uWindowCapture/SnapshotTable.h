@@ -0,0 +1,205 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Platform.h"
+
+
+// Table of entries addressed by a small index, written by one thread and read by any thread.
+// The writer publishes immutable versions of the table. A version shares the chunks of entries
+// which have not changed since the previous one, so that publishing does not copy the whole table.
+// A default constructed T marks an empty entry.
+//
+// Readers find the current version through a version number instead of std::atomic_load() of a shared_ptr,
+// which MSVC implements with a single spinlock shared by the whole process. The last kSlotCount versions
+// are kept in a ring; a reader pins its slot with a counter while it copies the shared_ptr out of it,
+// and the writer waits for those counters only when it reuses a slot which is kSlotCount versions old.
+template <class T>
+class SnapshotTable
+{
+    static constexpr size_t kChunkSize = 64;
+    using Chunk = std::array<T, kChunkSize>;
+
+public:
+    class Snapshot
+    {
+    public:
+        class Iterator
+        {
+        public:
+            Iterator(const Snapshot* snapshot, size_t index) : snapshot_(snapshot), index_(index) { SkipEmpty(); }
+            const T& operator*() const { return snapshot_->Get(index_); }
+            Iterator& operator++() { ++index_; SkipEmpty(); return *this; }
+            bool operator!=(const Iterator& other) const { return index_ != other.index_; }
+
+        private:
+            void SkipEmpty()
+            {
+                while (index_ < snapshot_->GetCapacity() && !snapshot_->Get(index_)) ++index_;
+            }
+
+            const Snapshot* snapshot_;
+            size_t index_;
+        };
+
+        UINT64 GetVersion() const { return version_; }
+        size_t GetSize() const { return size_; }
+        size_t GetCapacity() const { return chunks_.size() * kChunkSize; }
+
+        // Returns an empty entry for an index out of range.
+        const T& Get(size_t index) const
+        {
+            static const T empty {};
+            const size_t chunkIndex = index / kChunkSize;
+            if (chunkIndex >= chunks_.size() || !chunks_[chunkIndex]) return empty;
+            return (*chunks_[chunkIndex])[index % kChunkSize];
+        }
+
+        Iterator begin() const { return Iterator(this, 0); }
+        Iterator end() const { return Iterator(this, GetCapacity()); }
+
+    private:
+        friend class SnapshotTable;
+
+        UINT64 version_ = 0;
+        size_t size_ = 0;
+        std::vector<std::shared_ptr<const Chunk>> chunks_;
+    };
+
+    SnapshotTable() = default;
+    SnapshotTable(const SnapshotTable&) = delete;
+    SnapshotTable& operator=(const SnapshotTable&) = delete;
+
+    // Writer thread only. Changes are not visible to readers until Publish().
+    void Set(size_t index, T value)
+    {
+        const size_t chunkIndex = index / kChunkSize;
+        if (chunkIndex >= chunks_.size())
+        {
+            chunks_.resize(chunkIndex + 1);
+            isShared_.resize(chunkIndex + 1, false);
+        }
+
+        auto& chunk = chunks_[chunkIndex];
+        if (!chunk)
+        {
+            chunk = std::make_shared<Chunk>();
+        }
+        else if (isShared_[chunkIndex])
+        {
+            // The published versions keep the old chunk.
+            chunk = std::make_shared<Chunk>(*chunk);
+        }
+        isShared_[chunkIndex] = false;
+
+        auto& entry = (*chunk)[index % kChunkSize];
+        if (entry) --size_;
+        entry = std::move(value);
+        if (entry) ++size_;
+    }
+
+    void Reset(size_t index)
+    {
+        if (!Get(index)) return;
+        Set(index, T {});
+    }
+
+    void Clear()
+    {
+        chunks_.clear();
+        isShared_.clear();
+        size_ = 0;
+    }
+
+    const T& Get(size_t index) const
+    {
+        static const T empty {};
+        const size_t chunkIndex = index / kChunkSize;
+        if (chunkIndex >= chunks_.size() || !chunks_[chunkIndex]) return empty;
+        return (*chunks_[chunkIndex])[index % kChunkSize];
+    }
+
+    size_t GetSize() const { return size_; }
+
+    void Publish()
+    {
+        auto snapshot = std::make_shared<Snapshot>();
+        snapshot->version_ = latestVersion_ + 1;
+        snapshot->size_ = size_;
+        snapshot->chunks_.reserve(chunks_.size());
+        for (const auto& chunk : chunks_)
+        {
+            snapshot->chunks_.push_back(chunk);
+        }
+        isShared_.assign(chunks_.size(), true);
+
+        Store(std::move(snapshot));
+    }
+
+    // Makes Acquire() return nullptr, e.g. on finalization.
+    void Unpublish()
+    {
+        Store(nullptr);
+    }
+
+    // Any thread. Returns nullptr until the first Publish().
+    std::shared_ptr<const Snapshot> Acquire() const
+    {
+        for (;;)
+        {
+            const UINT64 version = currentVersion_.load();
+            auto& slot = slots_[version % kSlotCount];
+
+            slot.readerCount.fetch_add(1);
+            if (slot.version.load() == version)
+            {
+                auto snapshot = slot.snapshot;
+                slot.readerCount.fetch_sub(1);
+                return snapshot;
+            }
+
+            // The writer has lapped the ring since the version was loaded.
+            slot.readerCount.fetch_sub(1);
+        }
+    }
+
+private:
+    static constexpr size_t kSlotCount = 4;
+    static constexpr UINT64 kInvalidVersion = ~0ull;
+
+    struct alignas(64) Slot
+    {
+        std::atomic<UINT64> version { 0 };
+        std::atomic<int> readerCount { 0 };
+        std::shared_ptr<const Snapshot> snapshot;
+    };
+
+    void Store(std::shared_ptr<const Snapshot> snapshot)
+    {
+        const UINT64 version = ++latestVersion_;
+        auto& slot = slots_[version % kSlotCount];
+
+        // Invalidating the slot before checking the readers pairs with the readers
+        // incrementing the counter before checking the version (both sequentially consistent).
+        slot.version.store(kInvalidVersion);
+        while (slot.readerCount.load() > 0)
+        {
+            std::this_thread::yield();
+        }
+
+        slot.snapshot = std::move(snapshot);
+        slot.version.store(version);
+        currentVersion_.store(version);
+    }
+
+    std::vector<std::shared_ptr<Chunk>> chunks_;
+    std::vector<bool> isShared_;
+    size_t size_ = 0;
+    UINT64 latestVersion_ = 0;
+
+    mutable std::array<Slot, kSlotCount> slots_;
+    std::atomic<UINT64> currentVersion_ { 0 };
+};
@@ -0,0 +1,208 @@
+#include <cstdint>
+#include "SyntheticWindowBackend.h"
+
+
+
+namespace
+{
+    // Real window handles only use the lower 32 bits even in 64-bit processes, so the fake ones are put above them.
+    // 32-bit builds have no such free range and rely on the fake handles never leaving this backend.
+#if UINTPTR_MAX > 0xffffffff
+    constexpr UINT_PTR kHandleBase = 0x7ff000000000;
+#else
+    constexpr UINT_PTR kHandleBase = 0x7ff00000;
+#endif
+    const std::string kClassName = "uWindowCaptureSyntheticWindow";
+    constexpr LONG kCascadeStep = 24;
+    constexpr UINT kCascadeCount = 32;
+    constexpr UINT kBarWidth = 16;
+    constexpr UINT kBarSpeed = 240 /* pixels per second */;
+
+
+    UINT32 GetBaseColor(UINT serial)
+    {
+        // BGRA with a different hue for each window.
+        const BYTE r = static_cast<BYTE>(64 + (serial * 97) % 160);
+        const BYTE g = static_cast<BYTE>(64 + (serial * 57) % 160);
+        const BYTE b = static_cast<BYTE>(64 + (serial * 31) % 160);
+        return 0xff000000 | (r << 16) | (g << 8) | b;
+    }
+}
+
+
+// ---
+
+
+SyntheticWindowBackend::SyntheticWindowBackend(const SyntheticWindowSettings& settings)
+    : settings_(settings)
+    , startTime_(std::chrono::steady_clock::now())
+    , lastChurnTime_(startTime_)
+{
+    for (UINT i = 0; i < settings_.windowCount; ++i)
+    {
+        slots_.push_back(AddWindow());
+    }
+}
+
+
+HWND SyntheticWindowBackend::AddWindow()
+{
+    const auto serial = nextSerial_++;
+    const auto hWnd = reinterpret_cast<HWND>(kHandleBase + serial * 4);
+    serials_.emplace(hWnd, serial);
+    return hWnd;
+}
+
+
+void SyntheticWindowBackend::ReplaceWindow(UINT slot)
+{
+    serials_.erase(slots_[slot]);
+    slots_[slot] = AddWindow();
+}
+
+
+void SyntheticWindowBackend::EnumerateWindows(std::vector<WindowData>& windows)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto now = std::chrono::steady_clock::now();
+    if (settings_.churnInterval > 0 && !slots_.empty())
+    {
+        const auto interval = std::chrono::milliseconds(settings_.churnInterval);
+        while (now - lastChurnTime_ >= interval)
+        {
+            lastChurnTime_ += interval;
+            ReplaceWindow(nextChurnSlot_);
+            nextChurnSlot_ = (nextChurnSlot_ + 1) % static_cast<UINT>(slots_.size());
+        }
+    }
+
+    for (UINT i = 0; i < static_cast<UINT>(slots_.size()); ++i)
+    {
+        WindowData data;
+        data.hWnd = slots_[i];
+        data.hOwner = NULL;
+        data.windowRect = GetWindowRect(i);
+        data.clientRect = { 0, 0, static_cast<LONG>(settings_.width), static_cast<LONG>(settings_.height) };
+        data.zOrder = i;
+        data.hMonitor = NULL;
+        data.isDesktop = false;
+        windows.push_back(data);
+    }
+}
+
+
+RECT SyntheticWindowBackend::GetWindowRect(UINT slot) const
+{
+    const LONG offset = (slot % kCascadeCount) * kCascadeStep;
+    const LONG width = static_cast<LONG>(settings_.width);
+    const LONG height = static_cast<LONG>(settings_.height);
+    return { offset, offset, offset + width, offset + height };
+}
+
+
+bool SyntheticWindowBackend::FindSerial(HWND hWnd, UINT& serial) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = serials_.find(hWnd);
+    if (it == serials_.end()) return false;
+    serial = it->second;
+    return true;
+}
+
+
+bool SyntheticWindowBackend::IsWindow(HWND hWnd) const
+{
+    UINT serial;
+    return FindSerial(hWnd, serial);
+}
+
+
+bool SyntheticWindowBackend::IsWindowVisible(HWND hWnd) const
+{
+    return IsWindow(hWnd);
+}
+
+
+HWND SyntheticWindowBackend::GetWindowFromPoint(POINT point) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // The slots are in the order of the enumeration, i.e. from the front.
+    for (UINT i = 0; i < static_cast<UINT>(slots_.size()); ++i)
+    {
+        const auto rect = GetWindowRect(i);
+        if (rect.left <= point.x && point.x < rect.right && rect.top <= point.y && point.y < rect.bottom)
+        {
+            return slots_[i];
+        }
+    }
+    return NULL;
+}
+
+
+bool SyntheticWindowBackend::GetWindowAttributes(HWND hWnd, WindowAttributes& attributes) const
+{
+    UINT serial;
+    if (!FindSerial(hWnd, serial)) return false;
+
+    // Each window gets its own thread so that none of them is taken as the parent of another.
+    attributes.hParent = NULL;
+    attributes.hInstance = NULL;
+    attributes.processId = Platform::GetCurrentProcessId();
+    attributes.threadId = serial + 1;
+    attributes.isAltTabWindow = false;
+    attributes.className = kClassName;
+    return true;
+}
+
+
+bool SyntheticWindowBackend::GetWindowTitle(HWND hWnd, std::wstring& title) const
+{
+    UINT serial;
+    if (!FindSerial(hWnd, serial)) return false;
+
+    title = L"Synthetic Window " + std::to_wstring(serial);
+    return true;
+}
+
+
+bool SyntheticWindowBackend::GetWindowState(HWND hWnd, WindowState state) const
+{
+    UINT serial;
+    if (!FindSerial(hWnd, serial)) return false;
+
+    return state == WindowState::Enabled || state == WindowState::Unicode;
+}
+
+
+bool SyntheticWindowBackend::CaptureFrame(HWND hWnd, Buffer<BYTE>& buffer, UINT& width, UINT& height)
+{
+    UINT serial;
+    if (!FindSerial(hWnd, serial)) return false;
+
+    width = settings_.width;
+    height = settings_.height;
+    if (width == 0 || height == 0) return false;
+
+    buffer.ExpandIfNeeded(width * height * 4);
+
+    // A vertical bar sweeps across a flat color so that every frame differs from the previous one.
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime_).count();
+    const UINT barX = static_cast<UINT>((elapsed * kBarSpeed / 1000 + serial * 37) % width);
+    const UINT32 baseColor = GetBaseColor(serial);
+    constexpr UINT32 barColor = 0xffffffff;
+
+    auto* pixels = buffer.As<UINT32>();
+    for (UINT y = 0; y < height; ++y)
+    {
+        auto* row = pixels + y * width;
+        for (UINT x = 0; x < width; ++x)
+        {
+            row[x] = (x - barX < kBarWidth) ? barColor : baseColor;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Platform.h"
+#include <unordered_map>
+#include <chrono>
+#include <mutex>
+
+#include "WindowBackend.h"
+
+
+struct SyntheticWindowSettings
+{
+    UINT windowCount;
+    UINT width;
+    UINT height;
+    UINT churnInterval; // milliseconds, 0 keeps the same windows
+};
+
+
+// Generates fake windows laid out in a cascade and animated frames for them.
+// Every query for the fake handles is answered here, so they never reach the Win32 APIs.
+class SyntheticWindowBackend : public WindowBackend
+{
+public:
+    explicit SyntheticWindowBackend(const SyntheticWindowSettings& settings);
+
+    void EnumerateWindows(std::vector<WindowData>& windows) override;
+    bool IsWindow(HWND hWnd) const override;
+    bool IsWindowVisible(HWND hWnd) const override;
+    HWND GetWindowFromPoint(POINT point) const override;
+    HWND GetParentWindow(HWND) const override { return NULL; }
+    bool GetWindowAttributes(HWND hWnd, WindowAttributes& attributes) const override;
+    bool GetWindowTitle(HWND hWnd, std::wstring& title) const override;
+    bool GetWindowState(HWND hWnd, WindowState state) const override;
+    bool HasIcons() const override { return false; }
+    bool HasFrames() const override { return true; }
+    bool CaptureFrame(HWND hWnd, Buffer<BYTE>& buffer, UINT& width, UINT& height) override;
+
+private:
+    HWND AddWindow();
+    void ReplaceWindow(UINT slot);
+    bool FindSerial(HWND hWnd, UINT& serial) const;
+    RECT GetWindowRect(UINT slot) const;
+
+    const SyntheticWindowSettings settings_;
+    const std::chrono::steady_clock::time_point startTime_;
+    std::chrono::steady_clock::time_point lastChurnTime_;
+    UINT nextSerial_ = 0;
+    UINT nextChurnSlot_ = 0;
+    std::vector<HWND> slots_;
+    std::unordered_map<HWND, UINT> serials_;
+    mutable std::mutex mutex_;
+};
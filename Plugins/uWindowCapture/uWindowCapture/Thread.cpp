@@ -1,30 +1,48 @@
-#pragma once
-
+#include <vector>
+#include <memory>
 #include "Thread.h"
+#include "TraceRecorder.h"
 #include "Debug.h"
-#include "Util.h"
 
 
 
-class ScopedThreadSleeper : public ScopedTimer
+namespace
 {
-public:
-    template <class T>
-    explicit ScopedThreadSleeper(const T& duration) : 
-        ScopedTimer([duration] (microseconds us)
-        {
-            const auto waitTime = duration - us;
-            if (waitTime > microseconds::zero())
-            {
-                std::this_thread::sleep_for(waitTime);
-            }
-        }) 
-    {}
-};
+    struct Entry
+    {
+        std::wstring name;
+        ThreadLoopCounters counters;
+    };
+
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Entry>> entries;
+    };
+
+
+    Registry& GetRegistry()
+    {
+        // Leaked so that the stats outlive the loops and can be read after they are destroyed.
+        static auto* registry = new Registry();
+        return *registry;
+    }
+
+
+    float MicrosecondsToMilliseconds(UINT64 us)
+    {
+        return static_cast<float>(us / 1000.0);
+    }
+}
+
+
+// ---
 
 
 ThreadLoop::ThreadLoop(const std::wstring& name)
     : name_(name)
+    , counters_(Register(name))
 {
 }
 
@@ -35,7 +53,7 @@ ThreadLoop::~ThreadLoop()
 }
 
 
-void ThreadLoop::Start(const ThreadFunc& func, const microseconds& interval)
+void ThreadLoop::Start(const LoopFunc& func, const microseconds& interval)
 {
     if (isRunning_) return;
 
@@ -51,15 +69,35 @@ void ThreadLoop::Start(const ThreadFunc& func, const microseconds& interval)
 
     thread_ = std::thread([this] 
     {
+        TraceRecorder::SetThreadName(name_);
+
         if (initializerFunc_) 
         {
             initializerFunc_();
         }
 
+        // CPU time is added as the difference so that every run of the loop accumulates into the same counters.
+        auto cpuTimeUs = Platform::GetCurrentThreadCpuTime();
+
         while (isRunning_)
         {
-            ScopedThreadSleeper sleeper(interval_);
-            loopFunc_();
+            using namespace std::chrono;
+
+            const auto start = steady_clock::now();
+            const bool hasWorked = loopFunc_();
+            const auto end = steady_clock::now();
+            WaitUntil(start + interval_.load());
+
+            const auto currentCpuTimeUs = Platform::GetCurrentThreadCpuTime();
+            counters_->iterationCount.fetch_add(1, std::memory_order_relaxed);
+            if (hasWorked)
+            {
+                counters_->workedIterationCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            counters_->loopTimeUs.fetch_add(duration_cast<microseconds>(end - start).count(), std::memory_order_relaxed);
+            counters_->runningTimeUs.fetch_add(duration_cast<microseconds>(steady_clock::now() - start).count(), std::memory_order_relaxed);
+            counters_->cpuTimeUs.fetch_add(currentCpuTimeUs - cpuTimeUs, std::memory_order_relaxed);
+            cpuTimeUs = currentCpuTimeUs;
         }
 
         if (finalizerFunc_) 
@@ -70,8 +108,7 @@ void ThreadLoop::Start(const ThreadFunc& func, const microseconds& interval)
 
     if (!name_.empty())
     {
-        const auto hThread = static_cast<HANDLE>(thread_.native_handle());
-        ::SetThreadDescription(hThread, name_.c_str());
+        Platform::SetThreadName(thread_, name_);
     }
 }
 
@@ -87,6 +124,7 @@ void ThreadLoop::Stop()
     if (!isRunning_) return;
 
     isRunning_ = false;
+    Wake();
 
     if (thread_.joinable())
     {
@@ -95,6 +133,25 @@ void ThreadLoop::Stop()
 }
 
 
+void ThreadLoop::Wake()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        hasWakeRequested_ = true;
+    }
+    wakeCondition_.notify_one();
+}
+
+
+void ThreadLoop::WaitUntil(const std::chrono::steady_clock::time_point& time)
+{
+    // Wake() cuts the wait short, e.g. when new work has come or the loop is stopped.
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    wakeCondition_.wait_until(lock, time, [this] { return hasWakeRequested_; });
+    hasWakeRequested_ = false;
+}
+
+
 bool ThreadLoop::IsRunning() const
 {
     return isRunning_;
@@ -105,3 +162,71 @@ bool ThreadLoop::HasFunction() const
 {
     return loopFunc_ != nullptr;
 }
+
+
+ThreadLoopCounters* ThreadLoop::Register(const std::wstring& name)
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    for (const auto& entry : registry.entries)
+    {
+        if (entry->name == name) return &entry->counters;
+    }
+
+    registry.entries.push_back(std::make_unique<Entry>());
+    registry.entries.back()->name = name;
+    return &registry.entries.back()->counters;
+}
+
+
+UINT ThreadLoop::GetThreadCount()
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return static_cast<UINT>(registry.entries.size());
+}
+
+
+const wchar_t* ThreadLoop::GetThreadName(UINT index)
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (index >= registry.entries.size()) return nullptr;
+    return registry.entries[index]->name.c_str();
+}
+
+
+ThreadLoopStats ThreadLoop::GetStats(UINT index)
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (index >= registry.entries.size()) return {};
+
+    const auto& counters = registry.entries[index]->counters;
+    ThreadLoopStats stats {};
+    stats.iterationCount = counters.iterationCount.load(std::memory_order_relaxed);
+    stats.workedIterationCount = min(counters.workedIterationCount.load(std::memory_order_relaxed), stats.iterationCount);
+    stats.idleIterationCount = stats.iterationCount - stats.workedIterationCount;
+    stats.runningTime = MicrosecondsToMilliseconds(counters.runningTimeUs.load(std::memory_order_relaxed));
+    stats.loopTime = MicrosecondsToMilliseconds(counters.loopTimeUs.load(std::memory_order_relaxed));
+    stats.cpuTime = MicrosecondsToMilliseconds(counters.cpuTimeUs.load(std::memory_order_relaxed));
+    return stats;
+}
+
+
+void ThreadLoop::ResetStats()
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    for (const auto& entry : registry.entries)
+    {
+        auto& counters = entry->counters;
+        counters.iterationCount = 0;
+        counters.workedIterationCount = 0;
+        counters.runningTimeUs = 0;
+        counters.loopTimeUs = 0;
+        counters.cpuTimeUs = 0;
+    }
+}
@@ -1,36 +1,81 @@
 #pragma once
 
+#include "Platform.h"
 #include <functional>
 #include <string>
 #include <chrono>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+
+// Accumulated over all the runs of the loops with the same name. Times are in milliseconds.
+struct ThreadLoopStats
+{
+    UINT64 iterationCount;
+    UINT64 workedIterationCount;
+    UINT64 idleIterationCount;
+    float runningTime;
+    float loopTime;
+    float cpuTime;
+};
+
+
+struct ThreadLoopCounters
+{
+    std::atomic<UINT64> iterationCount = 0;
+    std::atomic<UINT64> workedIterationCount = 0;
+    std::atomic<UINT64> runningTimeUs = 0;
+    std::atomic<UINT64> loopTimeUs = 0;
+    std::atomic<UINT64> cpuTimeUs = 0;
+};
 
 
 class ThreadLoop
 {
 public:
     using ThreadFunc = std::function<void()>;
+    // Returns whether the iteration did any work, which tells busy iterations from idle spins.
+    using LoopFunc = std::function<bool()>;
     using microseconds = std::chrono::microseconds;
 
     ThreadLoop(const std::wstring& name);
     ~ThreadLoop();
     void Start(
-        const ThreadFunc& func,
+        const LoopFunc& func,
         const microseconds& interval = microseconds(1'000'000 / 60));
     void Restart();
     void Stop();
+    void Wake();
+    void SetInterval(const microseconds& interval) { interval_ = interval; }
+    microseconds GetInterval() const { return interval_; }
     void SetInitializer(const ThreadFunc& func) { initializerFunc_ = func; }
     void SetFinalizer(const ThreadFunc& func) { finalizerFunc_ = func; }
     bool IsRunning() const;
     bool HasFunction() const;
 
+    static UINT GetThreadCount();
+    static const wchar_t* GetThreadName(UINT index);
+    static ThreadLoopStats GetStats(UINT index);
+    static void ResetStats();
+
+    // Threads which are not loops (e.g. the capture workers) add their work to the counters of their own name.
+    // The counters are never freed, so they can be kept for the lifetime of the thread.
+    static ThreadLoopCounters* Register(const std::wstring& name);
+
 private:
+    void WaitUntil(const std::chrono::steady_clock::time_point& time);
+
     const std::wstring name_;
+    ThreadLoopCounters* const counters_;
     std::thread thread_;
     std::atomic<bool> isRunning_ = false;
-    microseconds interval_ = microseconds::zero();
-    ThreadFunc loopFunc_ = nullptr;
+    std::atomic<microseconds> interval_ = microseconds::zero();
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+    bool hasWakeRequested_ = false;
+    LoopFunc loopFunc_ = nullptr;
     ThreadFunc finalizerFunc_ = nullptr;
     ThreadFunc initializerFunc_ = nullptr;
 };
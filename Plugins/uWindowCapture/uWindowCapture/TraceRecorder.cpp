@@ -0,0 +1,199 @@
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include "TraceRecorder.h"
+#include "Debug.h"
+
+
+
+namespace
+{
+    const auto kTraceStartTime = std::chrono::steady_clock::now();
+
+    std::string EscapeJson(const std::string& str)
+    {
+        std::string escaped;
+        escaped.reserve(str.size());
+        for (const char c : str)
+        {
+            if (c == '"' || c == '\\') escaped += '\\';
+            if (static_cast<unsigned char>(c) < 0x20) continue;
+            escaped += c;
+        }
+        return escaped;
+    }
+}
+
+
+// ---
+
+
+std::atomic<bool> TraceRecorder::isRecording_ = false;
+std::atomic<UINT64> TraceRecorder::nextIndex_ = 0;
+TraceRecorder::Event* TraceRecorder::events_ = nullptr;
+std::unordered_map<DWORD, std::wstring> TraceRecorder::threadNames_;
+std::mutex TraceRecorder::mutex_;
+
+
+void TraceRecorder::Start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (isRecording_) return;
+
+    // Allocated on the first use and never freed since other threads may be writing to it.
+    if (!events_)
+    {
+        events_ = new Event[kEventCount];
+    }
+
+    // Each recording starts from an empty ring.
+    for (UINT i = 0; i < kEventCount; ++i)
+    {
+        events_[i].sequence = 0;
+    }
+    nextIndex_ = 0;
+
+    isRecording_ = true;
+}
+
+
+void TraceRecorder::Stop()
+{
+    isRecording_ = false;
+}
+
+
+LONGLONG TraceRecorder::GetTime()
+{
+    const auto elapsed = std::chrono::steady_clock::now() - kTraceStartTime;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+
+void TraceRecorder::SetThreadName(const std::wstring& name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    threadNames_[Platform::GetCurrentThreadId()] = name;
+}
+
+
+void TraceRecorder::Record(const char* name, int windowId, LONGLONG startUs, LONGLONG endUs)
+{
+    if (!IsRecording() || !events_) return;
+
+    // A seqlock per slot: odd while it is being written, 2 * (index + 1) once complete.
+    const UINT64 index = nextIndex_.fetch_add(1, std::memory_order_relaxed);
+    auto& event = events_[index & (kEventCount - 1)];
+    event.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    event.name = name;
+    event.windowId = windowId;
+    event.threadId = Platform::GetCurrentThreadId();
+    event.startUs = startUs;
+    event.endUs = endUs;
+
+    event.sequence.store(index * 2 + 2, std::memory_order_release);
+}
+
+
+bool TraceRecorder::Dump(const std::string& path)
+{
+    std::unordered_map<DWORD, std::wstring> threadNames;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!events_) return false;
+        threadNames = threadNames_;
+    }
+
+    struct Snapshot
+    {
+        const char* name;
+        int windowId;
+        DWORD threadId;
+        LONGLONG startUs;
+        LONGLONG endUs;
+    };
+
+    // Copy the valid events out first so that the file is written without racing with the writers.
+    std::vector<Snapshot> snapshots;
+    const UINT64 endIndex = nextIndex_.load(std::memory_order_acquire);
+    const UINT64 beginIndex = endIndex > kEventCount ? endIndex - kEventCount : 0;
+    snapshots.reserve(static_cast<size_t>(endIndex - beginIndex));
+    for (UINT64 index = beginIndex; index < endIndex; ++index)
+    {
+        const auto& event = events_[index & (kEventCount - 1)];
+        const UINT64 expected = index * 2 + 2;
+        if (event.sequence.load(std::memory_order_acquire) != expected) continue;
+
+        const Snapshot snapshot = { event.name, event.windowId, event.threadId, event.startUs, event.endUs };
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (event.sequence.load(std::memory_order_relaxed) != expected) continue;
+
+        snapshots.push_back(snapshot);
+    }
+
+    std::ofstream fs(path);
+    if (!fs.good())
+    {
+        Debug::Error(__FUNCTION__, " => Failed to open ", path);
+        return false;
+    }
+
+    const auto pid = Platform::GetCurrentProcessId();
+    fs << "{\"traceEvents\":[";
+
+    bool isFirst = true;
+    const auto separate = [&]
+    {
+        if (!isFirst) fs << ",";
+        fs << "\n";
+        isFirst = false;
+    };
+
+    for (const auto& pair : threadNames)
+    {
+        separate();
+        fs << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << pair.first
+           << ",\"args\":{\"name\":\"" << EscapeJson(Platform::ToUtf8(pair.second)) << "\"}}";
+    }
+
+    for (const auto& snapshot : snapshots)
+    {
+        separate();
+        fs << "{\"name\":\"" << snapshot.name << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << snapshot.threadId
+           << ",\"ts\":" << snapshot.startUs << ",\"dur\":" << (snapshot.endUs - snapshot.startUs);
+        if (snapshot.windowId >= 0)
+        {
+            fs << ",\"args\":{\"windowId\":" << snapshot.windowId << "}";
+        }
+        fs << "}";
+    }
+
+    fs << "\n]}\n";
+
+    return fs.good();
+}
+
+
+// ---
+
+
+ScopedTraceEvent::ScopedTraceEvent(const char* name, int windowId)
+    : name_(name)
+    , windowId_(windowId)
+{
+    if (TraceRecorder::IsRecording())
+    {
+        startUs_ = TraceRecorder::GetTime();
+    }
+}
+
+
+ScopedTraceEvent::~ScopedTraceEvent()
+{
+    if (startUs_ < 0) return;
+    TraceRecorder::Record(name_, windowId_, startUs_, TraceRecorder::GetTime());
+}
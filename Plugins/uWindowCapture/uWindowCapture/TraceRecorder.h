@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Platform.h"
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+
+// Records timed scopes of the pipeline threads into a fixed-size ring and dumps them
+// as Chrome trace event JSON (loadable in chrome://tracing and Perfetto).
+// Each scope is recorded as one complete event at its end, so that wrapping the ring
+// never leaves unmatched begin / end events behind.
+class TraceRecorder
+{
+public:
+    static constexpr UINT kEventCountBits = 16;
+    static constexpr UINT kEventCount = 1 << kEventCountBits;
+
+    static void Start();
+    static void Stop();
+    static bool IsRecording() { return isRecording_.load(std::memory_order_relaxed); }
+    static bool Dump(const std::string& path);
+
+    static void SetThreadName(const std::wstring& name);
+    static void Record(const char* name, int windowId, LONGLONG startUs, LONGLONG endUs);
+    static LONGLONG GetTime();
+
+private:
+    struct Event
+    {
+        std::atomic<UINT64> sequence;
+        const char* name;
+        int windowId;
+        DWORD threadId;
+        LONGLONG startUs;
+        LONGLONG endUs;
+    };
+
+    static std::atomic<bool> isRecording_;
+    static std::atomic<UINT64> nextIndex_;
+    static Event* events_;
+    static std::unordered_map<DWORD, std::wstring> threadNames_;
+    static std::mutex mutex_;
+};
+
+
+// The name must be a string literal since only the pointer is recorded.
+class ScopedTraceEvent
+{
+public:
+    explicit ScopedTraceEvent(const char* name, int windowId = -1);
+    ~ScopedTraceEvent();
+
+private:
+    const char* const name_;
+    const int windowId_;
+    LONGLONG startUs_ = -1;
+};
+
+
+#define UWC_TRACE_SCOPE(Name, WindowId) \
+    ScopedTraceEvent _traceEvent_##__COUNTER__(Name, WindowId);
@@ -129,6 +129,8 @@ void UploadManager::StartUploadThread()
 {
     threadLoop_.Start([this] 
     { 
+        bool hasWorked = false;
+
         // Check window upload
         const int windowId = windowUploadQueue_.Dequeue();
         if (windowId >= 0)
@@ -136,6 +138,7 @@ void UploadManager::StartUploadThread()
             if (auto window = WindowManager::Get().GetWindow(windowId))
             {
                 window->Upload();
+                hasWorked = true;
             }
         }
 
@@ -146,14 +149,17 @@ void UploadManager::StartUploadThread()
             if (auto window = WindowManager::Get().GetWindow(iconId))
             {
                 window->UploadIcon();
+                hasWorked = true;
             }
         }
 
         // Check cursor upload
         if (auto& cursor = WindowManager::Get().GetCursor())
         {
-            cursor->Upload();
+            hasWorked |= cursor->Upload();
         }
+
+        return hasWorked;
     }, kLoopMinTime);
 }
 
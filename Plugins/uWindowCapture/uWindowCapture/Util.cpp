@@ -218,23 +218,3 @@ bool GetWindowClassName(HWND hWnd, std::string& outClassName)
 
     return false;
 }
-
-
-ScopedTimer::ScopedTimer(TimerFuncType&& func)
-    : func_(func)
-    , start_(std::chrono::high_resolution_clock::now())
-{
-}
-
-
-ScopedTimer::~ScopedTimer()
-{
-    func_(GetElapsedTime());
-}
-
-
-ScopedTimer::microseconds ScopedTimer::GetElapsedTime() const
-{
-    const auto end = std::chrono::high_resolution_clock::now();
-    return std::chrono::duration_cast<microseconds>(end - start_);
-}
@@ -0,0 +1,114 @@
+#include "Win32WindowBackend.h"
+#include "Util.h"
+#include "Debug.h"
+
+
+
+void Win32WindowBackend::EnumerateWindows(std::vector<WindowData>& windows)
+{
+    zOrderCounter_.Reset();
+    windows_ = &windows;
+
+    static const auto _EnumWindowsCallback = [](HWND hWnd, LPARAM lParam) -> BOOL
+    {
+        auto thiz = reinterpret_cast<Win32WindowBackend*>(lParam);
+
+        // EnumWindows() gives windows from the top, so the z-order is the number of visible windows given so far.
+        // If the order has changed during the enumeration, walk the z-order chain of the window instead.
+        const bool isVisible = ::IsWindow(hWnd) && ::IsWindowVisible(hWnd);
+        auto& counter = thiz->zOrderCounter_;
+        const auto zOrder = counter.IsNextOf(::GetWindow(hWnd, GW_HWNDPREV)) ?
+            counter.Add(hWnd, isVisible) :
+            counter.Add(hWnd, isVisible, ::GetWindowZOrder(hWnd));
+
+        if (!isVisible || ::IsHungAppWindow(hWnd))
+        {
+            return TRUE;
+        }
+
+        WindowData data;
+        data.hWnd = hWnd;
+        data.hOwner = ::GetWindow(hWnd, GW_OWNER);
+        ::GetWindowRect(hWnd, &data.windowRect);
+        ::GetClientRect(hWnd, &data.clientRect);
+        data.zOrder = zOrder;
+        data.hMonitor = ::MonitorFromWindow(hWnd, MONITOR_DEFAULTTOPRIMARY);
+        data.isDesktop = false;
+
+        thiz->windows_->push_back(data);
+
+        return TRUE;
+    };
+
+    using EnumWindowsCallbackType = BOOL(CALLBACK *)(HWND, LPARAM);
+    static const auto EnumWindowsCallback = static_cast<EnumWindowsCallbackType>(_EnumWindowsCallback);
+    if (!::EnumWindows(EnumWindowsCallback, reinterpret_cast<LPARAM>(this)))
+    {
+        OutputApiError(__FUNCTION__, "EnumWindows");
+    }
+
+    static const auto _EnumDisplayMonitorsCallback = [](HMONITOR hMonitor, HDC hDc, LPRECT lpRect, LPARAM lParam) -> BOOL
+    {
+        const auto hWnd = GetDesktopWindow();;
+
+        WindowData data;
+        data.hWnd = hWnd;
+        data.hOwner = NULL;
+        data.windowRect = *lpRect;
+        data.clientRect = *lpRect;
+        data.zOrder = 0;
+        data.hMonitor = hMonitor;
+        data.isDesktop = true;
+
+        auto thiz = reinterpret_cast<Win32WindowBackend*>(lParam);
+        thiz->windows_->push_back(data);
+
+        return TRUE;
+    };
+
+    using EnumDisplayMonitorsCallbackType = BOOL(CALLBACK *)(HMONITOR, HDC, LPRECT, LPARAM);
+    static const auto EnumDisplayMonitorsCallback = static_cast<EnumDisplayMonitorsCallbackType>(_EnumDisplayMonitorsCallback);
+    if (!::EnumDisplayMonitors(NULL, NULL, EnumDisplayMonitorsCallback, reinterpret_cast<LPARAM>(this)))
+    {
+        OutputApiError(__FUNCTION__, "EnumDisplayMonitors");
+    }
+
+    windows_ = nullptr;
+}
+
+
+bool Win32WindowBackend::GetWindowAttributes(HWND hWnd, WindowAttributes& attributes) const
+{
+    attributes.threadId = ::GetWindowThreadProcessId(hWnd, &attributes.processId);
+    if (attributes.threadId == 0) return false;
+
+    attributes.hParent = ::GetParent(hWnd);
+    attributes.hInstance = reinterpret_cast<HINSTANCE>(::GetWindowLongPtr(hWnd, GWLP_HINSTANCE));
+    attributes.isAltTabWindow = IsAltTabWindow(hWnd);
+    GetWindowClassName(hWnd, attributes.className);
+
+    return true;
+}
+
+
+bool Win32WindowBackend::GetWindowTitle(HWND hWnd, std::wstring& title) const
+{
+    constexpr UINT timeout = 100 /* milliseconds */;
+    return ::GetWindowTitle(hWnd, title, timeout);
+}
+
+
+bool Win32WindowBackend::GetWindowState(HWND hWnd, WindowState state) const
+{
+    switch (state)
+    {
+        case WindowState::Enabled: return ::IsWindowEnabled(hWnd) != FALSE;
+        case WindowState::Unicode: return ::IsWindowUnicode(hWnd) != FALSE;
+        case WindowState::Zoomed: return ::IsZoomed(hWnd) != FALSE;
+        case WindowState::Iconic: return ::IsIconic(hWnd) != FALSE;
+        case WindowState::Hung: return ::IsHungAppWindow(hWnd) != FALSE;
+        case WindowState::Touchable: return ::IsTouchWindow(hWnd, NULL) != FALSE;
+        case WindowState::Cloaked: return IsCloakedWindow(hWnd);
+    }
+    return false;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Windows.h>
+#include <vector>
+
+#include "WindowBackend.h"
+#include "WindowZOrderCounter.h"
+
+
+class Win32WindowBackend : public WindowBackend
+{
+public:
+    void EnumerateWindows(std::vector<WindowData>& windows) override;
+    bool IsWindow(HWND hWnd) const override { return ::IsWindow(hWnd) != FALSE; }
+    bool IsWindowVisible(HWND hWnd) const override { return ::IsWindowVisible(hWnd) != FALSE; }
+    HWND GetWindowFromPoint(POINT point) const override { return ::WindowFromPoint(point); }
+    HWND GetParentWindow(HWND hWnd) const override { return ::GetAncestor(hWnd, GA_PARENT); }
+    bool GetWindowAttributes(HWND hWnd, WindowAttributes& attributes) const override;
+    bool GetWindowTitle(HWND hWnd, std::wstring& title) const override;
+    bool GetWindowState(HWND hWnd, WindowState state) const override;
+    bool HasIcons() const override { return true; }
+    bool HasFrames() const override { return false; }
+    bool CaptureFrame(HWND, Buffer<BYTE>&, UINT&, UINT&) override { return false; }
+
+private:
+    WindowZOrderCounter zOrderCounter_;
+    std::vector<WindowData>* windows_ = nullptr;
+};
\ No newline at end of file
@@ -2,15 +2,35 @@
 #include "Window.h"
 #include "WindowTexture.h"
 #include "IconTexture.h"
+#include "CaptureGroup.h"
 #include "WindowManager.h"
+#include "TraceRecorder.h"
 #include "Debug.h"
 #include "Util.h"
 
 
 
+namespace
+{
+    constexpr ULONGLONG kMinEmptyTitleRetryInterval = 100;
+    constexpr ULONGLONG kMaxEmptyTitleRetryInterval = 10000;
+
+
+    BOOL GetWindowState(HWND hWnd, WindowState state)
+    {
+        const auto& backend = WindowManager::GetWindowBackend();
+        return backend && backend->GetWindowState(hWnd, state);
+    }
+}
+
+
+// ---
+
+
 Window::Window(int id, const Data1 &data)
     : id_(id)
     , data1_(data)
+    , captureMode_(CaptureMode::Auto)
 {
 }
 
@@ -20,10 +40,118 @@ Window::~Window()
 }
 
 
-void Window::InitTexture()
+std::shared_ptr<WindowTexture> Window::GetWindowTextureInstance() const
 {
-    windowTexture_ = std::make_shared<WindowTexture>(this);
-    iconTexture_ = std::make_shared<IconTexture>(this);
+    return std::atomic_load(&windowTexture_);
+}
+
+
+std::shared_ptr<WindowTexture> Window::GetOrCreateWindowTextureInstance()
+{
+    if (auto texture = GetWindowTextureInstance()) return texture;
+
+    std::lock_guard<std::mutex> lock(textureMutex_);
+
+    if (auto texture = GetWindowTextureInstance()) return texture;
+
+    UWC_SCOPE_TIMER(CreateWindowTexture)
+
+    auto texture = std::make_shared<WindowTexture>(this);
+    texture->SetUnityTexturePtr(unityWindowTexture_);
+    texture->SetCaptureMode(captureMode_);
+    texture->SetCursorDraw(drawCursor_);
+    std::atomic_store(&windowTexture_, texture);
+
+    return texture;
+}
+
+
+std::shared_ptr<IconTexture> Window::GetIconTextureInstance() const
+{
+    return std::atomic_load(&iconTexture_);
+}
+
+
+std::shared_ptr<IconTexture> Window::GetOrCreateIconTextureInstance()
+{
+    if (auto texture = GetIconTextureInstance()) return texture;
+
+    // The icon source depends on whether the window belongs to a store app.
+    ResolveUWP();
+
+    std::lock_guard<std::mutex> lock(textureMutex_);
+
+    if (auto texture = GetIconTextureInstance()) return texture;
+
+    UWC_SCOPE_TIMER(CreateIconTexture)
+
+    auto texture = std::make_shared<IconTexture>(this);
+    std::atomic_store(&iconTexture_, texture);
+
+    return texture;
+}
+
+
+bool Window::HasWindowTexture() const
+{
+    return GetWindowTextureInstance() != nullptr;
+}
+
+
+void Window::RenewCaptureLease()
+{
+    lastCaptureRequestTime_ = ::GetTickCount64();
+}
+
+
+UINT64 Window::ReleaseCaptureResourcesIfLeaseExpired(ULONGLONG leaseTimeMs)
+{
+    if (leaseTimeMs == 0 || !hasCaptureResources_) return 0;
+
+    const ULONGLONG lastCaptureRequestTime = lastCaptureRequestTime_;
+    if (::GetTickCount64() - lastCaptureRequestTime < leaseTimeMs) return 0;
+
+    const auto texture = GetWindowTextureInstance();
+    if (!texture)
+    {
+        hasCaptureResources_ = false;
+        return 0;
+    }
+
+    UWC_SCOPE_TIMER(ReleaseCaptureResources)
+
+    const auto releasedBytes = texture->ReleaseResources();
+    if (releasedBytes > 0)
+    {
+        hasCaptureResources_ = false;
+        hasNewWindowTextureCaptured_ = false;
+        hasNewWindowTextureUploaded_ = false;
+    }
+
+    return releasedBytes;
+}
+
+
+bool Window::ReleaseWindowTextureIfIdle(ULONGLONG idleTimeMs)
+{
+    if (idleTimeMs == 0 || !HasWindowTexture()) return false;
+
+    const ULONGLONG lastCaptureRequestTime = lastCaptureRequestTime_;
+    if (::GetTickCount64() - lastCaptureRequestTime < idleTimeMs) return false;
+
+    std::lock_guard<std::mutex> lock(textureMutex_);
+
+    // Threads which have already got the texture keep it until they finish using it.
+    if (const auto texture = GetWindowTextureInstance())
+    {
+        unityWindowTexture_ = texture->GetUnityTexturePtr();
+        std::atomic_store(&windowTexture_, std::shared_ptr<WindowTexture>());
+    }
+    hasCaptureResources_ = false;
+    hasNewWindowTextureCaptured_ = false;
+    hasNewWindowTextureUploaded_ = false;
+
+    return true;
 }
 
 
@@ -113,49 +241,57 @@ bool Window::IsDesktop() const
 
 BOOL Window::IsWindow() const
 {
+    if (const auto& backend = WindowManager::GetWindowBackend())
+    {
+        return backend->IsWindow(GetWindowHandle());
+    }
     return ::IsWindow(GetWindowHandle());
 }
 
 
 BOOL Window::IsVisible() const
 {
+    if (const auto& backend = WindowManager::GetWindowBackend())
+    {
+        return backend->IsWindowVisible(GetWindowHandle());
+    }
     return ::IsWindowVisible(GetWindowHandle());
 }
 
 
 BOOL Window::IsEnabled() const
 {
-    return ::IsWindowEnabled(GetWindowHandle());
+    return GetWindowState(GetWindowHandle(), WindowState::Enabled);
 }
 
 
 BOOL Window::IsUnicode() const
 {
-    return ::IsWindowUnicode(GetWindowHandle());
+    return GetWindowState(GetWindowHandle(), WindowState::Unicode);
 }
 
 
 BOOL Window::IsZoomed() const
 {
-    return ::IsZoomed(GetWindowHandle());
+    return GetWindowState(GetWindowHandle(), WindowState::Zoomed);
 }
 
 
 BOOL Window::IsIconic() const
 {
-    return ::IsIconic(GetWindowHandle());
+    return GetWindowState(GetWindowHandle(), WindowState::Iconic);
 }
 
 
 BOOL Window::IsHungUp() const
 {
-    return ::IsHungAppWindow(GetWindowHandle());
+    return GetWindowState(GetWindowHandle(), WindowState::Hung);
 }
 
 
 BOOL Window::IsTouchable() const
 {
-    return ::IsTouchWindow(GetWindowHandle(), NULL);
+    return GetWindowState(GetWindowHandle(), WindowState::Touchable);
 }
 
 
@@ -179,7 +315,40 @@ BOOL Window::IsBackground() const
 
 bool Window::IsWindowsGraphicsCaptureAvailable() const
 {
-    return windowTexture_ && windowTexture_->IsWindowsGraphicsCaptureAvailable();
+    if (WindowManager::IsHeadless()) return false;
+
+    if (const auto texture = GetWindowTextureInstance())
+    {
+        return texture->IsWindowsGraphicsCaptureAvailable();
+    }
+    return WindowsGraphicsCapture::IsSupported();
+}
+
+
+float Window::GetVisibleFraction() const
+{
+    return visibleFraction_;
+}
+
+
+std::vector<RECT> Window::GetVisibleRects() const
+{
+    std::lock_guard<std::mutex> lock(visibilityMutex_);
+    return visibleRects_;
+}
+
+
+bool Window::IsOccluded() const
+{
+    return !IsDesktop() && visibleFraction_ <= 0.f;
+}
+
+
+void Window::SetVisibility(float fraction, std::vector<RECT>&& rects)
+{
+    std::lock_guard<std::mutex> lock(visibilityMutex_);
+    visibleRects_ = std::move(rects);
+    visibleFraction_ = fraction;
 }
 
 
@@ -225,51 +394,76 @@ UINT Window::GetZOrder() const
 }
 
 
-BYTE* Window::GetBuffer() const
+BYTE* Window::GetBuffer()
 {
-    return windowTexture_->GetBuffer();
+    const auto texture = GetWindowTextureInstance();
+    if (!texture) return nullptr;
+
+    std::lock_guard<std::mutex> lock(bufferForGetBufferMutex_);
+
+    const bool hasRead = texture->ReadBuffer([&](const BYTE* pixels, UINT width, UINT height)
+    {
+        const UINT size = width * height * 4;
+        bufferForGetBuffer_.ExpandIfNeeded(size);
+        memcpy(bufferForGetBuffer_.Get(), pixels, size);
+    });
+
+    return hasRead ? bufferForGetBuffer_.Get() : nullptr;
 }
 
 
 UINT Window::GetTextureWidth() const
 {
-    return windowTexture_->GetWidth();
+    const auto texture = GetWindowTextureInstance();
+    return texture ? texture->GetWidth() : 0;
 }
 
 
 UINT Window::GetTextureHeight() const
 {
-    return windowTexture_->GetHeight();
+    const auto texture = GetWindowTextureInstance();
+    return texture ? texture->GetHeight() : 0;
 }
 
 
 UINT Window::GetTextureOffsetX() const
 {
-    return windowTexture_->GetOffsetX();
+    const auto texture = GetWindowTextureInstance();
+    return texture ? texture->GetOffsetX() : 0;
 }
 
 
 UINT Window::GetTextureOffsetY() const
 {
-    return windowTexture_->GetOffsetY();
+    const auto texture = GetWindowTextureInstance();
+    return texture ? texture->GetOffsetY() : 0;
+}
+
+
+UINT Window::GetIconWidth()
+{
+    return GetOrCreateIconTextureInstance()->GetWidth();
 }
 
 
-UINT Window::GetIconWidth() const
+UINT Window::GetIconHeight()
 {
-    return iconTexture_->GetWidth();
+    return GetOrCreateIconTextureInstance()->GetHeight();
 }
 
 
-UINT Window::GetIconHeight() const
+std::shared_ptr<const std::wstring> Window::GetTitle() const
 {
-    return iconTexture_->GetHeight();
+    return std::atomic_load(&title_);
 }
 
 
-const std::wstring& Window::GetTitle() const
+const WCHAR* Window::GetTitleForHost()
 {
-    return data2_.title;
+    auto title = GetTitle();
+    const auto* str = title->c_str();
+    std::atomic_store(&titleForHost_, std::move(title));
+    return str;
 }
 
 
@@ -281,73 +475,103 @@ const std::string& Window::GetClass() const
 
 void Window::SetWindowTexture(ID3D11Texture2D* ptr)
 {
-    windowTexture_->SetUnityTexturePtr(ptr);
+    unityWindowTexture_ = ptr;
+    RenewCaptureLease();
+    GetOrCreateWindowTextureInstance()->SetUnityTexturePtr(ptr);
 }
 
 
 ID3D11Texture2D* Window::GetWindowTexture() const
 {
-    return windowTexture_->GetUnityTexturePtr();
+    const auto texture = GetWindowTextureInstance();
+    return texture ? texture->GetUnityTexturePtr() : unityWindowTexture_.load();
 }
 
 
 void Window::SetIconTexture(ID3D11Texture2D* ptr)
 {
-    iconTexture_->SetUnityTexturePtr(ptr);
+    GetOrCreateIconTextureInstance()->SetUnityTexturePtr(ptr);
 }
 
 
 ID3D11Texture2D* Window::GetIconTexture() const
 {
-    return iconTexture_->GetUnityTexturePtr();
+    const auto texture = GetIconTextureInstance();
+    return texture ? texture->GetUnityTexturePtr() : nullptr;
 }
 
 
 void Window::SetCaptureMode(CaptureMode mode)
 {
-    windowTexture_->SetCaptureMode(mode);
+    captureMode_ = mode;
+    if (const auto texture = GetWindowTextureInstance())
+    {
+        texture->SetCaptureMode(mode);
+    }
 }
 
 
 void Window::SetCursorDraw(bool draw)
 {
-    windowTexture_->SetCursorDraw(draw);
+    drawCursor_ = draw;
+    if (const auto texture = GetWindowTextureInstance())
+    {
+        texture->SetCursorDraw(draw);
+    }
 }
 
 
 bool Window::GetCursorDraw() const
 {
-    return windowTexture_->GetCursorDraw();
+    return drawCursor_;
 }
 
 
 UINT Window::GetPixel(int x, int y) const
 {
-    return windowTexture_->GetPixel(x, y);
+    const auto texture = GetWindowTextureInstance();
+    return texture ? texture->GetPixel(x, y) : 0;
 }
 
 
 bool Window::GetPixels(BYTE* output, int x, int y, int width, int height) const
 {
-    return windowTexture_->GetPixels(output, x, y, width, height);
+    const auto texture = GetWindowTextureInstance();
+    return texture && texture->GetPixels(output, x, y, width, height);
 }
 
 
-CaptureMode Window::GetCaptureMode() const
+bool Window::ReadBuffer(const std::function<void(const BYTE*, UINT, UINT)>& reader) const
+{
+    const auto texture = GetWindowTextureInstance();
+    return texture && texture->ReadBuffer(reader);
+}
+
+
+UINT64 Window::GetBufferVersion() const
+{
+    const auto texture = GetWindowTextureInstance();
+    return texture ? texture->GetBufferVersion() : 0;
+}
+
+
+LatencyStats Window::GetLatencyStats(PipelineStage stage) const
 {
-    return windowTexture_->GetCaptureMode();
+    const auto texture = GetWindowTextureInstance();
+    return texture ? texture->GetLatencyStats(stage) : LatencyStats {};
 }
 
 
-bool Window::IsJustAdded() const
+FrameLatencyStats Window::GetFrameLatencyStats() const
 {
-    return frameCount_ == 0;
+    const auto texture = GetWindowTextureInstance();
+    return texture ? texture->GetFrameLatencyStats() : FrameLatencyStats {};
 }
 
 
-void Window::UpdateFrameCount()
+CaptureMode Window::GetCaptureMode() const
 {
-    ++frameCount_;
+    return captureMode_;
 }
 
 
@@ -359,19 +583,22 @@ void Window::RequestUpdateTitle()
 
 void Window::UpdateTitle()
 {
+    std::wstring title;
+
     if (!IsDesktop())
     {
-        if (windowTexture_->IsWindowsGraphicsCaptureAvailable())
+        // Use the name from Windows Graphics Capture only when the window has been captured.
+        const auto texture = GetWindowTextureInstance();
+        if (texture && texture->IsWindowsGraphicsCaptureAvailable())
         {
-            if (const auto wgc = windowTexture_->GetWindowsGraphicsCapture())
+            if (const auto wgc = texture->GetWindowsGraphicsCapture())
             {
-                data2_.title = wgc->GetDisplayName();
+                title = wgc->GetDisplayName();
             }
         }
-        else
+        else if (const auto& backend = WindowManager::GetWindowBackend())
         {
-            constexpr UINT timeout = 100 /* milliseconds */;
-            GetWindowTitle(data1_.hWnd, data2_.title, timeout);
+            backend->GetWindowTitle(data1_.hWnd, title);
         }
     }
     else
@@ -383,9 +610,79 @@ void Window::UpdateTitle()
             WCHAR buf[_countof(monitor.szDevice)];
             size_t len;
             mbstowcs_s(&len, buf, _countof(monitor.szDevice), monitor.szDevice, _TRUNCATE);
-            data2_.title = buf;
+            title = buf;
         }
     }
+
+    if (title.empty())
+    {
+        const UINT count = min(++emptyTitleCount_, 16u);
+        const auto interval = min(kMinEmptyTitleRetryInterval << (count - 1), kMaxEmptyTitleRetryInterval);
+        nextEmptyTitleUpdateTime_ = ::GetTickCount64() + interval;
+    }
+    else
+    {
+        emptyTitleCount_ = 0;
+    }
+
+    std::atomic_store(&title_, std::make_shared<const std::wstring>(std::move(title)));
+}
+
+
+bool Window::ShouldUpdateTitle() const
+{
+    if (hasTitleUpdateRequested_) return true;
+    return GetTitle()->empty() && ::GetTickCount64() >= nextEmptyTitleUpdateTime_;
+}
+
+
+void Window::UpdateMetadata()
+{
+    // Run this scope in the thread loop managed by MetadataManager.
+
+    ResolveUWP();
+
+    if (!IsMetadataResolved(kMetadataTitle) || ShouldUpdateTitle())
+    {
+        hasTitleUpdateRequested_ = false;
+        UpdateTitle();
+        resolvedMetadata_ |= kMetadataTitle;
+    }
+}
+
+
+void Window::ResolveUWP()
+{
+    if (IsMetadataResolved(kMetadataUWP)) return;
+
+    std::lock_guard<std::mutex> lock(resolveUWPMutex_);
+    if (IsMetadataResolved(kMetadataUWP)) return;
+
+    if (!IsDesktop() && !IsApplicationFrameWindow())
+    {
+        if (const auto& metadataManager = WindowManager::GetMetadataManager())
+        {
+            data2_.isUWP = metadataManager->IsUWP(GetProcessId());
+        }
+        else
+        {
+            data2_.isUWP = ::IsUWP(GetProcessId());
+        }
+    }
+
+    resolvedMetadata_ |= kMetadataUWP;
+}
+
+
+UINT Window::GetResolvedMetadata() const
+{
+    return resolvedMetadata_;
+}
+
+
+bool Window::IsMetadataResolved(UINT metadata) const
+{
+    return (resolvedMetadata_ & metadata) == metadata;
 }
 
 
@@ -393,7 +690,7 @@ void Window::UpdateIsBackground()
 {
     if (IsApplicationFrameWindow())
     {
-        data2_.isBackground = IsCloakedWindow(GetWindowHandle());
+        data2_.isBackground = GetWindowState(GetWindowHandle(), WindowState::Cloaked);
     }
     else
     {
@@ -402,44 +699,161 @@ void Window::UpdateIsBackground()
 }
 
 
-void Window::Capture()
+void Window::Capture(const std::atomic<bool>& isAlive)
 {
-    // Run this scope in the thread loop managed by CaptureManager.
+    // Run this scope in the thread loop managed by CaptureManager or in one of its capture workers.
+
+    // Do not overwrite the frame held back for a capture group.
+    if (IsCaptureGroupPending()) return;
+
+    CaptureInternal(isAlive, nullptr);
+}
+
 
-    if (hasNewWindowTextureCaptured_)
+void Window::CaptureInGroup(const std::shared_ptr<CaptureGroup>& group, const std::atomic<bool>& isAlive)
+{
+    // Run this scope in a capture worker of CaptureManager.
+
+    // A window can belong to one pending group at a time, so the older one stops waiting for it.
+    if (const auto previousGroup = std::atomic_exchange(&captureGroup_, group))
     {
-        // If it is called before Upload(), skip this frame.
-        return;
+        previousGroup->FinishMember(id_);
+    }
+
+    if (!CaptureInternal(isAlive, group.get()))
+    {
+        group->FinishMember(id_);
+    }
+}
+
+
+bool Window::CanCaptureBlock() const
+{
+    const auto& backend = WindowManager::GetWindowBackend();
+    if (backend && backend->HasFrames()) return false;
+
+    // The mode is not known until the texture is created, so the first capture is guarded.
+    const auto texture = GetWindowTextureInstance();
+    return !texture || texture->CanCaptureBlock();
+}
+
+
+bool Window::CaptureInternal(const std::atomic<bool>& isAlive, const CaptureGroup* group)
+{
+    if (!isAlive) return false;
+
+    RenewCaptureLease();
+
+    // If it is called before Upload(), skip this frame.
+    // A group captures anyway so that the frame waiting for the upload is replaced by one taken for the group.
+    if (hasNewWindowTextureCaptured_ && !group)
+    {
+        return false;
     }
 
     if (!IsWindow() || !IsVisible())
     {
-        return;
+        return false;
     }
 
     UWC_SCOPE_TIMER(WindowCapture)
+    UWC_TRACE_SCOPE("CaptureWindow", id_)
+
+    hasCaptureResources_ = true;
 
-    if (windowTexture_->Capture())
+    if (!GetOrCreateWindowTextureInstance()->Capture())
     {
-        hasNewWindowTextureCaptured_ = true;
+        return false;
+    }
 
-        if (auto& uploader = WindowManager::GetUploadManager())
-        {
-            uploader->RequestUploadWindow(id_);
-        }
+    // A stuck capture may return after the managers have been destroyed.
+    if (!isAlive) return false;
+
+    const UINT groupSequence = group ? group->GetSequence() : 0;
+    capturedFrameGroupSequence_ = groupSequence;
+    hasNewWindowTextureCaptured_ = true;
+
+    if (auto& uploader = WindowManager::GetUploadManager())
+    {
+        uploader->RequestUploadWindow(id_);
+    }
+    else if (WindowManager::IsHeadless())
+    {
+        // Nothing is uploaded or rendered, so the frame is ready in the buffer here.
+        FinishCapture(groupSequence);
+        MessageManager::Get().Add({ MessageType::WindowCaptured, id_, GetWindowHandle() });
     }
+
+    return true;
 }
 
 
 void Window::Upload()
 {
     // Run this scope in the thread loop managed by UploadManager.
-    if (windowTexture_->Upload())
+    UWC_TRACE_SCOPE("UploadWindow", id_)
+
+    // Read before uploading: the buffer holds this frame or a newer one, and only a group can capture a newer one
+    // while the group is pending, in which case another upload follows.
+    const UINT groupSequence = capturedFrameGroupSequence_;
+
+    const auto texture = GetWindowTextureInstance();
+    if (texture && texture->Upload())
     {
+        uploadedFrameGroupSequence_ = groupSequence;
         hasNewWindowTextureUploaded_ = true;
     }
 
+    FinishCapture(groupSequence);
+}
+
+
+void Window::FinishCapture(UINT groupSequence)
+{
     hasNewWindowTextureCaptured_ = false;
+
+    // A frame taken before the group does not finish the member.
+    const auto group = std::atomic_load(&captureGroup_);
+    if (group && group->GetSequence() == groupSequence)
+    {
+        group->FinishMember(id_);
+    }
+}
+
+
+void Window::ReleaseCaptureGroup()
+{
+    // Run this scope in headless mode instead of Render() after the group has been released.
+    // The frame captured for the group has been kept in the buffer since nothing overwrites it while the group is pending.
+    auto group = std::atomic_load(&captureGroup_);
+    if (!group || !group->IsReleased()) return;
+
+    if (capturedFrameGroupSequence_ == group->GetSequence())
+    {
+        captureGroupSequence_ = group->GetSequence();
+        captureGroupTimestamp_ = group->GetTimestamp();
+    }
+
+    std::atomic_compare_exchange_strong(&captureGroup_, &group, std::shared_ptr<CaptureGroup>());
+}
+
+
+bool Window::IsCaptureGroupPending() const
+{
+    const auto group = std::atomic_load(&captureGroup_);
+    return group && !group->IsReleased();
+}
+
+
+UINT Window::GetCaptureGroupSequence() const
+{
+    return captureGroupSequence_;
+}
+
+
+ULONGLONG Window::GetCaptureGroupTimestamp() const
+{
+    return captureGroupTimestamp_;
 }
 
 
@@ -450,7 +864,15 @@ void Window::CaptureIcon()
         return;
     }
 
-    if (!iconTexture_->CaptureOnce())
+    const auto& backend = WindowManager::GetWindowBackend();
+    if (!backend || !backend->HasIcons())
+    {
+        return;
+    }
+
+    UWC_TRACE_SCOPE("CaptureIcon", id_)
+
+    if (!GetOrCreateIconTextureInstance()->CaptureOnce())
     {
         return;
     }
@@ -459,12 +881,19 @@ void Window::CaptureIcon()
     {
         uploader->RequestUploadIcon(id_);
     }
+    else if (WindowManager::IsHeadless())
+    {
+        MessageManager::Get().Add({ MessageType::IconCaptured, id_, GetWindowHandle() });
+    }
 }
 
 
 void Window::UploadIcon()
 {
-    if (iconTexture_->UploadOnce())
+    UWC_TRACE_SCOPE("UploadIcon", id_)
+
+    const auto texture = GetIconTextureInstance();
+    if (texture && texture->UploadOnce())
     {
         hasNewIconTextureUploaded_ = true;
     }
@@ -473,7 +902,10 @@ void Window::UploadIcon()
 
 void Window::RenderIcon()
 {
-    iconTexture_->RenderOnce();
+    if (const auto texture = GetIconTextureInstance())
+    {
+        texture->RenderOnce();
+    }
 }
 
 
@@ -481,16 +913,38 @@ void Window::Render()
 {
     // Run this scope in the unity rendering thread.
 
-    if (hasNewWindowTextureUploaded_)
+    auto group = std::atomic_load(&captureGroup_);
+    const bool isHeldByGroup = group && !group->IsReleased();
+
+    if (hasNewWindowTextureUploaded_ && !isHeldByGroup)
     {
+        UWC_TRACE_SCOPE("RenderWindow", id_)
+
         hasNewWindowTextureUploaded_ = false;
-        windowTexture_->Render();
+        if (const auto texture = GetWindowTextureInstance())
+        {
+            texture->Render();
+        }
         hasNewWindowTextureCaptured_ = false;
+
+        if (group && uploadedFrameGroupSequence_ == group->GetSequence())
+        {
+            captureGroupSequence_ = group->GetSequence();
+            captureGroupTimestamp_ = group->GetTimestamp();
+        }
+    }
+
+    if (group && group->IsReleased())
+    {
+        std::atomic_compare_exchange_strong(&captureGroup_, &group, std::shared_ptr<CaptureGroup>());
     }
 
     if (hasNewIconTextureUploaded_)
     {
         hasNewIconTextureUploaded_ = false;
-        iconTexture_->RenderOnce();
+        if (const auto texture = GetIconTextureInstance())
+        {
+            texture->RenderOnce();
+        }
     }
 }
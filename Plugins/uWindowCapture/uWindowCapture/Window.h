@@ -3,28 +3,33 @@
 #include <Windows.h>
 #include <d3d11.h>
 #include <string>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <atomic>
 
 #include "Buffer.h"
+#include "WindowData.h"
+#include "LatencyHistogram.h"
+#include "FrameLatencyTracker.h"
 
 
 enum class CaptureMode;
+class CaptureGroup;
 
 
 class Window
 {
 friend class WindowManager;
+friend class MetadataManager;
 public:
-    struct Data1
-    {
-        BOOL isDesktop;
-        HWND hWnd;
-        HMONITOR hMonitor;
-        HWND hOwner;
-        RECT windowRect;
-        RECT clientRect;
-        UINT zOrder;
-    };
+    // Fields resolved asynchronously after the window is added.
+    static constexpr UINT kMetadataTitle = 1 << 0;
+    static constexpr UINT kMetadataUWP = 1 << 1;
+    static constexpr UINT kMetadataAll = kMetadataTitle | kMetadataUWP;
+
+    using Data1 = WindowData;
 
     struct Data2
     {
@@ -32,7 +37,6 @@ public:
         HINSTANCE hInstance;
         DWORD processId;
         DWORD threadId;
-        std::wstring title;
         std::string className;
         BOOL isAltTabWindow;
         BOOL isApplicationFrameWindow;
@@ -65,15 +69,22 @@ public:
     UINT GetClientWidth() const;
     UINT GetClientHeight() const;
     UINT GetZOrder() const;
-    BYTE* GetBuffer() const;
+
+    // Copies the latest frame into memory owned by the window. It stays valid until the next call,
+    // even if the capture resources are released in the meantime, and until the window is destroyed.
+    BYTE* GetBuffer();
+
     UINT GetTextureWidth() const;
     UINT GetTextureHeight() const;
     UINT GetTextureOffsetX() const;
     UINT GetTextureOffsetY() const;
-    UINT GetIconWidth() const;
-    UINT GetIconHeight() const;
+    UINT GetIconWidth();
+    UINT GetIconHeight();
 
-    const std::wstring& GetTitle() const;
+    // The title is replaced by the metadata thread, so it is shared as an immutable string.
+    // The pointer given to the host stays valid until the next call for the window.
+    std::shared_ptr<const std::wstring> GetTitle() const;
+    const WCHAR* GetTitleForHost();
     const std::string& GetClass() const;
 
     void SetWindowTexture(ID3D11Texture2D* ptr);
@@ -90,12 +101,24 @@ public:
 
     UINT GetPixel(int x, int y) const;
     bool GetPixels(BYTE* output, int x, int y, int width, int height) const;
+    bool ReadBuffer(const std::function<void(const BYTE*, UINT, UINT)>& reader) const;
+    UINT64 GetBufferVersion() const;
+    LatencyStats GetLatencyStats(PipelineStage stage) const;
+    FrameLatencyStats GetFrameLatencyStats() const;
 
     void RequestUpdateTitle();
 
-    void Capture();
+    // isAlive is cleared when the capture thread has been finalized while the capture was stuck.
+    void Capture(const std::atomic<bool>& isAlive);
+    void CaptureInGroup(const std::shared_ptr<CaptureGroup>& group, const std::atomic<bool>& isAlive);
+    bool CanCaptureBlock() const;
     void Upload();
     void Render();
+    void ReleaseCaptureGroup();
+
+    bool IsCaptureGroupPending() const;
+    UINT GetCaptureGroupSequence() const;
+    ULONGLONG GetCaptureGroupTimestamp() const;
 
     void CaptureIcon();
     void UploadIcon();
@@ -117,25 +140,79 @@ public:
 
     bool IsWindowsGraphicsCaptureAvailable() const;
 
+    float GetVisibleFraction() const;
+    std::vector<RECT> GetVisibleRects() const;
+    bool IsOccluded() const;
+
+    UINT GetResolvedMetadata() const;
+    bool IsMetadataResolved(UINT metadata) const;
+
+    bool HasWindowTexture() const;
+    void RenewCaptureLease();
+    UINT64 ReleaseCaptureResourcesIfLeaseExpired(ULONGLONG leaseTimeMs);
+    bool ReleaseWindowTextureIfIdle(ULONGLONG idleTimeMs);
+
 private:
-    void InitTexture();
-    void UpdateFrameCount();
+    std::shared_ptr<class WindowTexture> GetWindowTextureInstance() const;
+    std::shared_ptr<class WindowTexture> GetOrCreateWindowTextureInstance();
+    std::shared_ptr<class IconTexture> GetIconTextureInstance() const;
+    std::shared_ptr<class IconTexture> GetOrCreateIconTextureInstance();
     void UpdateTitle();
+    bool ShouldUpdateTitle() const;
+    void UpdateMetadata();
+    void ResolveUWP();
     void UpdateIsBackground();
-    bool IsJustAdded() const;
+    void SetVisibility(float fraction, std::vector<RECT>&& rects);
+    bool CaptureInternal(const std::atomic<bool>& isAlive, const CaptureGroup* group);
+    void FinishCapture(UINT groupSequence);
 
     const int id_ = -1;
     int parentId_ = -1;
     Data1 data1_ = {};
     Data2 data2_ = {};
+
+    // Textures are created on the first request from the host. Each capture request renews
+    // the lease of the window, which is a single one shared by all of its requesters; its buffers
+    // are released when the lease expires and the window texture itself after a longer idle time.
+    // Sessions of Windows Graphics Capture are not part of the lease.
+    // The settings from the host are kept here to restore them to a recreated texture.
     std::shared_ptr<class WindowTexture> windowTexture_;
     std::shared_ptr<class IconTexture> iconTexture_;
-
-    int frameCount_ = 0;
-
+    std::mutex textureMutex_;
+    std::atomic<ID3D11Texture2D*> unityWindowTexture_ = nullptr;
+    std::atomic<CaptureMode> captureMode_;
+    std::atomic<bool> drawCursor_ = true;
+    std::atomic<ULONGLONG> lastCaptureRequestTime_ = 0;
+    std::atomic<bool> hasCaptureResources_ = false;
+    Buffer<BYTE> bufferForGetBuffer_;
+    std::mutex bufferForGetBufferMutex_;
+
+    // The group whose frame is being captured or held back, and the one last rendered.
+    // The sequences of the groups the captured and the uploaded frames were taken for (0 for none),
+    // so that a frame taken outside of a group is never stamped with the sequence of a group.
+    std::shared_ptr<CaptureGroup> captureGroup_;
+    std::atomic<UINT> capturedFrameGroupSequence_ = 0;
+    std::atomic<UINT> uploadedFrameGroupSequence_ = 0;
+    std::atomic<UINT> captureGroupSequence_ = 0;
+    std::atomic<ULONGLONG> captureGroupTimestamp_ = 0;
+
+    // Region not covered by other windows, updated when the window layout changes.
+    std::atomic<float> visibleFraction_ = 1.f;
+    std::vector<RECT> visibleRects_;
+    mutable std::mutex visibilityMutex_;
+
+    std::shared_ptr<const std::wstring> title_ = std::make_shared<const std::wstring>();
+    std::shared_ptr<const std::wstring> titleForHost_;
+
+    // Windows which keep an empty title are retried less and less often.
+    std::atomic<UINT> emptyTitleCount_ = 0;
+    std::atomic<ULONGLONG> nextEmptyTitleUpdateTime_ = 0;
+
+    // The package of the process is resolved by the metadata thread or by the first icon access, whichever comes first.
+    std::atomic<UINT> resolvedMetadata_ = 0;
+    std::mutex resolveUWPMutex_;
     std::atomic<bool> hasTitleUpdateRequested_ = false;
     std::atomic<bool> hasNewWindowTextureCaptured_ = false;
     std::atomic<bool> hasNewWindowTextureUploaded_ = false;
     std::atomic<bool> hasNewIconTextureUploaded_ = false;
-    std::atomic<bool> isAlive_ = true;
 };
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "Platform.h"
+#include "Buffer.h"
+#include "WindowData.h"
+
+
+struct WindowAttributes
+{
+    HWND hParent = NULL;
+    HINSTANCE hInstance = NULL;
+    DWORD processId = 0;
+    DWORD threadId = 0;
+    bool isAltTabWindow = false;
+    std::string className;
+};
+
+
+enum class WindowState
+{
+    Enabled,
+    Unicode,
+    Zoomed,
+    Iconic,
+    Hung,
+    Touchable,
+    Cloaked,
+};
+
+
+// Source of the window list and optionally of window frames,
+// so that the scheduling, queueing and reconciliation can run without real windows.
+class WindowBackend
+{
+public:
+    virtual ~WindowBackend() = default;
+
+    // Appends visible top-level windows from the front of the z-order, and then one entry per monitor.
+    virtual void EnumerateWindows(std::vector<WindowData>& windows) = 0;
+    virtual bool IsWindow(HWND hWnd) const = 0;
+    virtual bool IsWindowVisible(HWND hWnd) const = 0;
+
+    // The window at the point and the parent of a window as ::WindowFromPoint() and ::GetAncestor(GA_PARENT) give them.
+    virtual HWND GetWindowFromPoint(POINT point) const = 0;
+    virtual HWND GetParentWindow(HWND hWnd) const = 0;
+
+    // Every per-window query goes through the backend so that handles of other backends never reach Win32.
+    virtual bool GetWindowAttributes(HWND hWnd, WindowAttributes& attributes) const = 0;
+    virtual bool GetWindowTitle(HWND hWnd, std::wstring& title) const = 0;
+    virtual bool GetWindowState(HWND hWnd, WindowState state) const = 0;
+    virtual bool HasIcons() const = 0;
+
+    // Backends without their own frames leave capturing to WindowTexture (PrintWindow, BitBlt or WGC).
+    virtual bool HasFrames() const = 0;
+    virtual bool CaptureFrame(HWND hWnd, Buffer<BYTE>& buffer, UINT& width, UINT& height) = 0;
+};
\ No newline at end of file
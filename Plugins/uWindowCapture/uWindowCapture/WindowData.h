@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Platform.h"
+
+
+// What the enumeration gives for each window (or each monitor for desktops).
+struct WindowData
+{
+    BOOL isDesktop;
+    HWND hWnd;
+    HMONITOR hMonitor;
+    HWND hOwner;
+    RECT windowRect;
+    RECT clientRect;
+    UINT zOrder;
+};
\ No newline at end of file
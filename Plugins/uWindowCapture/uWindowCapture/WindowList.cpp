@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include "WindowList.h"
+#include "Debug.h"
+
+
+
+WindowList::WindowKey WindowList::GetKey(const WindowData& data)
+{
+    // Desktops share the same handle (GetDesktopWindow()), so they are keyed by their monitors.
+    return data.isDesktop ?
+        std::make_pair(TRUE, reinterpret_cast<UINT_PTR>(data.hMonitor)) :
+        std::make_pair(FALSE, reinterpret_cast<UINT_PTR>(data.hWnd));
+}
+
+
+void WindowList::Update(const std::vector<WindowData>& dataList, Listener& listener)
+{
+    // Merge the new list into the previous one, both sorted by the keys.
+    // Ties are ordered by the position in the list to take the first one of duplicated windows.
+    std::vector<const WindowData*> sortedDataList;
+    sortedDataList.reserve(dataList.size());
+    for (const auto& data : dataList)
+    {
+        sortedDataList.push_back(&data);
+    }
+    std::sort(
+        sortedDataList.begin(),
+        sortedDataList.end(),
+        [](const WindowData* a, const WindowData* b)
+        {
+            const auto keyA = GetKey(*a);
+            const auto keyB = GetKey(*b);
+            return (keyA != keyB) ? (keyA < keyB) : (a < b);
+        });
+
+    std::vector<Entry> nextNodes;
+    nextNodes.reserve(sortedDataList.size());
+    std::vector<const WindowData*> addedDataList;
+    std::vector<UpdatedNode> updatedNodes;
+    std::vector<std::unique_ptr<Node>> removedNodes;
+
+    auto it = sortedNodes_.begin();
+    for (size_t i = 0; i < sortedDataList.size(); ++i)
+    {
+        const auto& data = *sortedDataList[i];
+        const auto key = GetKey(data);
+        if (i > 0 && GetKey(*sortedDataList[i - 1]) == key) continue;
+
+        for (; it != sortedNodes_.end() && it->key < key; ++it)
+        {
+            removedNodes.push_back(std::move(it->node));
+        }
+
+        if (it != sortedNodes_.end() && it->key == key)
+        {
+            auto& node = *it->node;
+            updatedNodes.push_back({ &node, node.data });
+            SetData(node, data);
+            nextNodes.push_back(std::move(*it));
+            ++it;
+        }
+        else
+        {
+            addedDataList.push_back(&data);
+        }
+    }
+    for (; it != sortedNodes_.end(); ++it)
+    {
+        removedNodes.push_back(std::move(it->node));
+    }
+
+    const auto orderChanges = GetOrderChanges(updatedNodes);
+    for (size_t i = 0; i < updatedNodes.size(); ++i)
+    {
+        listener.OnWindowUpdated(*updatedNodes[i].node, updatedNodes[i].previousData, orderChanges[i]);
+    }
+
+    for (const auto& node : removedNodes)
+    {
+        RemoveParentCandidate(*node);
+        if (!node->data.isDesktop)
+        {
+            nodesByHandle_.erase(node->data.hWnd);
+        }
+        listener.OnWindowRemoved(*node);
+    }
+
+    sortedNodes_ = std::move(nextNodes);
+
+    // Add new windows in the enumeration order so that owners are added before the windows they own.
+    std::sort(addedDataList.begin(), addedDataList.end());
+    for (const auto data : addedDataList)
+    {
+        auto node = std::make_unique<Node>();
+        node->data = *data;
+        if (!listener.OnWindowAdding(*node)) continue;
+
+        if (!data->isDesktop)
+        {
+            nodesByHandle_.emplace(data->hWnd, node.get());
+        }
+
+        node->parentId = FindParent(*node);
+        AddParentCandidate(*node);
+        listener.OnWindowAdded(*node);
+
+        sortedNodes_.push_back({ GetKey(*data), std::move(node) });
+    }
+
+    if (!addedDataList.empty())
+    {
+        std::sort(
+            sortedNodes_.begin(),
+            sortedNodes_.end(),
+            [](const Entry& a, const Entry& b)
+            {
+                return a.key < b.key;
+            });
+    }
+}
+
+
+std::vector<bool> WindowList::GetOrderChanges(const std::vector<UpdatedNode>& nodes)
+{
+    // Compares the window right above each one in the previous and the current z-order.
+    // Ties (e.g. desktops) are ordered by the id, which does not change.
+    const size_t count = nodes.size();
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        order[i] = i;
+    }
+
+    const auto getAbove = [&](auto getZOrder)
+    {
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+        {
+            const auto keyA = ZOrderKey{ getZOrder(nodes[a]), nodes[a].node->id };
+            const auto keyB = ZOrderKey{ getZOrder(nodes[b]), nodes[b].node->id };
+            return keyA < keyB;
+        });
+
+        std::vector<size_t> above(count, SIZE_MAX);
+        for (size_t i = 0; i + 1 < count; ++i)
+        {
+            above[order[i]] = order[i + 1];
+        }
+        return above;
+    };
+
+    const auto previousAbove = getAbove([](const UpdatedNode& node) { return node.previousData.zOrder; });
+    const auto currentAbove = getAbove([](const UpdatedNode& node) { return node.node->data.zOrder; });
+
+    std::vector<bool> changes(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        changes[i] = previousAbove[i] != currentAbove[i];
+    }
+    return changes;
+}
+
+
+void WindowList::Clear()
+{
+    sortedNodes_.clear();
+    nodesByHandle_.clear();
+    parentCandidates_.clear();
+}
+
+
+void WindowList::SetData(Node& node, const WindowData& data)
+{
+    if (node.data.zOrder == data.zOrder)
+    {
+        node.data = data;
+        return;
+    }
+
+    // Re-insert the node to keep the candidates sorted by the new z-order.
+    const auto it = parentCandidates_.find({ node.processId, node.threadId });
+    const bool isCandidate =
+        (it != parentCandidates_.end()) &&
+        (it->second.erase({ node.data.zOrder, node.id }) > 0);
+
+    node.data = data;
+
+    if (isCandidate)
+    {
+        it->second.emplace(ZOrderKey{ node.data.zOrder, node.id }, &node);
+    }
+}
+
+
+int WindowList::FindParent(const Node& node) const
+{
+    // Gives the same result as FindParentByScan(): the window nearest above the given one
+    // among its parent, its owner and the top-level windows of the same thread.
+    // Ties are broken by the smaller id.
+    const Node* parent = nullptr;
+    int minDeltaZOrder = INT_MAX;
+    const int selfZOrder = node.data.zOrder;
+
+    const auto check = [&](const Node* other)
+    {
+        if (!other || other->id == node.id) return;
+
+        const int deltaZOrder = static_cast<int>(other->data.zOrder) - selfZOrder;
+        if (deltaZOrder <= 0) return;
+
+        const bool isNearer =
+            (deltaZOrder < minDeltaZOrder) ||
+            (deltaZOrder == minDeltaZOrder && parent && other->id < parent->id);
+        if (isNearer)
+        {
+            minDeltaZOrder = deltaZOrder;
+            parent = other;
+        }
+    };
+
+    for (const auto hWnd : { node.hParent, node.data.hOwner })
+    {
+        if (hWnd == NULL) continue;
+
+        const auto it = nodesByHandle_.find(hWnd);
+        if (it != nodesByHandle_.end())
+        {
+            check(it->second);
+        }
+    }
+
+    const auto it = parentCandidates_.find({ node.processId, node.threadId });
+    if (it != parentCandidates_.end())
+    {
+        const auto& candidates = it->second;
+        const auto next = candidates.lower_bound({ node.data.zOrder + 1, INT_MIN });
+        if (next != candidates.end())
+        {
+            check(next->second);
+        }
+    }
+
+    const int parentId = parent ? parent->id : -1;
+
+#ifdef UWC_DEBUG_ON
+    const int expectedId = FindParentByScan(node);
+    if (expectedId != parentId)
+    {
+        Debug::Error(__FUNCTION__, " => Parent mismatch: id=", node.id,
+            ", expected=", expectedId,
+            ", actual=", parentId);
+    }
+#endif
+
+    return parentId;
+}
+
+
+int WindowList::FindParentByScan(const Node& node) const
+{
+    const Node* parent = nullptr;
+    int minDeltaZOrder = INT_MAX;
+    int selfZOrder = node.data.zOrder;
+
+    for (const auto& entry : sortedNodes_)
+    {
+        const auto& other = *entry.node;
+        if (other.id == node.id)
+        {
+            continue;
+        }
+
+        if ((
+            other.data.hWnd == node.hParent ||
+            other.data.hWnd == node.data.hOwner
+        ) ||
+        (
+            ((other.parentId == -1 || other.isAltTab) &&
+            other.processId == node.processId &&
+            other.threadId  == node.threadId)
+        ))
+        {
+            // TODO: This is not accurate, should find the correct way to detect the parent.
+            const int zOrder = other.data.zOrder;
+            const int deltaZOrder = zOrder - selfZOrder;
+            const bool isNearer =
+                (deltaZOrder < minDeltaZOrder) ||
+                (deltaZOrder == minDeltaZOrder && parent && other.id < parent->id);
+            if (deltaZOrder > 0 && isNearer)
+            {
+                minDeltaZOrder = deltaZOrder;
+                parent = &other;
+            }
+        }
+    }
+
+    return parent ? parent->id : -1;
+}
+
+
+void WindowList::AddParentCandidate(const Node& node)
+{
+    // Desktops are never chosen as a parent since their z-order is always 0.
+    if (node.data.isDesktop) return;
+
+    if (node.parentId != -1 && !node.isAltTab) return;
+
+    auto& candidates = parentCandidates_[{ node.processId, node.threadId }];
+    candidates.emplace(ZOrderKey{ node.data.zOrder, node.id }, &node);
+}
+
+
+void WindowList::RemoveParentCandidate(const Node& node)
+{
+    const auto it = parentCandidates_.find({ node.processId, node.threadId });
+    if (it == parentCandidates_.end()) return;
+
+    auto& candidates = it->second;
+    candidates.erase({ node.data.zOrder, node.id });
+    if (candidates.empty())
+    {
+        parentCandidates_.erase(it);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+#include "Platform.h"
+#include "WindowData.h"
+
+
+// Merges each enumerated window list into the previous one and resolves the parents of new windows.
+// Only what the reconciliation needs is kept here; the owner creates, updates and removes
+// its own windows through the listener.
+class WindowList
+{
+public:
+    struct Node
+    {
+        int id = -1;
+        WindowData data = {};
+        HWND hParent = NULL;
+        DWORD processId = 0;
+        DWORD threadId = 0;
+        bool isAltTab = false;
+        int parentId = -1;
+    };
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        // Creates the window of a new node and fills its id, parent handle, thread and alt-tab flag.
+        // The node is not added if this returns false.
+        virtual bool OnWindowAdding(Node& node) = 0;
+        virtual void OnWindowAdded(const Node& node) = 0;
+
+        // Called for every window which is kept, after its data has been replaced.
+        // hasOrderChanged is true when the window right above it among the kept windows is not the same one,
+        // so that windows shifted by others being added or removed are not reported.
+        virtual void OnWindowUpdated(const Node& node, const WindowData& previousData, bool hasOrderChanged) = 0;
+        virtual void OnWindowRemoved(const Node& node) = 0;
+    };
+
+    void Update(const std::vector<WindowData>& dataList, Listener& listener);
+    void Clear();
+    size_t GetSize() const { return sortedNodes_.size(); }
+
+    int FindParent(const Node& node) const;
+    int FindParentByScan(const Node& node) const;
+
+private:
+    using WindowKey = std::pair<BOOL, UINT_PTR>; // (isDesktop, hMonitor or hWnd)
+    using ThreadKey = std::pair<DWORD, DWORD>; // (processId, threadId)
+    using ZOrderKey = std::pair<UINT, int>; // (zOrder, id)
+
+    struct Entry
+    {
+        WindowKey key;
+        std::unique_ptr<Node> node;
+    };
+
+    struct UpdatedNode
+    {
+        Node* node;
+        WindowData previousData;
+    };
+
+    static WindowKey GetKey(const WindowData& data);
+    static std::vector<bool> GetOrderChanges(const std::vector<UpdatedNode>& nodes);
+    void SetData(Node& node, const WindowData& data);
+    void AddParentCandidate(const Node& node);
+    void RemoveParentCandidate(const Node& node);
+
+    std::vector<Entry> sortedNodes_;
+    std::unordered_map<HWND, const Node*> nodesByHandle_;
+    std::map<ThreadKey, std::map<ZOrderKey, const Node*>> parentCandidates_;
+};
\ No newline at end of file
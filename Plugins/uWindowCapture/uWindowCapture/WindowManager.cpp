@@ -2,7 +2,9 @@
 #include <oleacc.h>
 #include "WindowManager.h"
 #include "WindowTexture.h"
+#include "RectSet.h"
 #include "Message.h"
+#include "TraceRecorder.h"
 #include "Util.h"
 #include "Debug.h"
 
@@ -10,23 +12,63 @@ using namespace Microsoft::WRL;
 
 
 
+namespace
+{
+    constexpr UINT kDefaultWindowTextureIdleTimeout = 30000 /* milliseconds */;
+    constexpr UINT kDefaultCaptureLeaseDuration = 5000 /* milliseconds */;
+    constexpr UINT kDefaultMinWindowListInterval = 16 /* milliseconds */;
+    constexpr UINT kDefaultMaxWindowListInterval = 250 /* milliseconds */;
+    constexpr UINT kIdlePassCountToBackOff = 4;
+    constexpr float kPassTimeSmoothing = 0.1f;
+}
+
+
+// ---
+
+
 UWC_SINGLETON_INSTANCE(WindowManager)
 
 
 void WindowManager::Initialize()
 {
+    initializedTime_ = std::chrono::steady_clock::now();
+    hasFirstWindowListPublished_ = false;
+    windowTextureIdleTimeout_ = kDefaultWindowTextureIdleTimeout;
+    captureLeaseDuration_ = kDefaultCaptureLeaseDuration;
+    idleReleaseCount_ = 0;
+    idleTextureReleaseCount_ = 0;
+    idleReleasedBytes_ = 0;
+    minWindowListInterval_ = kDefaultMinWindowListInterval;
+    maxWindowListInterval_ = kDefaultMaxWindowListInterval;
+    windowListStats_ = {};
+
+    if (syntheticWindowSettings_.windowCount > 0)
     {
-        UWC_SCOPE_TIMER(InitWindowsGraphicsCaptureManager);
-        windowsGraphicsCaptureManager_ = std::make_unique<WindowsGraphicsCaptureManager>();
+        windowBackend_ = std::make_unique<SyntheticWindowBackend>(syntheticWindowSettings_);
     }
+    else
     {
-        UWC_SCOPE_TIMER(InitUploadManager);
-        uploadManager_ = std::make_unique<UploadManager>();
+        windowBackend_ = std::make_unique<Win32WindowBackend>();
+    }
+    if (!isHeadless_)
+    {
+        {
+            UWC_SCOPE_TIMER(InitWindowsGraphicsCaptureManager);
+            windowsGraphicsCaptureManager_ = std::make_unique<WindowsGraphicsCaptureManager>();
+        }
+        {
+            UWC_SCOPE_TIMER(InitUploadManager);
+            uploadManager_ = std::make_unique<UploadManager>();
+        }
     }
     {
         UWC_SCOPE_TIMER(InitCaptureManager);
         captureManager_ = std::make_unique<CaptureManager>();
     }
+    {
+        UWC_SCOPE_TIMER(InitMetadataManager);
+        metadataManager_ = std::make_unique<MetadataManager>();
+    }
     {
         UWC_SCOPE_TIMER(Cursor);
         cursor_ = std::make_unique<Cursor>();
@@ -41,14 +83,17 @@ void WindowManager::Initialize()
 void WindowManager::Finalize()
 {
     StopWindowHandleListThread();
+    metadataManager_.reset();
     cursor_.reset();
     captureManager_.reset();
     uploadManager_.reset();
     windowsGraphicsCaptureManager_.reset();
-    {
-        std::scoped_lock lock(windowsListMutex_);
-        windows_.clear();
-    }
+    windows_.Clear();
+    windowList_.Clear();
+    windowTable_.Clear();
+    windowTable_.Unpublish();
+    std::atomic_store(&spatialIndex_, std::shared_ptr<const WindowSpatialIndex>());
+    windowBackend_.reset();
 }
 
 
@@ -63,6 +108,17 @@ void WindowManager::Update(float dt)
 
 void WindowManager::Render()
 {
+    if (isHeadless_) return;
+
+    thread_local bool hasThreadNameSet = false;
+    if (!hasThreadNameSet)
+    {
+        TraceRecorder::SetThreadName(L"Unity Render Thread");
+        hasThreadNameSet = true;
+    }
+
+    UWC_TRACE_SCOPE("Render", -1)
+
     RenderWindows();
     cursor_->Render();
 }
@@ -72,9 +128,19 @@ void WindowManager::StartWindowHandleListThread()
 {
     windowHandleListThreadLoop_.Start([this]
     {
+        ScopedTimer timer([this](std::chrono::microseconds us)
+        {
+            LatencyMetrics::Record(PipelineStage::Enumerate, static_cast<UINT>(us.count()));
+            UpdateWindowListInterval(us);
+        });
+        UWC_TRACE_SCOPE("UpdateWindowList", -1)
+
         UpdateWindowHandleList();
         UpdateWindows();
-    }, std::chrono::milliseconds(16));
+        UpdateSpatialIndex();
+        UpdateCursorWindow();
+        return true;
+    }, std::chrono::milliseconds(minWindowListInterval_.load()));
 }
 
 
@@ -84,6 +150,12 @@ void WindowManager::StopWindowHandleListThread()
 }
 
 
+const std::unique_ptr<WindowBackend>& WindowManager::GetWindowBackend()
+{
+    return WindowManager::Get().windowBackend_;
+}
+
+
 const std::unique_ptr<CaptureManager>& WindowManager::GetCaptureManager()
 {
     return WindowManager::Get().captureManager_;
@@ -96,6 +168,12 @@ const std::unique_ptr<UploadManager>& WindowManager::GetUploadManager()
 }
 
 
+const std::unique_ptr<MetadataManager>& WindowManager::GetMetadataManager()
+{
+    return WindowManager::Get().metadataManager_;
+}
+
+
 const std::unique_ptr<WindowsGraphicsCaptureManager>& WindowManager::GetWindowsGraphicsCaptureManager()
 {
     return WindowManager::Get().windowsGraphicsCaptureManager_;
@@ -108,77 +186,86 @@ const std::unique_ptr<Cursor>& WindowManager::GetCursor()
 }
 
 
+std::shared_ptr<const WindowManager::WindowTable::Snapshot> WindowManager::GetWindows() const
+{
+    return windowTable_.Acquire();
+}
+
+
 bool WindowManager::CheckExistence(int id) const
 {
-    std::scoped_lock lock(windowsListMutex_);
-    return windows_.find(id) != windows_.end();
+    return GetWindow(id) != nullptr;
 }
 
 
 std::shared_ptr<Window> WindowManager::GetWindow(int id) const
 {
-    std::scoped_lock lock(windowsListMutex_);
+    if (id < 0) return nullptr;
 
-    auto it = windows_.find(id);
-    if (it == windows_.end())
-    {
-        return nullptr;
-    }
+    const auto windows = GetWindows();
+    if (!windows) return nullptr;
 
-    return it->second;
+    // The slot may have been reused by another window since the id was given.
+    const auto& window = windows->Get(WindowSlotMap::GetIndex(id));
+    return (window && window->GetId() == id) ? window : nullptr;
 }
 
 
 std::shared_ptr<Window> WindowManager::GetWindowFromPoint(POINT point) const
 {
-    auto hWnd = ::WindowFromPoint(point);
+    // Asks the system as before, so that child windows, transparent windows and windows
+    // which have changed since the last enumeration are hit-tested exactly.
+    // GetWindowIdsFromPoints() answers from the spatial index instead, which gives the same top-level windows.
+    if (!windowBackend_) return nullptr;
 
-    while (hWnd != NULL)
+    std::vector<HWND> ancestors;
+    for (auto hWnd = windowBackend_->GetWindowFromPoint(point); hWnd != NULL; hWnd = windowBackend_->GetParentWindow(hWnd))
     {
-        DWORD thread, process;
-        thread = ::GetWindowThreadProcessId(hWnd, &process);
+        ancestors.push_back(hWnd);
+    }
+    if (ancestors.empty()) return nullptr;
 
-        std::shared_ptr<Window> parent;
-        int maxZOrder = INT_MAX;
+    const auto windows = GetWindows();
+    if (!windows) return nullptr;
 
+    // Returns the nearest ancestor which is a captured window.
+    std::shared_ptr<Window> found;
+    size_t foundDepth = ancestors.size();
+    for (const auto& window : *windows)
+    {
+        // Desktops share the same handle, so only the one of the monitor at the point is taken.
+        if (window->IsDesktop())
         {
-            std::scoped_lock lock(windowsListMutex_);
-
-            for (const auto& pair : windows_)
-            {
-                const auto& window = pair.second;
-
-                // Return the window whose handle is same
-                if (window->GetWindowHandle() == hWnd) 
-                {
-                    return window;
-                }
-
-                // Keep windows whose process and thread ids are same
-                if ((window->GetThreadId() == thread) &&
-                    (window->GetProcessId() == process))
-                {
-                    const int zOrder = window->GetZOrder();
-                    if (zOrder > maxZOrder)
-                    {
-                        maxZOrder = zOrder;
-                        parent = window;
-                    }
-                }
-            }
+            const auto& rect = window->GetWindowRect();
+            const bool isInside = rect.left <= point.x && point.x < rect.right && rect.top <= point.y && point.y < rect.bottom;
+            if (!isInside) continue;
         }
 
-        // Return parent if found.
-        if (parent)
+        const auto it = std::find(ancestors.begin(), ancestors.begin() + foundDepth, window->GetWindowHandle());
+        const auto depth = static_cast<size_t>(it - ancestors.begin());
+        if (depth < foundDepth)
         {
-            return parent;
+            found = window;
+            foundDepth = depth;
         }
-
-        // Move next
-        hWnd = ::GetAncestor(hWnd, GA_PARENT);
     }
 
-    return nullptr;
+    return found;
+}
+
+
+void WindowManager::GetWindowIdsFromPoints(const POINT* points, int* outIds, int count) const
+{
+    // Many points are queried at once (e.g. raycasts), so they are not hit-tested by the system one by one.
+    const auto index = std::atomic_load(&spatialIndex_);
+    if (index)
+    {
+        index->Find(points, outIds, count);
+    }
+    else
+    {
+        std::fill(outIds, outIds + count, -1);
+    }
 }
 
 
@@ -188,231 +275,325 @@ std::shared_ptr<Window> WindowManager::GetCursorWindow() const
 }
 
 
-std::shared_ptr<Window> WindowManager::FindParentWindow(const std::shared_ptr<Window>& window) const
+bool WindowManager::ComposeVirtualDesktop()
 {
-    std::shared_ptr<Window> parent = nullptr;
-    int minDeltaZOrder = INT_MAX;
-    int selfZOrder = window->GetZOrder();
+    const auto windows = GetWindows();
+    if (!windows) return false;
 
-    for (const auto& pair : windows_)
+    std::vector<std::shared_ptr<Window>> desktops;
+    for (const auto& window : *windows)
     {
-        const auto& other = pair.second;
-
-        if (other->GetId() == window->GetId()) 
+        if (window->IsDesktop())
         {
-            continue;
+            desktops.push_back(window);
         }
+    }
 
-        if ((
-            other->GetWindowHandle() == window->GetParentHandle() ||
-            other->GetWindowHandle() == window->GetOwnerHandle()
-        ) || 
-        (
-            ((other->GetParentId()  == -1 || other->IsAltTab()) &&
-            other->GetProcessId() == window->GetProcessId() &&
-            other->GetThreadId()  == window->GetThreadId()) 
-        ))
-        {
-            // TODO: This is not accurate, should find the correct way to detect the parent.
-            const int zOrder = other->GetZOrder();
-            const int deltaZOrder = zOrder - selfZOrder;
-            if (deltaZOrder > 0 && deltaZOrder < minDeltaZOrder)
-            {
-                minDeltaZOrder = deltaZOrder;
-                parent = other;
-            }
-        }
+    // Keep the order stable so that the layout is not considered changed without reason.
+    std::sort(desktops.begin(), desktops.end(), [](const auto& a, const auto& b)
+    {
+        return a->GetId() < b->GetId();
+    });
+
+    std::vector<DesktopCompositor::Source> sources;
+    sources.reserve(desktops.size());
+    for (const auto& desktop : desktops)
+    {
+        sources.push_back({
+            desktop->GetId(),
+            desktop->GetWindowRect(),
+            desktop->GetBufferVersion(),
+            [desktop](const DesktopCompositor::FrameReader& reader) { return desktop->ReadBuffer(reader); }
+        });
     }
 
-    return parent;
+    return virtualDesktopCompositor_.Compose(sources);
 }
 
 
-std::shared_ptr<Window> WindowManager::FindOrAddWindow(const Window::Data1 &data)
+void WindowManager::SetWindowTextureIdleTimeout(UINT milliseconds)
 {
-    std::scoped_lock lock(windowsListMutex_);
+    windowTextureIdleTimeout_ = milliseconds;
+}
 
-    const auto it = std::find_if(
-        windows_.begin(),
-        windows_.end(),
-        [&](const auto& pair) 
-        { 
-            const auto& window = pair.second;
-            return data.isDesktop ?
-                (window->IsDesktop() && window->GetMonitorHandle() == data.hMonitor) :
-                (window->GetWindowHandle() == data.hWnd);
-        });
 
-    if (it != windows_.end())
-    {
-        return it->second;
-    }
+void WindowManager::SetCaptureLeaseDuration(UINT milliseconds)
+{
+    captureLeaseDuration_ = milliseconds;
+}
 
-    const auto id = lastWindowId_++;
-    auto window = std::make_shared<Window>(id, data);
-    windows_.emplace(id, window);
 
-    return window;
+IdleReleaseStats WindowManager::GetIdleReleaseStats() const
+{
+    IdleReleaseStats stats;
+    stats.releaseCount = idleReleaseCount_;
+    stats.textureReleaseCount = idleTextureReleaseCount_;
+    stats.releasedBytes = idleReleasedBytes_;
+    return stats;
 }
 
 
-void WindowManager::UpdateWindows()
+void WindowManager::SetWindowListIntervalRange(UINT minMilliseconds, UINT maxMilliseconds)
 {
-    UWC_SCOPE_TIMER(UpdateWindows);
+    minWindowListInterval_ = max(minMilliseconds, 1u);
+    maxWindowListInterval_ = max(maxMilliseconds, minWindowListInterval_.load());
+    RequestWindowListUpdate();
+}
 
-    {
-        std::scoped_lock lock(windowsListMutex_);
 
-        for (const auto& pair : windows_)
+void WindowManager::RequestWindowListUpdate()
+{
+    hasWindowListUpdateRequested_ = true;
+    windowHandleListThreadLoop_.Wake();
+}
+
+
+void WindowManager::SetSyntheticWindowSettings(const SyntheticWindowSettings& settings)
+{
+    // Applied in Initialize().
+    syntheticWindowSettings_ = settings;
+}
+
+
+void WindowManager::SetHeadless(bool isHeadless)
+{
+    // Applied in Initialize().
+    isHeadless_ = isHeadless;
+}
+
+
+bool WindowManager::IsHeadless()
+{
+    return WindowManager::Get().isHeadless_;
+}
+
+
+WindowListStats WindowManager::GetWindowListStats() const
+{
+    std::lock_guard<std::mutex> lock(windowListStatsMutex_);
+    return windowListStats_;
+}
+
+
+bool WindowManager::OnWindowAdding(WindowList::Node& node)
+{
+    auto window = windows_.Add(node.data);
+    if (!window) return false;
+
+    windowTable_.Set(WindowSlotMap::GetIndex(window->GetId()), window);
+    hasWindowListChanged_ = true;
+    isSpatialIndexDirty_ = true;
+    ++addedCountInPass_;
+
+    InitWindow(window);
+
+    node.id = window->GetId();
+    node.hParent = window->GetParentHandle();
+    node.processId = window->GetProcessId();
+    node.threadId = window->GetThreadId();
+    node.isAltTab = window->IsAltTab();
+
+    return true;
+}
+
+
+void WindowManager::OnWindowAdded(const WindowList::Node& node)
+{
+    const auto window = windows_.Find(node.id);
+    window->parentId_ = node.parentId;
+    messagesInPass_.push_back({ MessageType::WindowAdded, window->GetId(), window->GetWindowHandle() });
+}
+
+
+void WindowManager::OnWindowUpdated(const WindowList::Node& node, const WindowData& previousData, bool hasOrderChanged)
+{
+    const auto window = windows_.Find(node.id);
+    const auto& data = node.data;
+
+    const bool hasRectChanged = !::EqualRect(&previousData.windowRect, &data.windowRect);
+    const bool hasZOrderChanged = previousData.zOrder != data.zOrder;
+    const bool hasOtherChanged = 
+        !::EqualRect(&previousData.clientRect, &data.clientRect) ||
+        previousData.hMonitor != data.hMonitor ||
+        previousData.hOwner != data.hOwner;
+
+    if (hasRectChanged || hasZOrderChanged || hasOtherChanged)
+    {
+        window->SetData(data);
+    }
+
+    if (hasRectChanged || hasZOrderChanged)
+    {
+        isSpatialIndexDirty_ = true;
+        ++changedCountInPass_;
+    }
+
+    if (hasRectChanged)
+    {
+        messagesInPass_.push_back({ MessageType::WindowMoved, window->GetId(), window->GetWindowHandle() });
+    }
+
+    if (hasOrderChanged)
+    {
+        messagesInPass_.push_back({ MessageType::WindowZOrderChanged, window->GetId(), window->GetWindowHandle() });
+    }
+
+    UpdateWindowState(window);
+}
+
+
+void WindowManager::OnWindowRemoved(const WindowList::Node& node)
+{
+    messagesInPass_.push_back({ MessageType::WindowRemoved, node.id, node.data.hWnd });
+
+    windows_.Remove(node.id);
+    windowTable_.Reset(WindowSlotMap::GetIndex(node.id));
+    hasWindowListChanged_ = true;
+    isSpatialIndexDirty_ = true;
+    ++removedCountInPass_;
+}
+
+
+void WindowManager::InitWindow(const std::shared_ptr<Window>& window)
+{
+    auto &data2 = window->data2_;
+    const auto hWnd = window->GetWindowHandle();
+
+    WindowAttributes attributes;
+    windowBackend_->GetWindowAttributes(hWnd, attributes);
+    data2.threadId = attributes.threadId;
+    data2.processId = attributes.processId;
+
+    if (!window->IsDesktop())
+    {
+        data2.hParent = attributes.hParent;
+        data2.hInstance = attributes.hInstance;
+        data2.isAltTabWindow = attributes.isAltTabWindow;
+        data2.className = attributes.className;
+        data2.isApplicationFrameWindow = IsApplicationFrameWindow(data2.className);
+        data2.isUWP = data2.isApplicationFrameWindow;
+        window->UpdateIsBackground();
+
+        // The title and the package of the process are resolved later in MetadataManager
+        // since they may take a long time when the process is busy.
+        if (data2.isApplicationFrameWindow)
         {
-            pair.second->isAlive_ = false;
+            window->resolvedMetadata_ |= Window::kMetadataUWP;
         }
+        metadataRequestsInPass_.push_back(window->GetId());
     }
-
+    else
     {
-        std::lock_guard<std::mutex> lock(windowsDataListMutex_);
+        data2.hParent = NULL;
+        data2.hInstance = NULL;
+        data2.isAltTabWindow = false;
+        data2.isApplicationFrameWindow = false;
+        data2.isUWP = false;
+        data2.isBackground = false;
+        data2.className = "";
+        window->UpdateTitle();
+        window->resolvedMetadata_ = Window::kMetadataAll;
+    }
+}
+
 
-        for (auto&& data1 : windowDataList_[0])
+void WindowManager::UpdateWindowState(const std::shared_ptr<Window>& window)
+{
+    if (window->ShouldUpdateTitle())
+    {
+        if (window->IsDesktop())
         {
-            auto window = FindOrAddWindow(data1);
-            if (window)
-            {
-                window->SetData(data1);
-                window->isAlive_ = true;
-
-                if (window->IsJustAdded())
-                {
-                    auto &data2 = window->data2_;
-                    const auto hWnd = window->GetWindowHandle();
-
-                    if (!window->IsDesktop())
-                    {
-                        data2.hParent = ::GetParent(hWnd);
-                        data2.hInstance = reinterpret_cast<HINSTANCE>(::GetWindowLongPtr(hWnd, GWLP_HINSTANCE));
-                        data2.threadId = ::GetWindowThreadProcessId(hWnd, &data2.processId);
-                        data2.isAltTabWindow = IsAltTabWindow(hWnd);
-                        GetWindowClassName(hWnd, data2.className);
-                        data2.isApplicationFrameWindow = IsApplicationFrameWindow(data2.className);
-                        data2.isUWP = data2.isApplicationFrameWindow || IsUWP(data2.processId);
-                        window->UpdateIsBackground();
-                    }
-                    else
-                    {
-                        data2.hParent = NULL;
-                        data2.hInstance = NULL;
-                        data2.threadId = ::GetWindowThreadProcessId(hWnd, &data2.processId);
-                        data2.isAltTabWindow = false;
-                        data2.isApplicationFrameWindow = false;
-                        data2.isUWP = false;
-                        data2.isBackground = false;
-                        data2.className = "";
-                    }
-
-                    if (auto parent = FindParentWindow(window))
-                    {
-                        window->parentId_ = parent->GetId();
-                    }
-
-                    window->InitTexture();
-                    window->UpdateTitle();
-
-                    MessageManager::Get().Add({ MessageType::WindowAdded, window->GetId(), window->GetWindowHandle() });
-                }
-                else
-                {
-                    if (window->hasTitleUpdateRequested_ || window->GetTitle().empty()) 
-                    {
-                        window->hasTitleUpdateRequested_ = false;
-                        window->UpdateTitle();
-                    }
-                    window->UpdateIsBackground();
-                }
-
-                window->UpdateFrameCount();
-            }
+            window->hasTitleUpdateRequested_ = false;
+            window->UpdateTitle();
+        }
+        else
+        {
+            metadataRequestsInPass_.push_back(window->GetId());
         }
     }
 
+    if (const auto releasedBytes = window->ReleaseCaptureResourcesIfLeaseExpired(captureLeaseDuration_))
     {
-        std::scoped_lock lock(windowsListMutex_);
+        ++idleReleaseCount_;
+        idleReleasedBytes_ += releasedBytes;
+    }
 
-        for (auto it = windows_.begin(); it != windows_.end();)
-        {
-            const auto id = it->first;
-            auto& window = it->second;
+    if (window->ReleaseWindowTextureIfIdle(windowTextureIdleTimeout_))
+    {
+        ++idleTextureReleaseCount_;
+    }
 
-            if (!window->isAlive_)
-            {
-                MessageManager::Get().Add({ MessageType::WindowRemoved, id, window->GetWindowHandle() });
-                windows_.erase(it++);
-            }
-            else
-            {
-                it++;
-            }
-        }
+    const bool wasBackground = window->IsBackground();
+    window->UpdateIsBackground();
+    if (window->IsBackground() != wasBackground)
+    {
+        isSpatialIndexDirty_ = true;
+        ++changedCountInPass_;
     }
 }
 
 
-void WindowManager::UpdateWindowHandleList()
+void WindowManager::UpdateWindows()
 {
-    UWC_SCOPE_TIMER(UpdateWindowHandleList);
+    UWC_SCOPE_TIMER(UpdateWindows);
 
-    static const auto _EnumWindowsCallback = [](HWND hWnd, LPARAM lParam) -> BOOL
     {
-        if (!::IsWindow(hWnd) || !::IsWindowVisible(hWnd) || ::IsHungAppWindow(hWnd))
+        std::lock_guard<ProfiledMutex> lock(windowsDataListMutex_);
+
+        const UINT removedCount = removedCountInPass_;
+        windowList_.Update(windowDataList_[0], *this);
+
+        if (removedCountInPass_ != removedCount)
         {
-            return TRUE;
+            std::unordered_set<DWORD> processIds;
+            for (const auto& window : windows_)
+            {
+                processIds.insert(window->GetProcessId());
+            }
+            metadataManager_->RemoveProcessesExcept(processIds);
         }
+    }
 
-        Window::Data1 data;
-        data.hWnd = hWnd;
-        data.hOwner = ::GetWindow(hWnd, GW_OWNER);
-        ::GetWindowRect(hWnd, &data.windowRect);
-        ::GetClientRect(hWnd, &data.clientRect);
-        data.zOrder = ::GetWindowZOrder(hWnd);
-        data.hMonitor = ::MonitorFromWindow(hWnd, MONITOR_DEFAULTTOPRIMARY);
-        data.isDesktop = false;
-
-        auto thiz = reinterpret_cast<WindowManager*>(lParam);
-        thiz->windowDataList_[1].push_back(data);
+    PublishWindows();
 
-        return TRUE;
-    };
+    if (!hasFirstWindowListPublished_)
+    {
+        hasFirstWindowListPublished_ = true;
+        const auto elapsed = std::chrono::steady_clock::now() - initializedTime_;
+        Debug::Log("WindowManager => First window list has been published: ", 
+            windows_.GetSize(), " windows in ",
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), " [us]");
+    }
 
-    using EnumWindowsCallbackType = BOOL(CALLBACK *)(HWND, LPARAM);
-    static const auto EnumWindowsCallback = static_cast<EnumWindowsCallbackType>(_EnumWindowsCallback);
-    if (!::EnumWindows(EnumWindowsCallback, reinterpret_cast<LPARAM>(this)))
+    for (const auto id : metadataRequestsInPass_)
     {
-        OutputApiError(__FUNCTION__, "EnumWindows");
+        metadataManager_->RequestUpdate(id);
     }
+    metadataRequestsInPass_.clear();
 
-    static const auto _EnumDisplayMonitorsCallback = [](HMONITOR hMonitor, HDC hDc, LPRECT lpRect, LPARAM lParam) -> BOOL
+    for (const auto& message : messagesInPass_)
     {
-        const auto hWnd = GetDesktopWindow();;
+        MessageManager::Get().Add(message);
+    }
+    messagesInPass_.clear();
+}
+
 
-        Window::Data1 data;
-        data.hWnd = hWnd;
-        data.hOwner = NULL;
-        data.windowRect = *lpRect;
-        data.clientRect = *lpRect;
-        data.zOrder = 0;
-        data.hMonitor = hMonitor;
-        data.isDesktop = true;
+void WindowManager::PublishWindows()
+{
+    if (!hasWindowListChanged_) return;
+    hasWindowListChanged_ = false;
 
-        auto thiz = reinterpret_cast<WindowManager*>(lParam);
-        thiz->windowDataList_[1].push_back(data);
+    // Copy-on-write: readers keep using the previous version until they acquire the new one.
+    windowTable_.Publish();
+}
 
-        return TRUE;
-    };
 
-    using EnumDisplayMonitorsCallbackType = BOOL(CALLBACK *)(HMONITOR, HDC, LPRECT, LPARAM);
-    static const auto EnumDisplayMonitorsCallback = static_cast<EnumDisplayMonitorsCallbackType>(_EnumDisplayMonitorsCallback);
-    if (!::EnumDisplayMonitors(NULL, NULL, EnumDisplayMonitorsCallback, reinterpret_cast<LPARAM>(this)))
-    {
-        OutputApiError(__FUNCTION__, "EnumDisplayMonitors");
-    }
+void WindowManager::UpdateWindowHandleList()
+{
+    UWC_SCOPE_TIMER(UpdateWindowHandleList);
+
+    windowBackend_->EnumerateWindows(windowDataList_[1]);
 
     std::stable_partition(
         windowDataList_[1].begin(),
@@ -423,25 +604,157 @@ void WindowManager::UpdateWindowHandleList()
         });
 
     {
-        std::lock_guard<std::mutex> lock(windowsDataListMutex_);
+        std::lock_guard<ProfiledMutex> lock(windowsDataListMutex_);
         std::swap(windowDataList_[0], windowDataList_[1]);
     }
     windowDataList_[1].clear();
+}
+
+
+void WindowManager::UpdateSpatialIndex()
+{
+    if (!isSpatialIndexDirty_) return;
+    isSpatialIndexDirty_ = false;
 
+    UWC_SCOPE_TIMER(UpdateSpatialIndex);
+
+    RECT bounds = {};
+    std::vector<RECT> monitors;
+    std::vector<WindowSpatialIndex::Entry> entries;
+    entries.reserve(windows_.GetSize());
+
+    for (const auto& window : windows_)
+    {
+        if (window->IsDesktop())
+        {
+            // Desktops are behind all the windows and cover the virtual screen.
+            ::UnionRect(&bounds, &bounds, &window->GetWindowRect());
+            monitors.push_back(window->GetWindowRect());
+            entries.push_back({ window->GetId(), UINT_MAX, window->GetWindowRect() });
+        }
+        else if (!window->IsBackground())
+        {
+            // Parts out of the monitors are indexed too, e.g. the synthetic windows come without desktops.
+            ::UnionRect(&bounds, &bounds, &window->GetWindowRect());
+            entries.push_back({ window->GetId(), window->GetZOrder(), window->GetWindowRect() });
+        }
+    }
+
+    auto index = std::make_shared<WindowSpatialIndex>();
+    index->Build(bounds, std::move(entries));
+    UpdateVisibility(*index, monitors);
+    std::atomic_store(&spatialIndex_, std::shared_ptr<const WindowSpatialIndex>(std::move(index)));
+}
+
+
+void WindowManager::UpdateVisibility(const WindowSpatialIndex& index, const std::vector<RECT>& monitors)
+{
+    UWC_SCOPE_TIMER(UpdateVisibility);
+
+    std::vector<RECT> occluders;
+
+    for (const auto& window : windows_)
+    {
+        const auto& rect = window->GetWindowRect();
+
+        // Desktop captures show the composed screen, so they are never occluded.
+        if (window->IsDesktop())
+        {
+            window->SetVisibility(1.f, { rect });
+            continue;
+        }
+
+        if (window->IsBackground())
+        {
+            window->SetVisibility(0.f, {});
+            continue;
+        }
+
+        index.FindOccluders(rect, window->GetZOrder(), occluders);
+
+        // Parts out of the monitors are not visible either.
+        auto region = RectSet::GetVisibleRegion(rect, monitors, occluders);
+
+        const LONGLONG area = static_cast<LONGLONG>(window->GetWidth()) * window->GetHeight();
+        const float fraction = (area > 0) ? static_cast<float>(region.GetArea()) / area : 0.f;
+        window->SetVisibility(fraction, region.Release());
+    }
+}
+
+
+void WindowManager::UpdateCursorWindow()
+{
     POINT cursorPos;
     if (::GetCursorPos(&cursorPos))
     {
-        cursorWindow_ = GetWindowFromPoint(cursorPos);
+        const auto window = GetWindowFromPoint(cursorPos);
+        if (window != cursorWindow_.lock())
+        {
+            // Keep the interval short while the cursor moves over windows.
+            ++changedCountInPass_;
+        }
+        cursorWindow_ = window;
+    }
+}
+
+
+void WindowManager::UpdateWindowListInterval(std::chrono::microseconds passTime)
+{
+    const bool hasChanged = 
+        addedCountInPass_ > 0 || 
+        removedCountInPass_ > 0 || 
+        changedCountInPass_ > 0;
+    const bool hasRequested = hasWindowListUpdateRequested_.exchange(false);
+
+    std::lock_guard<std::mutex> lock(windowListStatsMutex_);
+    auto& stats = windowListStats_;
+
+    const UINT minInterval = minWindowListInterval_;
+    const UINT maxInterval = maxWindowListInterval_;
+    UINT interval = static_cast<UINT>(windowHandleListThreadLoop_.GetInterval().count() / 1000);
+
+    if (hasChanged || hasRequested)
+    {
+        stats.idlePassCount = 0;
+        interval = minInterval;
+    }
+    else if (++stats.idlePassCount >= kIdlePassCountToBackOff)
+    {
+        interval = interval * 2;
     }
+    interval = std::clamp(interval, minInterval, maxInterval);
+    windowHandleListThreadLoop_.SetInterval(std::chrono::milliseconds(interval));
+
+    const float passTimeMs = passTime.count() / 1000.f;
+    stats.averagePassTime = (stats.passCount == 0) ? 
+        passTimeMs : 
+        stats.averagePassTime + (passTimeMs - stats.averagePassTime) * kPassTimeSmoothing;
+    stats.maxPassTime = max(stats.maxPassTime, passTimeMs);
+    stats.lastPassTime = passTimeMs;
+    stats.interval = static_cast<float>(interval);
+    stats.addedCount = addedCountInPass_;
+    stats.removedCount = removedCountInPass_;
+    stats.changedCount = changedCountInPass_;
+    ++stats.passCount;
+
+    addedCountInPass_ = 0;
+    removedCountInPass_ = 0;
+    changedCountInPass_ = 0;
 }
 
 
 void WindowManager::RenderWindows()
 {
-    std::scoped_lock lock(windowsListMutex_);
+    if (captureManager_)
+    {
+        captureManager_->ReleaseCaptureGroups();
+    }
+
+    const auto windows = GetWindows();
+    if (!windows) return;
 
-    for (auto&& pair : windows_)
+    for (const auto& window : *windows)
     {
-        pair.second->Render();
+        window->Render();
     }
 }
\ No newline at end of file
@@ -2,21 +2,58 @@
 
 #include <Windows.h>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <deque>
 #include <memory>
 #include <mutex>
+#include <atomic>
+#include <chrono>
 
 #include "Singleton.h"
 #include "Thread.h"
+#include "ProfiledMutex.h"
 #include "CaptureManager.h"
 #include "UploadManager.h"
+#include "MetadataManager.h"
 #include "WindowsGraphicsCapture.h"
 #include "Window.h"
 #include "Cursor.h"
+#include "Message.h"
+#include "WindowSpatialIndex.h"
+#include "WindowSlotMap.h"
+#include "SnapshotTable.h"
+#include "WindowList.h"
+#include "DesktopCompositor.h"
+#include "Win32WindowBackend.h"
+#include "SyntheticWindowBackend.h"
+#include "Util.h"
 
 
-class WindowManager
+struct WindowListStats
+{
+    UINT passCount;
+    UINT idlePassCount;
+    UINT addedCount;
+    UINT removedCount;
+    UINT changedCount;
+    float interval;
+    float lastPassTime;
+    float averagePassTime;
+    float maxPassTime;
+};
+
+
+struct IdleReleaseStats
+{
+    UINT releaseCount;
+    UINT textureReleaseCount;
+    UINT64 releasedBytes;
+};
+
+
+class WindowManager : private WindowList::Listener
 {
     UWC_SINGLETON(WindowManager)
 
@@ -28,36 +65,101 @@ public:
     bool CheckExistence(int id) const;
     std::shared_ptr<Window> GetWindow(int id) const;
     std::shared_ptr<Window> GetWindowFromPoint(POINT point) const;
+    void GetWindowIdsFromPoints(const POINT* points, int* outIds, int count) const;
     std::shared_ptr<Window> GetCursorWindow() const;
+    bool ComposeVirtualDesktop();
+    const DesktopCompositor& GetVirtualDesktopCompositor() const { return virtualDesktopCompositor_; }
+    void SetWindowTextureIdleTimeout(UINT milliseconds);
+    void SetCaptureLeaseDuration(UINT milliseconds);
+    IdleReleaseStats GetIdleReleaseStats() const;
+    void SetWindowListIntervalRange(UINT minMilliseconds, UINT maxMilliseconds);
+    void RequestWindowListUpdate();
+    WindowListStats GetWindowListStats() const;
+    void SetSyntheticWindowSettings(const SyntheticWindowSettings& settings);
+    void SetHeadless(bool isHeadless);
 
+    static bool IsHeadless();
+    static const std::unique_ptr<WindowBackend>& GetWindowBackend();
     static const std::unique_ptr<CaptureManager>& GetCaptureManager();
     static const std::unique_ptr<UploadManager>& GetUploadManager();
+    static const std::unique_ptr<MetadataManager>& GetMetadataManager();
     static const std::unique_ptr<WindowsGraphicsCaptureManager>& GetWindowsGraphicsCaptureManager();
     static const std::unique_ptr<Cursor>& GetCursor();
 
 private:
-    std::shared_ptr<Window> FindParentWindow(const std::shared_ptr<Window>& window) const;
-    std::shared_ptr<Window> FindOrAddWindow(const Window::Data1 &data);
+    using WindowMap = WindowSlotMap;
+    using WindowTable = SnapshotTable<std::shared_ptr<Window>>;
+
+    bool OnWindowAdding(WindowList::Node& node) override;
+    void OnWindowAdded(const WindowList::Node& node) override;
+    void OnWindowUpdated(const WindowList::Node& node, const WindowData& previousData, bool hasOrderChanged) override;
+    void OnWindowRemoved(const WindowList::Node& node) override;
+    void InitWindow(const std::shared_ptr<Window>& window);
+    void UpdateWindowState(const std::shared_ptr<Window>& window);
 
     void StartWindowHandleListThread();
     void StopWindowHandleListThread();
     void UpdateWindowHandleList();
     void UpdateWindows();
+    void PublishWindows();
+    std::shared_ptr<const WindowTable::Snapshot> GetWindows() const;
+    void UpdateSpatialIndex();
+    void UpdateVisibility(const WindowSpatialIndex& index, const std::vector<RECT>& monitors);
+    void UpdateCursorWindow();
+    void UpdateWindowListInterval(std::chrono::microseconds passTime);
     void RenderWindows();
 
+    std::unique_ptr<WindowBackend> windowBackend_;
     std::unique_ptr<CaptureManager> captureManager_;
     std::unique_ptr<UploadManager> uploadManager_;
+    std::unique_ptr<MetadataManager> metadataManager_;
     std::unique_ptr<WindowsGraphicsCaptureManager> windowsGraphicsCaptureManager_;
     std::unique_ptr<Cursor> cursor_;
 
-    std::map<int, std::shared_ptr<Window>> windows_;
-    int lastWindowId_ = 0;
+    // windows_ is owned by the window handle list thread and mirrored into windowTable_ by slot index,
+    // which publishes it to other threads as immutable versions. Old versions are released when their last reader drops them.
+    WindowMap windows_;
+    WindowTable windowTable_;
+    bool hasWindowListChanged_ = false;
+    WindowList windowList_;
     std::weak_ptr<Window> cursorWindow_;
-    mutable std::mutex windowsListMutex_;
+
+    // Messages and requests are sent after the new list is published
+    // so that the host and other threads can access the windows as soon as they receive them.
+    std::vector<Message> messagesInPass_;
+    std::vector<int> metadataRequestsInPass_;
+
+    std::shared_ptr<const WindowSpatialIndex> spatialIndex_;
+
+    // Owned by the main thread.
+    DesktopCompositor virtualDesktopCompositor_;
+    bool isSpatialIndexDirty_ = true;
+
+    std::atomic<UINT> windowTextureIdleTimeout_;
+    std::atomic<UINT> captureLeaseDuration_;
+    std::atomic<UINT> idleReleaseCount_ = 0;
+    std::atomic<UINT> idleTextureReleaseCount_ = 0;
+    std::atomic<UINT64> idleReleasedBytes_ = 0;
+    std::chrono::steady_clock::time_point initializedTime_;
+    bool hasFirstWindowListPublished_ = false;
+
+    // The enumeration interval grows while nothing changes and is reset on any change.
+    std::atomic<UINT> minWindowListInterval_;
+    std::atomic<UINT> maxWindowListInterval_;
+    std::atomic<bool> hasWindowListUpdateRequested_ = false;
+    UINT addedCountInPass_ = 0;
+    UINT removedCountInPass_ = 0;
+    UINT changedCountInPass_ = 0;
+    WindowListStats windowListStats_ = {};
+    mutable std::mutex windowListStatsMutex_;
 
     ThreadLoop windowHandleListThreadLoop_ = { L"uWindowCapture - Window Handle List Thread" };
 
     std::vector<Window::Data1> windowDataList_[2];
-    mutable std::mutex windowsDataListMutex_;
+    mutable ProfiledMutex windowsDataListMutex_ { "WindowManager::windowsDataListMutex_" };
+    SyntheticWindowSettings syntheticWindowSettings_ = {};
+
+    // Captures only into the CPU buffers; no graphics device, upload or render stage is created.
+    bool isHeadless_ = false;
 };
 
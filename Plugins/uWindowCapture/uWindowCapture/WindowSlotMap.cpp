@@ -0,0 +1,133 @@
+#include "WindowSlotMap.h"
+#include "Debug.h"
+
+
+
+namespace
+{
+    constexpr int kIndexBits = 16;
+    constexpr UINT kIndexMask = (1u << kIndexBits) - 1;
+    constexpr UINT kGenerationMask = 0x7FFF; // keeps ids positive
+    constexpr size_t kMaxSlotCount = kIndexMask + 1;
+
+    int MakeId(UINT index, UINT generation)
+    {
+        return static_cast<int>(((generation & kGenerationMask) << kIndexBits) | index);
+    }
+}
+
+
+// ---
+
+
+std::shared_ptr<Window> WindowSlotMap::Add(const Window::Data1& data)
+{
+    UINT index;
+    if (!freeSlots_.empty())
+    {
+        // Reuse the slot freed first so that the same id comes back as late as possible.
+        index = freeSlots_.front();
+        freeSlots_.pop_front();
+    }
+    else if (slots_.size() < kMaxSlotCount)
+    {
+        index = static_cast<UINT>(slots_.size());
+        slots_.emplace_back();
+    }
+    else
+    {
+        Debug::Error(__FUNCTION__, " => No free slot.");
+        return nullptr;
+    }
+
+    auto& slot = slots_[index];
+    slot.denseIndex = static_cast<UINT>(windows_.size());
+    slot.isUsed = true;
+
+    auto window = std::make_shared<Window>(MakeId(index, slot.generation), data);
+    windows_.push_back(window);
+    denseToSlot_.push_back(index);
+
+    return window;
+}
+
+
+bool WindowSlotMap::Remove(int id)
+{
+    if (!GetSlot(id)) return false;
+
+    const UINT index = static_cast<UINT>(id) & kIndexMask;
+    auto& slot = slots_[index];
+
+    // Move the last window into the hole to keep the windows packed.
+    const UINT lastDenseIndex = static_cast<UINT>(windows_.size() - 1);
+    if (slot.denseIndex != lastDenseIndex)
+    {
+        const UINT lastIndex = denseToSlot_[lastDenseIndex];
+        windows_[slot.denseIndex] = std::move(windows_[lastDenseIndex]);
+        denseToSlot_[slot.denseIndex] = lastIndex;
+        slots_[lastIndex].denseIndex = slot.denseIndex;
+    }
+    windows_.pop_back();
+    denseToSlot_.pop_back();
+
+    slot.generation = (slot.generation + 1) & kGenerationMask;
+    slot.isUsed = false;
+    freeSlots_.push_back(index);
+
+    return true;
+}
+
+
+bool WindowSlotMap::Contains(int id) const
+{
+    return GetSlot(id) != nullptr;
+}
+
+
+std::shared_ptr<Window> WindowSlotMap::Find(int id) const
+{
+    if (const auto slot = GetSlot(id))
+    {
+        return windows_[slot->denseIndex];
+    }
+    return nullptr;
+}
+
+
+void WindowSlotMap::Clear()
+{
+    // Generations are kept to invalidate the ids given so far.
+    for (UINT index = 0; index < slots_.size(); ++index)
+    {
+        auto& slot = slots_[index];
+        if (slot.isUsed)
+        {
+            slot.generation = (slot.generation + 1) & kGenerationMask;
+            slot.isUsed = false;
+            freeSlots_.push_back(index);
+        }
+    }
+    windows_.clear();
+    denseToSlot_.clear();
+}
+
+
+UINT WindowSlotMap::GetIndex(int id)
+{
+    return static_cast<UINT>(id) & kIndexMask;
+}
+
+
+const WindowSlotMap::Slot* WindowSlotMap::GetSlot(int id) const
+{
+    if (id < 0) return nullptr;
+
+    const UINT index = GetIndex(id);
+    if (index >= slots_.size()) return nullptr;
+
+    const auto& slot = slots_[index];
+    if (!slot.isUsed || MakeId(index, slot.generation) != id) return nullptr;
+
+    return &slot;
+}
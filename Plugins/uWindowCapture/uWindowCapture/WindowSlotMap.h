@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Windows.h>
+#include <vector>
+#include <deque>
+#include <memory>
+#include "Window.h"
+
+
+// Dense storage of windows addressed by generational ids.
+// An id packs the slot index in the lower bits and the slot generation in the upper bits,
+// so that the id of a removed window never resolves to a window which reuses its slot.
+class WindowSlotMap
+{
+public:
+    using Container = std::vector<std::shared_ptr<Window>>;
+
+    std::shared_ptr<Window> Add(const Window::Data1& data);
+    bool Remove(int id);
+    bool Contains(int id) const;
+    std::shared_ptr<Window> Find(int id) const;
+    void Clear();
+
+    // Index of the slot of the id, which is unique among the windows alive at the same time.
+    static UINT GetIndex(int id);
+
+    size_t GetSize() const { return windows_.size(); }
+    bool IsEmpty() const { return windows_.empty(); }
+    Container::const_iterator begin() const { return windows_.begin(); }
+    Container::const_iterator end() const { return windows_.end(); }
+
+private:
+    struct Slot
+    {
+        UINT generation = 0;
+        UINT denseIndex = 0;
+        bool isUsed = false;
+    };
+
+    const Slot* GetSlot(int id) const;
+
+    std::vector<Slot> slots_;
+    std::deque<UINT> freeSlots_;
+    Container windows_;
+    std::vector<UINT> denseToSlot_;
+};
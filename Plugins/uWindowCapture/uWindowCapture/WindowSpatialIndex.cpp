@@ -0,0 +1,158 @@
+#include <algorithm>
+#include "WindowSpatialIndex.h"
+
+
+
+namespace
+{
+    constexpr LONG kCellSize = 256;
+    constexpr int kMaxCellCountPerAxis = 16;
+
+    bool Contains(const RECT& rect, POINT point)
+    {
+        return 
+            point.x >= rect.left && point.x < rect.right &&
+            point.y >= rect.top && point.y < rect.bottom;
+    }
+}
+
+
+// ---
+
+
+void WindowSpatialIndex::Build(const RECT& bounds, std::vector<Entry>&& entries)
+{
+    entries_ = std::move(entries);
+
+    // Sort from the top so that the first hit in a cell is the topmost one.
+    std::stable_sort(
+        entries_.begin(),
+        entries_.end(),
+        [](const Entry& a, const Entry& b)
+        {
+            return a.zOrder < b.zOrder;
+        });
+
+    bounds_ = bounds;
+    const LONG width = bounds_.right - bounds_.left;
+    const LONG height = bounds_.bottom - bounds_.top;
+    if (width <= 0 || height <= 0)
+    {
+        cols_ = rows_ = 0;
+        cells_.clear();
+        return;
+    }
+
+    cols_ = std::clamp(static_cast<int>((width + kCellSize - 1) / kCellSize), 1, kMaxCellCountPerAxis);
+    rows_ = std::clamp(static_cast<int>((height + kCellSize - 1) / kCellSize), 1, kMaxCellCountPerAxis);
+    cellWidth_ = (width + cols_ - 1) / cols_;
+    cellHeight_ = (height + rows_ - 1) / rows_;
+
+    // Reuse the cell buffers since the layout rarely changes.
+    cells_.resize(cols_ * rows_);
+    for (auto& cell : cells_)
+    {
+        cell.clear();
+    }
+
+    for (UINT i = 0; i < entries_.size(); ++i)
+    {
+        RECT range;
+        if (!GetCellRange(entries_[i].rect, range)) continue;
+
+        for (LONG row = range.top; row <= range.bottom; ++row)
+        {
+            for (LONG col = range.left; col <= range.right; ++col)
+            {
+                cells_[row * cols_ + col].push_back(i);
+            }
+        }
+    }
+}
+
+
+bool WindowSpatialIndex::GetCellRange(const RECT& rect, RECT& outRange) const
+{
+    if (cells_.empty()) return false;
+
+    const LONG left = max(rect.left, bounds_.left);
+    const LONG top = max(rect.top, bounds_.top);
+    const LONG right = min(rect.right, bounds_.right);
+    const LONG bottom = min(rect.bottom, bounds_.bottom);
+    if (left >= right || top >= bottom) return false;
+
+    // Inclusive range of the columns and rows.
+    outRange.left = (left - bounds_.left) / cellWidth_;
+    outRange.right = (right - 1 - bounds_.left) / cellWidth_;
+    outRange.top = (top - bounds_.top) / cellHeight_;
+    outRange.bottom = (bottom - 1 - bounds_.top) / cellHeight_;
+    return true;
+}
+
+
+const std::vector<UINT>* WindowSpatialIndex::GetCell(POINT point) const
+{
+    if (cells_.empty() || !Contains(bounds_, point)) return nullptr;
+
+    const int col = (point.x - bounds_.left) / cellWidth_;
+    const int row = (point.y - bounds_.top) / cellHeight_;
+    return &cells_[row * cols_ + col];
+}
+
+
+int WindowSpatialIndex::Find(POINT point) const
+{
+    const auto* cell = GetCell(point);
+    if (!cell) return -1;
+
+    for (const auto i : *cell)
+    {
+        const auto& entry = entries_[i];
+        if (Contains(entry.rect, point))
+        {
+            return entry.id;
+        }
+    }
+
+    return -1;
+}
+
+
+void WindowSpatialIndex::Find(const POINT* points, int* outIds, int count) const
+{
+    for (int i = 0; i < count; ++i)
+    {
+        outIds[i] = Find(points[i]);
+    }
+}
+
+
+void WindowSpatialIndex::FindOccluders(const RECT& rect, UINT zOrder, std::vector<RECT>& outRects) const
+{
+    outRects.clear();
+
+    RECT range;
+    if (!GetCellRange(rect, range)) return;
+
+    // Entries are sorted from the top, so the indices give the occluders from the top as well.
+    std::vector<UINT> indices;
+    for (LONG row = range.top; row <= range.bottom; ++row)
+    {
+        for (LONG col = range.left; col <= range.right; ++col)
+        {
+            for (const auto i : cells_[row * cols_ + col])
+            {
+                if (entries_[i].zOrder >= zOrder) break;
+                indices.push_back(i);
+            }
+        }
+    }
+
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    for (const auto i : indices)
+    {
+        outRects.push_back(entries_[i].rect);
+    }
+}
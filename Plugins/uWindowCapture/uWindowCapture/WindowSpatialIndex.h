@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Platform.h"
+#include <vector>
+
+
+// Uniform grid over the virtual screen to find the topmost window which contains a point.
+class WindowSpatialIndex
+{
+public:
+    struct Entry
+    {
+        int id;
+        UINT zOrder;
+        RECT rect;
+    };
+
+    void Build(const RECT& bounds, std::vector<Entry>&& entries);
+    int Find(POINT point) const;
+    void Find(const POINT* points, int* outIds, int count) const;
+    void FindOccluders(const RECT& rect, UINT zOrder, std::vector<RECT>& outRects) const;
+    const RECT& GetBounds() const { return bounds_; }
+
+private:
+    const std::vector<UINT>* GetCell(POINT point) const;
+    bool GetCellRange(const RECT& rect, RECT& outRange) const;
+
+    RECT bounds_ = {};
+    LONG cellWidth_ = 1;
+    LONG cellHeight_ = 1;
+    int cols_ = 0;
+    int rows_ = 0;
+    std::vector<Entry> entries_;
+    std::vector<std::vector<UINT>> cells_;
+};
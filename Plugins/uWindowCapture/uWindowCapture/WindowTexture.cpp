@@ -7,15 +7,31 @@
 #include "Message.h"
 #include "Unity.h"
 #include "Debug.h"
+#include "PixelKernel.h"
 #include "Util.h"
 
 using namespace Microsoft::WRL;
 
 
 
+namespace
+{
+    // Shared by all instances so that a recreated texture never repeats a version.
+    std::atomic<UINT64> g_bufferVersion = 0;
+}
+
+
+// ---
+
+
 WindowTexture::WindowTexture(Window* window)
     : window_(window)
 {
+    if (const auto& backend = WindowManager::GetWindowBackend())
+    {
+        if (backend->HasFrames()) return;
+    }
+
     if (const auto& wgcManager = WindowManager::GetWindowsGraphicsCaptureManager())
     {
         if (window_->IsDesktop())
@@ -32,7 +48,7 @@ WindowTexture::WindowTexture(Window* window)
 
 WindowTexture::~WindowTexture()
 {
-    std::lock_guard<std::mutex> lock(bufferMutex_);
+    std::lock_guard<ProfiledMutex> lock(bufferMutex_);
     DeleteBitmap();
 
     if (auto wgc = windowsGraphicsCapture_.lock())
@@ -141,9 +157,10 @@ UINT WindowTexture::GetOffsetY() const
 
 void WindowTexture::CreateBitmapIfNeeded(HDC hDc, UINT width, UINT height)
 {
-    std::lock_guard<std::mutex> lock(bufferMutex_);
+    std::lock_guard<ProfiledMutex> lock(bufferMutex_);
 
-    if (bufferWidth_ == width && bufferHeight_ == height) return;
+    const bool hasSizeChanged = bufferWidth_ != width || bufferHeight_ != height;
+    if (bitmap_ && !hasSizeChanged) return;
     if (width == 0 || height == 0) return;
 
     bufferWidth_ = width;
@@ -153,7 +170,11 @@ void WindowTexture::CreateBitmapIfNeeded(HDC hDc, UINT width, UINT height)
     DeleteBitmap();
     bitmap_ = ::CreateCompatibleBitmap(hDc, width, height);
 
-    SetUnityTexturePtr(nullptr);
+    // Buffers recreated after ReleaseResources() keep the texture of the host.
+    if (hasSizeChanged)
+    {
+        SetUnityTexturePtr(nullptr);
+    }
 }
 
 
@@ -167,6 +188,13 @@ void WindowTexture::DeleteBitmap()
 }
 
 
+bool WindowTexture::CanCaptureBlock() const
+{
+    // Only PrintWindow() waits for the thread of the window, which may hang.
+    return GetCaptureModeInternal() == CaptureMode::PrintWindow;
+}
+
+
 bool WindowTexture::IsWindowsGraphicsCapture() const
 {
     return GetCaptureModeInternal() == CaptureMode::WindowsGraphicsCapture;
@@ -181,13 +209,47 @@ std::shared_ptr<WindowsGraphicsCapture> WindowTexture::GetWindowsGraphicsCapture
 
 bool WindowTexture::Capture()
 {
-    if (IsWindowsGraphicsCapture())
+    std::lock_guard<ProfiledMutex> lock(captureMutex_);
+
+    const auto startTime = FrameLatencyTracker::GetTime();
+    if (!CaptureByCurrentMode()) return false;
+
+    frameLatencyTracker_.OnCaptured(startTime, GetWidth(), GetHeight());
+    return true;
+}
+
+
+bool WindowTexture::CaptureByCurrentMode()
+{
+    if (const auto& backend = WindowManager::GetWindowBackend())
     {
-        return CaptureByWindowsGraphicsCapture();
+        if (backend->HasFrames())
+        {
+            return CaptureByWindowBackend(*backend);
+        }
     }
-    else
+
+    switch (GetCaptureModeInternal())
     {
-        return CaptureByWin32API();
+        case CaptureMode::WindowsGraphicsCapture:
+        {
+            UWC_STAGE_TIMER(CaptureByWindowsGraphicsCapture, &latencyHistograms_)
+            return CaptureByWindowsGraphicsCapture();
+        }
+        case CaptureMode::PrintWindow:
+        {
+            UWC_STAGE_TIMER(CaptureByPrintWindow, &latencyHistograms_)
+            return CaptureByWin32API();
+        }
+        case CaptureMode::BitBlt:
+        {
+            UWC_STAGE_TIMER(CaptureByBitBlt, &latencyHistograms_)
+            return CaptureByWin32API();
+        }
+        default:
+        {
+            return CaptureByWin32API();
+        }
     }
 }
     
@@ -358,13 +420,16 @@ bool WindowTexture::CaptureByWin32API()
     bmi.biSizeImage   = 0;
 
     {
-        std::lock_guard<std::mutex> lock(bufferMutex_);
+        std::lock_guard<ProfiledMutex> lock(bufferMutex_);
+        UWC_STAGE_TIMER(GetDIBits, &latencyHistograms_)
 
         if (!::GetDIBits(hDcMem, bitmap_, 0, bufferHeight_, buffer_.Get(), reinterpret_cast<BITMAPINFO*>(&bmi), DIB_RGB_COLORS))
         {
             OutputApiError(__FUNCTION__, "GetDIBits");
             return false;
         }
+
+        bufferVersion_ = ++g_bufferVersion;
     }
 
     return true;
@@ -426,6 +491,34 @@ void WindowTexture::DrawCursorByWin32API(HWND hWnd, HDC hDcMem)
 }
 
 
+bool WindowTexture::CaptureByWindowBackend(WindowBackend& backend)
+{
+    std::lock_guard<ProfiledMutex> lock(bufferMutex_);
+
+    UINT width = 0;
+    UINT height = 0;
+    if (!backend.CaptureFrame(window_->GetWindowHandle(), buffer_, width, height))
+    {
+        return false;
+    }
+
+    if (bufferWidth_ != width || bufferHeight_ != height)
+    {
+        bufferWidth_ = width;
+        bufferHeight_ = height;
+        SetUnityTexturePtr(nullptr);
+    }
+
+    textureWidth_ = width;
+    textureHeight_ = height;
+    offsetX_ = 0;
+    offsetY_ = 0;
+    bufferVersion_ = ++g_bufferVersion;
+
+    return true;
+}
+
+
 bool WindowTexture::CaptureByWindowsGraphicsCapture()
 {
     auto wgc = windowsGraphicsCapture_.lock();
@@ -450,16 +543,20 @@ bool WindowTexture::CaptureByWindowsGraphicsCapture()
 
 bool WindowTexture::Upload()
 {
+    UWC_STAGE_TIMER(Upload, &latencyHistograms_)
+
     if (!RecreateSharedTextureIfNeeded()) return false;
 
-    if (IsWindowsGraphicsCapture())
-    {
-        return UploadByWindowsGraphicsCapture();
-    }
-    else
+    const bool result = IsWindowsGraphicsCapture() ?
+        UploadByWindowsGraphicsCapture() :
+        UploadByWin32API();
+
+    if (result)
     {
-        return UploadByWin32API();
+        frameLatencyTracker_.OnUploaded();
     }
+
+    return result;
 }
 
 
@@ -499,7 +596,7 @@ bool WindowTexture::RecreateSharedTextureIfNeeded()
 
     bool shouldUpdateTexture = true;
 
-    std::lock_guard<std::mutex> lock(sharedTextureMutex_);
+    std::lock_guard<ProfiledMutex> lock(sharedTextureMutex_);
 
     if (sharedTexture_)
     {
@@ -542,17 +639,22 @@ bool WindowTexture::UploadByWin32API()
 {
     UWC_SCOPE_TIMER(UploadByWin32API)
 
-    std::lock_guard<std::mutex> lock(bufferMutex_);
+    std::lock_guard<ProfiledMutex> lock(bufferMutex_);
 
     const auto& uploader = WindowManager::GetUploadManager();
     if (!uploader) return false;
 
+    // The buffer may have been released by ReleaseResources() after the shared texture was checked.
+    if (!buffer_) return false;
+
     const UINT rawPitch = bufferWidth_ * 4;
     const int startIndex = offsetX_ * 4 + offsetY_ * rawPitch;
     const auto* start = buffer_.Get(startIndex);
 
     {
-        std::lock_guard<std::mutex> lock(sharedTextureMutex_);
+        std::lock_guard<ProfiledMutex> lock(sharedTextureMutex_);
+        if (!sharedTexture_) return false;
+
         ComPtr<ID3D11DeviceContext> context;
         uploader->GetDevice()->GetImmediateContext(&context);
         context->UpdateSubresource(sharedTexture_.Get(), 0, nullptr, start, rawPitch, 0);
@@ -579,7 +681,9 @@ bool WindowTexture::UploadByWindowsGraphicsCapture()
 
     try
     {
-        std::lock_guard<std::mutex> lock(sharedTextureMutex_);
+        std::lock_guard<ProfiledMutex> lock(sharedTextureMutex_);
+        if (!sharedTexture_) return false;
+
         ComPtr<ID3D11DeviceContext> context;
         uploader->GetDevice()->GetImmediateContext(&context);
         context->CopyResource(sharedTexture_.Get(), result.pTexture);
@@ -604,11 +708,14 @@ bool WindowTexture::UploadByWindowsGraphicsCapture()
 
 bool WindowTexture::Render()
 {
-    if (!unityTexture_.load() || !sharedTexture_ || !sharedHandle_) return false;
+    if (!unityTexture_.load()) return false;
 
     UWC_SCOPE_TIMER(Render)
+    UWC_STAGE_TIMER(Render, &latencyHistograms_)
+
+    std::lock_guard<ProfiledMutex> lock(sharedTextureMutex_);
 
-    std::lock_guard<std::mutex> lock(sharedTextureMutex_);
+    if (!sharedTexture_ || !sharedHandle_) return false;
 
     ComPtr<ID3D11DeviceContext> context;
     GetUnityDevice()->GetImmediateContext(&context);
@@ -629,25 +736,14 @@ bool WindowTexture::Render()
         Debug::Error(__FUNCTION__, " => CopyResource() threw an exception.");
     }
 
+    frameLatencyTracker_.OnRendered();
+
     MessageManager::Get().Add({ MessageType::WindowCaptured, window_->GetId(), window_->GetWindowHandle() });
 
     return true;
 }
 
 
-BYTE* WindowTexture::GetBuffer()
-{
-    if (buffer_.Empty()) return nullptr;
-
-    std::lock_guard<std::mutex> lock(bufferMutex_);
-
-    bufferForGetBuffer_.ExpandIfNeeded(buffer_.Size());
-    memcpy(bufferForGetBuffer_.Get(), buffer_.Get(), buffer_.Size());
-
-    return bufferForGetBuffer_.Get();
-}
-
-
 UINT WindowTexture::GetPixel(int x, int y) const
 {
     BYTE output[4];
@@ -661,40 +757,46 @@ UINT WindowTexture::GetPixel(int x, int y) const
 
 bool WindowTexture::GetPixels(BYTE* output, int x, int y, int width, int height) const
 {
+    std::lock_guard<ProfiledMutex> lock(bufferMutex_);
+
+    int bufferWidth = bufferWidth_.load();
+    int bufferHeight = bufferHeight_.load();
+
     if (!buffer_)
     {
-        Debug::Error("WindowTexture::GetPixels() => buffer has not been set yet.");
+        // ReleaseResources() keeps the size, and the buffer is allocated again by the next capture.
+        if (bufferWidth == 0 || bufferHeight == 0)
+        {
+            Debug::Error("WindowTexture::GetPixels() => buffer has not been set yet.");
+        }
         return false;
     }
 
-    int bufferWidth = bufferWidth_.load();
-    int bufferHeight = bufferHeight_.load();
     if (x < 0 || x + width >= bufferWidth || y < 0 || y + height >= bufferHeight)
     {
         Debug::Error("The given range is out of the buffer area: x=", x, ", y=", y, ", width=", width, ", height=", height);
-        Debug::Error("The buffer width=", bufferWidth_, ", height=", bufferHeight_);
+        Debug::Error("The buffer width=", bufferWidth, ", height=", bufferHeight);
         return false;
     }
 
-    std::lock_guard<std::mutex> lock(bufferMutex_);
+    UWC_STAGE_TIMER(GetPixels, &latencyHistograms_)
 
     constexpr int rgba = 4;
-    for (int j = 0; j < height; ++j)
-    {
-        for (int i = 0; i < width; ++i)
-        {
-            for (int c = 0; c < rgba; ++c)
-            {
-                const int indexOut = i + j * width;
-                const int indexIn = (x + i) + (y + (height - 1 - j)) * bufferWidth_;
-                output[indexOut * rgba + 0] = buffer_[indexIn * rgba + 2];
-                output[indexOut * rgba + 1] = buffer_[indexIn * rgba + 1];
-                output[indexOut * rgba + 2] = buffer_[indexIn * rgba + 0];
-                output[indexOut * rgba + 3] = buffer_[indexIn * rgba + 3];
-            }
-        }
-    }
+    const UINT pitch = bufferWidth * rgba;
+    const auto* start = buffer_.Get((x + y * bufferWidth) * rgba);
+    CopyBgraToRgbaFlipped(start, pitch, output, static_cast<UINT>(width), static_cast<UINT>(height));
+
+    return true;
+}
+
+
+bool WindowTexture::ReadBuffer(const BufferReader& reader) const
+{
+    std::lock_guard<ProfiledMutex> lock(bufferMutex_);
 
+    if (!buffer_ || bufferWidth_ == 0 || bufferHeight_ == 0) return false;
+
+    reader(buffer_.Get(), bufferWidth_, bufferHeight_);
     return true;
 }
 
@@ -704,3 +806,43 @@ bool WindowTexture::IsWindowsGraphicsCaptureAvailable() const
     auto wgc = windowsGraphicsCapture_.lock();
     return wgc && wgc->IsAvailable();
 }
+
+
+UINT64 WindowTexture::ReleaseResources()
+{
+    // Retry later if a capture is running since it draws into the bitmap outside the buffer lock.
+    std::unique_lock<ProfiledMutex> captureLock(captureMutex_, std::try_to_lock);
+    if (!captureLock) return 0;
+
+    UINT64 releasedBytes = 0;
+
+    {
+        std::lock_guard<ProfiledMutex> lock(bufferMutex_);
+
+        if (bitmap_)
+        {
+            releasedBytes += static_cast<UINT64>(bufferWidth_) * bufferHeight_ * 4;
+            DeleteBitmap();
+        }
+        releasedBytes += buffer_.Size();
+        buffer_.Reset();
+
+        // The sizes, the offsets and the texture of the host are kept, so that the next capture
+        // allocates the buffers again without asking the host to recreate its texture.
+    }
+
+    {
+        std::lock_guard<ProfiledMutex> lock(sharedTextureMutex_);
+
+        if (sharedTexture_)
+        {
+            D3D11_TEXTURE2D_DESC desc;
+            sharedTexture_->GetDesc(&desc);
+            releasedBytes += static_cast<UINT64>(desc.Width) * desc.Height * 4;
+            sharedTexture_.Reset();
+        }
+        sharedHandle_ = nullptr;
+    }
+
+    return releasedBytes;
+}
@@ -3,10 +3,14 @@
 #include <Windows.h>
 #include <d3d11.h>
 #include <wrl/client.h>
+#include <functional>
 #include <mutex>
 #include <atomic>
 
 #include "Buffer.h"
+#include "ProfiledMutex.h"
+#include "LatencyHistogram.h"
+#include "FrameLatencyTracker.h"
 
 
 enum class CaptureMode
@@ -21,6 +25,7 @@ enum class CaptureMode
 
 class Window;
 class WindowsGraphicsCapture;
+class WindowBackend;
 
 
 class WindowTexture
@@ -34,6 +39,7 @@ public:
 
     void SetCaptureMode(CaptureMode mode);
     CaptureMode GetCaptureMode() const;
+    bool CanCaptureBlock() const;
 
     void SetCursorDraw(bool draw);
     bool GetCursorDraw() const;
@@ -47,21 +53,30 @@ public:
     bool Upload();
     bool Render();
 
-    BYTE* GetBuffer();
-
     UINT GetPixel(int x, int y) const;
     bool GetPixels(BYTE* output, int x, int y, int width, int height) const;
 
+    using BufferReader = std::function<void(const BYTE* pixels, UINT width, UINT height)>;
+    bool ReadBuffer(const BufferReader& reader) const;
+    UINT64 GetBufferVersion() const { return bufferVersion_; }
+
     bool IsWindowsGraphicsCaptureAvailable() const;
     std::shared_ptr<WindowsGraphicsCapture> GetWindowsGraphicsCapture() const;
 
+    UINT64 ReleaseResources();
+
+    LatencyStats GetLatencyStats(PipelineStage stage) const { return latencyHistograms_.GetStats(stage); }
+    FrameLatencyStats GetFrameLatencyStats() const { return frameLatencyTracker_.GetStats(); }
+
 private:
     CaptureMode GetCaptureModeInternal() const;
     bool IsWindowsGraphicsCapture() const;
+    bool CaptureByCurrentMode();
     bool CaptureByWin32API();
     void CreateBitmapIfNeeded(HDC hDc, UINT width, UINT height);
     void DeleteBitmap();
     void DrawCursorByWin32API(HWND hWnd, HDC hDcMem);
+    bool CaptureByWindowBackend(WindowBackend& backend);
     bool CaptureByWindowsGraphicsCapture();
     bool RecreateSharedTextureIfNeeded();
     bool UploadByWin32API();
@@ -75,10 +90,9 @@ private:
     std::atomic<ID3D11Texture2D*> unityTexture_ = nullptr;
     Microsoft::WRL::ComPtr<ID3D11Texture2D> sharedTexture_;
     HANDLE sharedHandle_ = nullptr;
-    std::mutex sharedTextureMutex_;
+    ProfiledMutex sharedTextureMutex_ { "WindowTexture::sharedTextureMutex_" };
 
     Buffer<BYTE> buffer_;
-    Buffer<BYTE> bufferForGetBuffer_;
     HBITMAP bitmap_ = nullptr;
     std::atomic<UINT> bufferWidth_ = 0;
     std::atomic<UINT> bufferHeight_ = 0;
@@ -86,9 +100,14 @@ private:
     std::atomic<UINT> offsetY_ = 0;
     std::atomic<UINT> textureWidth_ = 0;
     std::atomic<UINT> textureHeight_ = 0;
+    std::atomic<UINT64> bufferVersion_ = 0;
     std::atomic<bool> drawCursor_ = true;
-    mutable std::mutex bufferMutex_;
+    mutable ProfiledMutex bufferMutex_ { "WindowTexture::bufferMutex_" };
+    ProfiledMutex captureMutex_ { "WindowTexture::captureMutex_" };
 
     float dpiScaleX_ = 1.f;
     float dpiScaleY_ = 1.f;
+
+    mutable LatencyHistogramSet latencyHistograms_;
+    FrameLatencyTracker frameLatencyTracker_;
 };
\ No newline at end of file
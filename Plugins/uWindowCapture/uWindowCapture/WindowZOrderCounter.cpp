@@ -0,0 +1,29 @@
+#include "WindowZOrderCounter.h"
+
+
+
+void WindowZOrderCounter::Reset()
+{
+    hLast_ = NULL;
+    visibleCount_ = 0;
+}
+
+
+bool WindowZOrderCounter::IsNextOf(HWND hPrev) const
+{
+    return hPrev == hLast_;
+}
+
+
+UINT WindowZOrderCounter::Add(HWND hWnd, bool isVisible)
+{
+    return Add(hWnd, isVisible, visibleCount_);
+}
+
+
+UINT WindowZOrderCounter::Add(HWND hWnd, bool isVisible, UINT zOrder)
+{
+    hLast_ = hWnd;
+    visibleCount_ = isVisible ? zOrder + 1 : zOrder;
+    return zOrder;
+}
\ No newline at end of file
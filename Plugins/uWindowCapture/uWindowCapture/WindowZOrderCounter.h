@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Platform.h"
+
+
+// Counts visible windows while they are given in the front-to-back order of EnumWindows(),
+// so that the z-order (the number of visible windows above) of each one is known in one pass.
+class WindowZOrderCounter
+{
+public:
+    void Reset();
+    bool IsNextOf(HWND hPrev) const;
+    UINT Add(HWND hWnd, bool isVisible);
+    UINT Add(HWND hWnd, bool isVisible, UINT zOrder);
+
+private:
+    HWND hLast_ = NULL;
+    UINT visibleCount_ = 0;
+};
\ No newline at end of file
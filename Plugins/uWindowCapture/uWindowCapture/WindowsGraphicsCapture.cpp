@@ -418,9 +418,10 @@ const wchar_t * WindowsGraphicsCapture::GetDisplayName() const
 
 IDirect3DDevice & WindowsGraphicsCaptureManager::GetDevice()
 {
-    if (!deviceWinRt_)
+    // There is no uploader in the headless mode.
+    const auto& uploader = WindowManager::GetUploadManager();
+    if (!deviceWinRt_ && uploader)
     {
-        const auto& uploader = WindowManager::GetUploadManager();
         while (!uploader->IsReady())
         {
             const std::chrono::microseconds waitTime(100);
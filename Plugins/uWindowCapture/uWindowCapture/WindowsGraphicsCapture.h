@@ -11,6 +11,8 @@
 #include <winrt/Windows.Graphics.DirectX.Direct3D11.h>
 #include <winrt/Windows.Graphics.Capture.h>
 
+#include "ProfiledMutex.h"
+
 
 class WindowsGraphicsCapture
     : public std::enable_shared_from_this<WindowsGraphicsCapture>
@@ -63,7 +65,7 @@ private:
     winrt::Windows::Graphics::Capture::Direct3D11CaptureFrame frame_ = nullptr;
     winrt::Windows::Graphics::SizeInt32 size_ = { 0, 0 };
     mutable std::mutex itemMutex_;
-    std::mutex sessionAndPoolMutex_;
+    ProfiledMutex sessionAndPoolMutex_ { "WindowsGraphicsCapture::sessionAndPoolMutex_" };
     std::atomic<bool> isStarted_ = false;
     std::atomic<bool> isCursorCaptureEnabled_ = { true };
     std::atomic<bool> isStartRequested_ = { false };
@@ -94,7 +96,7 @@ private:
     using Ptr = std::shared_ptr<WindowsGraphicsCapture>;
     std::list<Ptr> allInstances_;
     std::list<Ptr> activeInstances_;
-    std::mutex allInstancesMutex_;
+    ProfiledMutex allInstancesMutex_ { "WindowsGraphicsCaptureManager::allInstancesMutex_" };
     std::mutex activeInstancesMutex_;
     winrt::Windows::Graphics::DirectX::Direct3D11::IDirect3DDevice deviceWinRt_ = nullptr;
 };
\ No newline at end of file